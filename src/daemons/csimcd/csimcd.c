@@ -3,13 +3,17 @@
  * The terms "read" and "write" are used wrt the tty/network connection.
  *
  * Connection management:
- *   advertise presence on current host at a certain TCP/IP port.
+ *   advertise presence on current host at a certain TCP/IP port, and at a
+ *     Unix socket named for the port for clients on this host.
  *   create 1 socket fd per client, each connecting one host/node pair.
  *   basically just pass data to/from each fd/node pair.
  *   CSIMCD_INTR from a client fd causes sending its node PT_INTR.
  *   EOF from a client fd causes sending its node KILL.
  *   opens FOR_REBOOT broadcasts PT_REBOOT to all nodes and closes all clients.
  *   anything but PT_SHELL/ACK from a node: send message to fd then close.
+ *   FOR_VARS clients send binary PT_GETVAR/PT_SETVAR requests and get back
+ *     the Data of the ACK, both escaped as on the wire, so they need not go
+ *     through the node's shell.
  *   also listen for special LOGADR packets and log those.
  *   if we die for any reason we issue a network-wide reboot.
  *
@@ -48,6 +52,8 @@
 #include "csimc.h"
 #include "configfile.h"
 #include "strops.h"
+#include "csimcstats.h"
+#include "lanring.h"
 
 #define	SPEED		B38400		/* cflag for tty speed */
 #define	MAXV		5		/* max verbose */
@@ -55,6 +61,10 @@
 
 #define	TOKWT		5000		/* ms to wait for token back */
 
+#define	LANOBUFSZ	(4*PMXLEN)	/* most LAN output to gather in 1 write */
+
+#define	CSSNODE(a)	(&css->node[(a) < NNODES ? (a) : CSS_NOADDR])
+
 typedef struct {
     int inuse : 1;			/* this info cell is in use */
     int cfdset : 1;			/* cfd is in clset */
@@ -77,13 +87,20 @@ static void reopenPty (int cfd);
 static void advanceToken (void);
 static void checkClients(void);
 static void wait4TokenBack(void);
-static void newClient();
+static void newClient(int lfd);
 static void newShell (CInfo *cip);
 static void newReboot (CInfo *cip);
 static void newBoot (CInfo *cip);
 static void newSerial (CInfo *cip, int baud);
+static void newVars (CInfo *cip);
 static int sendConfirmPing (CInfo *cip);
 static int readLANpacket(char *what, int nto, int from);
+static int lanFill (int nto);
+static void initStats (void);
+static void pollStats (void);
+static void logStats (void);
+static void flushTTY (void);
+static void onStatsSig (int dummy);
 static void rpktDispatch(void);
 
 static void initCInfo(void);
@@ -92,15 +109,15 @@ static int sendXpkt (void);
 static void buildCtrlPkt (int from, int to, PktType t);
 static void sendPkt(Byte pkt[], int retry);
 static void sendCurToken(void);
-static int chkSum (Byte p[], int n);
 static void clientMsg(int fd);
 static int buildShellXPkt (int fd);
 static int buildSerialXPkt (int fd);
 static int buildBootXPkt (int fd);
+static int buildVarXPkt (int fd);
+static int readAll (int fd, Byte *buf, int n);
 static void closecfd (int cfd);
 static void breakAllConnections (void);
 static void breakConnections (int to);
-static void dump (Byte *p, int n);
 static int pktSize (Byte pkt[]);
 static void logAddr (int fr);
 static char *p2tstr (Pkt *pktp);
@@ -121,9 +138,19 @@ static char *cfg = cfg_def;		/* config file we actually use */
 static fd_set clset;		/* each client fd. host addr = fd + MAXNA */
 static int maxclset = -1;	/* largest fd set in clset, -1 if empty */
 static int listenfd;		/* universal listening post */
+static int ulistenfd = -1;	/* same for clients on this host, if any */
 static int ttyfd;		/* tty fd once open */
 static Byte rpkt[PMXLEN];	/* packet being received from CSIMC network */
 static int rpktlen;		/* bytes in packet received so far */
+static LanRing lan;		/* bytes read from the LAN */
+static Byte lanobuf[LANOBUFSZ];	/* bytes for the LAN not yet written */
+static int nlanobuf;		/* bytes in lanobuf */
+static int lantimeout;		/* set if last readLANpacket() timed out */
+static CSIMCStats *css;		/* always-on counters, shared if we can */
+static CSIMCStats cssmine;	/* used for css if can not share */
+static double lastpoll;		/* when checkClients() last looked */
+static double prevpoll;		/* when it looked the time before that */
+static volatile int logstats;	/* set to log css from mainLoop */
 static Byte rseq[NADDR][NADDR];	/* seq of last rx packet acked, [fr][to] */
 static Byte xpkt[PMXLEN];	/* packet being transmitted to CSIMC network */
 static Byte xseq[NADDR];	/* sequence for next tx packet, per net addr. */
@@ -201,6 +228,7 @@ main (int ac, char *av[])
         /* a few signal issues */
 	signal (SIGPIPE, SIG_IGN);
 	signal (SIGHUP, onVerboseSig);
+	signal (SIGUSR1, onStatsSig);
 	signal (SIGTERM, onBye);
 	signal (SIGINT, onBye);
 	signal (SIGQUIT, onBye);
@@ -209,6 +237,7 @@ main (int ac, char *av[])
 	initCfg();
 
 	/* open tty, announce socket, init any pty's */
+	initStats();
 	openTTY();
 	announce();
 	initCInfo();
@@ -236,6 +265,7 @@ usage (char *me)
 	fprintf (stderr, " -m      allow multiple instances for multiple LANs\n");
 	fprintf (stderr, " -t tty  alternate <tty>. default is %s\n", tty_def);
 	fprintf (stderr, " -v      verbose; up to %d; SIGHUP also bumps\n", MAXV);
+	fprintf (stderr, "         SIGUSR1 logs LAN traffic and errors per node\n");
 	fprintf (stderr, "           0: always show errors..\n");
 	fprintf (stderr, "           1: plus basic actions..\n");
 	fprintf (stderr, "           2: plus packet contents.. \n");
@@ -346,6 +376,8 @@ openPty (char pty[], int toaddr, int baud)
 	cip->cfd = cfd;
 	cip->toaddr = toaddr;
 	cip->why = FOR_SERIAL;
+	css->host[cip-cinfo].toaddr = toaddr;
+	css->host[cip-cinfo].why = FOR_SERIAL;
 	rseq[toaddr][CFD2HA(cfd)] = -1;
 	livenodes[toaddr] = 1;	/* insure it gets a token */
 	if (sendBaud (cfd, baud) < 0)
@@ -522,6 +554,14 @@ announce()
 
 	daemonLog ("Listening for CSIMC clients on port %d with fd %d\n", port,
 								    listenfd);
+
+	/* local clients skip TCP/IP if they can. ok if not. */
+	ulistenfd = csimcd_ulisten(port);
+	if (ulistenfd < 0)
+	    daemonLog ("Unix listen(%d): %s\n", port, strerror(errno));
+	else
+	    daemonLog ("Listening for local CSIMC clients with fd %d\n",
+								    ulistenfd);
 }
 
 /* one of an infinite loop handling connections and traffic.
@@ -543,11 +583,21 @@ announce()
 static void
 mainLoop()
 {
+	static double lastturn;
+
+	pollStats();
+
 	advanceToken();
 	if (isOurToken()) {
+	    double now = lhNow();
+
+	    if (lastturn)
+		lhAdd (&css->rotation, now - lastturn);
+	    lastturn = now;
 	    if (verbose > 3)
 		daemonLog ("Token is ours\n");
 	    checkClients();
+	    flushTTY();		/* the wait below is for these to arrive */
 
             //HACK: give the network 10ms to propagate sent
             // data downthe chain.  If we poll again too
@@ -590,19 +640,28 @@ checkClients(void)
 	int fd;
 	int n;
 
-	/* make copy so we can add listenfd */
+	/* make copy so we can add listenfd and ulistenfd */
 	fs = clset;
 	maxfs = maxclset;
 	FD_SET (listenfd, &fs);
-	if (listenfd > maxclset)
+	if (listenfd > maxfs)
 	    maxfs = listenfd;
+	if (ulistenfd >= 0) {
+	    FD_SET (ulistenfd, &fs);
+	    if (ulistenfd > maxfs)
+		maxfs = ulistenfd;
+	}
 
 	/* poll .. must get back to passing token unless no clients now */
 	tv.tv_sec = 0;
 	tv.tv_usec = maxclset < 0 ? 10000 : 0;
 
-	/* the truth is out there */
+	/* the truth is out there.
+	 * anything a client sent came since we last looked, at worst.
+	 */
 	n = selectI (maxfs+1, &fs, NULL, NULL, &tv);
+	prevpoll = lastpoll;
+	lastpoll = lhNow();
 	if (n < 0) {
 	    daemonLog ("select(%d): %s\n", maxfs, strerror(errno));
 	    return;
@@ -611,8 +670,8 @@ checkClients(void)
 	/* handle the actions -- some may change clset */
 	for (fd = 0; n > 0 && fd <= maxfs; fd++) {
 	    if (FD_ISSET (fd, &fs)) {
-		if (fd == listenfd)
-		    newClient();
+		if (fd == listenfd || fd == ulistenfd)
+		    newClient(fd);
 		else if (FD_ISSET (fd, &clset))
 		    clientMsg (fd);
 		--n;
@@ -627,18 +686,26 @@ checkClients(void)
 static void
 wait4TokenBack(void)
 {
-	while (!readLANpacket("BROKTOK back", TOKWT/ACKWT, tok2addr(curtoken)))
+	int a = tok2addr(curtoken);
+	double t0 = lhNow();
+
+	while (!readLANpacket("BROKTOK back", TOKWT/ACKWT, a))
 	    rpktDispatch();
+
+	if (lantimeout)
+	    css->node[a].toktimeouts++;
+	else
+	    lhAdd (&css->node[a].tokhold, lhNow() - t0);
 } 
 
-/* a new client just arrived on listenfd.
+/* a new client just arrived on lfd, listenfd or ulistenfd.
  * byte 1 should be the node address they want.
  * byte 2 should be one of OpenWhy.
  * byte 3 can be any extra info.
  * unless FOR_REBOOT, ping the node to confirm before committing.
  */
 static void
-newClient()
+newClient(int lfd)
 {
 	Byte preamble[3];
 	CInfo *cip;
@@ -648,7 +715,7 @@ newClient()
 	int n;
 
 	/* accept the new connection */
-	newcfd = csimcd_saccept (listenfd);
+	newcfd = csimcd_saccept (lfd);
 	if (newcfd < 0) {
 	    daemonLog ("accept(): %s\n", strerror(errno));
 	    exit (1);
@@ -700,6 +767,8 @@ newClient()
 	cip->cfd = newcfd;
 	cip->toaddr = to;
 	cip->why = why;
+	css->host[cip-cinfo].toaddr = to;
+	css->host[cip-cinfo].why = why;
 
 	switch (why) {
 	case FOR_SHELL:
@@ -714,6 +783,9 @@ newClient()
 	case FOR_SERIAL:
 	    newSerial(cip, 300*preamble[2]);	/* 3rd is baud/300 */
 	    break;
+	case FOR_VARS:
+	    newVars(cip);
+	    break;
 	default:
 	    daemonLog ("Unknown preamble 'Why' to %d: %d\n", to, why);
 	    closecfd(newcfd);
@@ -765,6 +837,7 @@ newReboot(CInfo *cip)
 	daemonLog ("Broadcasting REBOOT\n");
 	sendPkt (xpkt, 0);	/* get no ACKs from BRDCA */
 	sendPkt (xpkt, 0);	/* repeat for good measure */
+	flushTTY();
 	breakAllConnections();	/* close all client connections */
 	initPty();		/* rescan for new SER entries, if any */
 }
@@ -837,6 +910,25 @@ newSerial (CInfo *cip, int baud)
 							    newcfd, ha, to);
 }
 
+/* create a new binary variable connection */
+static void
+newVars (CInfo *cip)
+{
+	int newcfd = cip->cfd;
+	int ha = CIP2HA(cip);
+	int to = cip->toaddr;
+
+	if (verbose)
+	    daemonLog ("New Vars client request: fd %d host %d node %d\n",
+							    newcfd, ha, to);
+
+	if (sendConfirmPing (cip) < 0)
+	    return;	/* already closed + logged */
+	if (verbose)
+	    daemonLog ("New Vars client accepted: fd %d host %d node %d\n",
+							    newcfd, ha, to);
+}
+
 /* send a PING to cip's to from ha.
  * if ok add to clset, tell client and add to livenodes[].
  * return 0 if ok, else -1.
@@ -881,38 +973,33 @@ isTokPkt (Byte buf[2])
 	return (buf[0] == PSYNC && (buf[1] == BROKTOK || ISNTOK(buf[1])));
 }
 
-/* read the next char from the lan.
- * return 0 if ok else -1 if time out after nto tries
+/* read more from the lan into the ring after first sending anything queued.
+ * return 0 if got some else -1 if time out after nto tries
  */
 static int
-readLANchar (int nto, Byte *bp)
+lanFill (int nto)
 {
-	static Byte inbuf[100];
-	static int lastsent, ninbuf;
+	flushTTY();
 
-	/* pull from inbuf first */
-	if (lastsent < ninbuf) {
-	    *bp = inbuf[lastsent++];
-	    return (0);
-	}
-
-	/* then try to read more, up to nto times */
 	while (nto-- > 0) {
-	    int n = readI (ttyfd, inbuf, sizeof(inbuf));
+	    int room, n;
+	    Byte *bp = lanSpace (&lan, &room);
+
+	    n = readI (ttyfd, bp, room);
 	    if (n < 0) {
 		daemonLog ("Read(%s): %s\n", tty, strerror(errno));
 		exit (1);
 	    }
+	    css->lanreads++;
 	    if (n > 0) {
 		/* suppres token traffic at level 2 */
-		if (verbose > 3 || (verbose > 2 && !isTokPkt(inbuf))) {
-		    daemonLog ("Read %d from %s.. rpktlen now %d\n",
-							n, tty, rpktlen);
-		    dump (inbuf, n);
+		if (verbose > 3 || (verbose > 2 && !isTokPkt(bp))) {
+		    daemonLog ("Read %d from %s.. ring now %d\n", n, tty,
+								LANN(&lan)+n);
+		    dump (bp, n);
 		}
-		ninbuf = n;
-		lastsent = 0;
-		return (readLANchar(nto, bp));
+		lan.tail += n;
+		return (0);
 	    }
 	}
 
@@ -921,6 +1008,7 @@ readLANchar (int nto, Byte *bp)
 }
 
 /* read from ttyfd into rpkt until we have a packet or see BROKTOK or timeout.
+ * whatever is left over stays in the ring for next time.
  * nto is number of ACKWT periods to wait before considering it a timeout.
  * "what" is a string of what we are hoping to read for printing and fr is
  *    the node address from which we anticipate a packet, for verbose.
@@ -929,94 +1017,115 @@ readLANchar (int nto, Byte *bp)
 static int
 readLANpacket(char *what, int nto, int fr)
 {
-	Byte d;
-	int n;
+	/* anything queued, such as an ACK, goes out before we look at what
+	 * is already in the ring, let alone wait for more.
+	 */
+	flushTTY();
 
 	/* new packet */
 	rpktlen = 0;
+	lantimeout = 0;
 
-    	/* repeat until know what is going on */
-    	while (1) {
-	    if (readLANchar (nto, &d) < 0) {
+	/* repeat until know what is going on */
+	while (1) {
+	    switch (lanDecode (&lan, rpkt, &rpktlen)) {
+	    case LD_PKT:
+		return (0);
+	    case LD_BROKTOK:
+		if (verbose > 3)
+		    daemonLog ("Received BROKTOK back from %d\n", fr);
+		return (-1);
+	    default:
+		break;
+	    }
+
+	    if (lanFill (nto) < 0) {
 		daemonLog ("Time out waiting for %s from %d\n", what, fr);
+		lantimeout = 1;
 		return (-1);
 	    }
+	}
+}
 
-	    if (d == PSYNC) {
-		/* saw SYNC -- always start over */
-		rpkt[PB_SYNC] = PSYNC;
-		rpktlen = 1;
-	    } else {
-		/* handle bytes subsequent to known-good SYNC */
-		switch (rpktlen) {
-		case 0:				/* just garbage */
-		    break;
-		case 1:				/* To or token */
-		    if (d == BROKTOK) {
-			if (verbose > 3)
-			    daemonLog ("Received BROKTOK back from %d\n", fr);
-			return (-1);
-		    }
-		    if (ISNTOK(d)) {
-			rpktlen = 0;		/* start over */
-		    } else {
-			rpkt[PB_TO] = d;	/* continue with normal pkt */
-			rpktlen = 2;
-		    }
-		    break;
-		case 2:				/* From */
-		    rpkt[PB_FR] = d;
-		    rpktlen = 3;
-		    break;
-		case 3:				/* Info */
-		    rpkt[PB_INFO] = d;
-		    rpktlen = 4;
-		    break;
-		case 4:				/* Data Count */
-		    if (d > PMXDAT) {
-			daemonLog ("Preposterous data count: %d\n", d);
-			dump (rpkt, 5);
-			rpktlen = 0;		/* must be illegal */
-		    } else {
-			rpkt[PB_COUNT] = d;
-			rpktlen = 5;
-		    }
-		    break;
-		case 5:				/* Header Checksum */
-		    rpkt[PB_HCHK] = d;		/* proposed header checksum */
-		    rpktlen = 6;
-		    n = chkSum (rpkt, PB_NHCHK);
-		    if (n == d) {		/* if good checksum */
-			if (rpkt[PB_COUNT] == 0)/*   if control packet */
-			    return (0);		/*     good to go */
-		    } else {
-			daemonLog ("Bad header chksum: 0x%02x vs 0x%02x\n", n,
-								rpkt[PB_HCHK]);
-													dump (rpkt, rpktlen);
-			rpktlen = 0;		/* start over */
-		    }
-		    break;
-		case 6:				/* Data Checksum */
-		    rpkt[PB_DCHK] = d;		/* claimed data checksum */
-		    rpktlen = 7;		/* now collect data */
-		    break;
-		default:			/* gathering data */
-		    rpkt[rpktlen++] = d;	/* another byte of data */
-		    if (rpktlen >= rpkt[PB_COUNT]+PB_DATA) { /* if have all */
-			n = chkSum (&rpkt[PB_DATA], rpkt[PB_COUNT]);
-			if (n == rpkt[PB_DCHK]) /* if good data */
-			    return(0);		/*   good to go */
-			else {
-			    daemonLog ("Bad data chksum from %d: 0x%02x vs 0x%02x\n",
-						rpkt[PB_FR], n, rpkt[PB_DCHK]);
-													    dump (rpkt, rpktlen);
-			    rpktlen = 0;		/* start over */
-			}
-		    }
-		    break;
-		}
+/* attach css and say we are here */
+static void
+initStats (void)
+{
+	CSSHost *hp;
+
+	css = cssOpen (port, 1);
+	if (!css) {
+	    daemonLog ("Stats shm for port %d: %s\n", port, strerror(errno));
+	    css = &cssmine;
+	}
+	css->pid = getpid();
+	lan.css = css;
+	for (hp = css->host; hp < &css->host[NHOSTS]; hp++)
+	    hp->toaddr = -1;
+}
+
+/* update the packet rates once a sec, and log css if asked */
+static void
+pollStats (void)
+{
+	static unsigned rx0[NNODES+1], tx0[NNODES+1];
+	static double t0;
+	double now = lhNow();
+	int a;
+
+	if (now >= t0 + 1) {
+	    for (a = 0; a <= NNODES; a++) {
+		CSSNode *np = &css->node[a];
+		np->rxpps = t0 ? (np->rxpkts - rx0[a])/(now - t0) : 0;
+		np->txpps = t0 ? (np->txpkts - tx0[a])/(now - t0) : 0;
+		rx0[a] = np->rxpkts;
+		tx0[a] = np->txpkts;
 	    }
+	    t0 = now;
+	}
+
+	if (logstats) {
+	    logstats = 0;
+	    logStats();
+	}
+}
+
+/* log css for each node address that has seen any traffic */
+static void
+logStats (void)
+{
+	CSSNode *np;
+	CSSHost *hp;
+	char who[8];
+
+	daemonLog ("LAN: %u reads %u writes %u junk bytes, rotation n=%u p50=%.1fms p99=%.1fms max=%.1fms\n",
+		    css->lanreads, css->lanwrites, css->lanjunk,
+		    css->rotation.n, 1e3*lhQuantile (&css->rotation, .5),
+		    1e3*lhQuantile (&css->rotation, .99),
+		    1e3*css->rotation.max);
+	for (np = css->node; np <= &css->node[CSS_NOADDR]; np++) {
+	    if (!np->rxpkts && !np->txpkts && !np->resyncs && !np->hchkerrs
+								&& !np->dchkerrs)
+		continue;
+	    if (np < &css->node[CSS_NOADDR])
+		sprintf (who, "%2d", (int)(np - css->node));
+	    else
+		strcpy (who, "??");
+	    daemonLog ("LAN %s: rx %u pkts %u bytes, tx %u pkts %u bytes, %u resyncs %u hchk %u dchk\n",
+		    who, np->rxpkts, np->rxbytes, np->txpkts, np->txbytes,
+		    np->resyncs, np->hchkerrs, np->dchkerrs);
+	    if (np->ack.n || np->retries || np->toktimeouts)
+		daemonLog ("LAN %s: ack p50=%.1fms p99=%.1fms, %u retries %u reboots %u token timeouts\n",
+		    who, 1e3*lhQuantile (&np->ack, .5),
+		    1e3*lhQuantile (&np->ack, .99), np->retries, np->reboots,
+		    np->toktimeouts);
 	}
+	for (hp = css->host; hp < &css->host[NHOSTS]; hp++)
+	    if (hp->toaddr >= 0 && hp->pkts)
+		daemonLog ("Host %d to %d: %u pkts, wait p50=%.1fms p99=%.1fms\n",
+		    (int)(hp - css->host) + NNODES, hp->toaddr, hp->pkts,
+		    1e3*lhQuantile (&hp->wait, .5),
+		    1e3*lhQuantile (&hp->wait, .99));
 }
 
 /* rpkt from tty checksums ok .. dispatch to client.
@@ -1120,7 +1229,9 @@ rpktDispatch()
 static void
 clientMsg(int cfd)
 {
-	switch (CFD2CIP(cfd)->why) {
+	CInfo *cip = CFD2CIP(cfd);
+
+	switch (cip->why) {
 	case FOR_BOOT:
 	    if (buildBootXPkt (cfd) < 0)
 		return;
@@ -1133,12 +1244,23 @@ clientMsg(int cfd)
 	    if (buildSerialXPkt (cfd) < 0)
 		return;
 	    break;
+	case FOR_VARS:
+	    if (buildVarXPkt (cfd) < 0)
+		return;
+	    break;
 	default:
 	    daemonLog ("Bogus why field %d from %d\n", CFD2CIP(cfd)->why,
 								CFD2HA(cfd));
 	    return;
 	}
 
+	/* how long it may have been waiting for us, unless it just left */
+	if (cip->inuse) {
+	    CSSHost *hp = &css->host[cip-cinfo];
+	    hp->pkts++;
+	    lhAdd (&hp->wait, lhNow() - prevpoll);
+	}
+
 	(void) sendXpkt();		/* closes if trouble and logs */
 }
 
@@ -1304,19 +1426,81 @@ buildSerialXPkt (int cfd)
 	return (0);
 }
 
-/* compute check sum on the given array */
-int
-chkSum (Byte p[], int n)
+/* read client cfd with one GETVAR or SETVAR request and create xpkt.
+ * the request is the PktType, the count then count bytes of packet Data,
+ * which the client has already escaped so must hold no PSYNC.
+ * return 0 if ok, else -1.
+ */
+static int
+buildVarXPkt (int cfd)
 {
-	Word sum;
-
-	for (sum = 0; n > 0; --n)
-	    sum += *p++;
-	while (sum > 255)
-	    sum = (sum & 0xff) + (sum >> 8);
-	if (sum == PSYNC)
-	    sum = 1;
-	return (sum);
+	int haddr = CFD2HA(cfd);
+	int toaddr = CFD2CIP(cfd)->toaddr;
+	int newseq = XSEQ(toaddr);
+	Byte *dp = &xpkt[PB_DATA];
+	Byte hdr[2];
+	int n;
+
+	/* this much of new xpkt is always the same */
+	xpkt[PB_SYNC] = PSYNC;
+	xpkt[PB_TO] = toaddr;
+	xpkt[PB_FR] = haddr;
+
+	/* read client's request */
+	n = readAll (cfd, hdr, 2);
+	if (n == 0 && ((hdr[0] != PT_GETVAR && hdr[0] != PT_SETVAR)
+							|| hdr[1] > PMXDAT)) {
+	    daemonLog ("Bogus Vars request from host %d: type %d count %d\n",
+							haddr, hdr[0], hdr[1]);
+	    n = -1;
+	}
+	if (n == 0)
+	    n = readAll (cfd, dp, hdr[1]);
+	if (n == 0 && memchr (dp, PSYNC, hdr[1])) {
+	    daemonLog ("Bogus Vars request from host %d: Data not escaped\n",
+									haddr);
+	    n = -1;
+	}
+	if (n < 0) {
+	    if (verbose)
+		daemonLog ("EOF from host %d.. sending KILL to node %d\n",
+							    haddr, toaddr);
+	    closecfd(cfd);
+	    xpkt[PB_INFO] = PT_KILL | newseq;
+	    xpkt[PB_COUNT] = 0;
+	} else {
+	    if (verbose > 2) {
+		daemonLog ("Read %s of %d bytes from %d to %d\n",
+			    hdr[0] == PT_GETVAR ? "GETVAR" : "SETVAR", hdr[1],
+			    haddr, toaddr);
+		if (verbose > 4)
+		    dump (dp, hdr[1]);
+	    }
+	    xpkt[PB_INFO] = hdr[0] | newseq;
+	    xpkt[PB_COUNT] = hdr[1];
+	    xpkt[PB_DCHK] = chkSum(dp, hdr[1]);
+	}
+	xpkt[PB_HCHK] = chkSum(xpkt, PB_NHCHK);
+
+	return (0);
+}
+
+/* read exactly n bytes from fd into buf.
+ * return 0 if ok, else -1 if error or EOF.
+ */
+static int
+readAll (int fd, Byte *buf, int n)
+{
+	int s;
+
+	while (n > 0) {
+	    s = readI (fd, buf, n);
+	    if (s <= 0)
+		return (-1);
+	    buf += s;
+	    n -= s;
+	}
+	return (0);
 }
 
 /* send an ACK packet for what is in rpkt.
@@ -1392,6 +1576,21 @@ ack4xpkt (void)
 		}
 	    }
 
+	    /* if ack for GETVAR or SETVAR from Vars client, pass on its Data
+	     * as it came, still escaped.
+	     */
+	    if (HA2CIP(haddr)->why == FOR_VARS
+				    && ((xpkt[PB_INFO]&PT_MASK) == PT_GETVAR
+				    || (xpkt[PB_INFO]&PT_MASK) == PT_SETVAR)) {
+		int cfd = HA2CFD (haddr);
+		if (writeI (cfd, &rpkt[PB_COUNT], 1) < 0 || (rpkt[PB_COUNT] &&
+			writeI (cfd, &rpkt[PB_DATA], rpkt[PB_COUNT]) < 0)) {
+		    daemonLog("Vars client %d for %d disappeared! %s\n",
+					    haddr, netaddr, strerror(errno));
+		    closecfd (cfd);
+		}
+	    }
+
 	    /* if ack for INTR from SHELL client, send byte to sync. */
 	    if (HA2CIP(haddr)->why == FOR_SHELL
 				    && (xpkt[PB_INFO]&PT_MASK) == PT_INTR) {
@@ -1436,13 +1635,19 @@ sendXpkt (void)
 
 	/* send and retry as necessary */
 	for (i = 0; i <= MAXRTY; i++) {
+	    double t0 = lhNow();
+	    if (i > 0)
+		CSSNODE(to)->retries++;
 	    sendPkt (xpkt, i);
-	    if (wait4ACK() == 0)
+	    if (wait4ACK() == 0) {
+		lhAdd (&CSSNODE(to)->ack, lhNow() - t0);
 		return (0);
+	    }
 	}
 
 	/* sorry */
 	daemonLog ("Restarting node %d after %d tries.\n", to, MAXRTY+1);
+	CSSNODE(to)->reboots++;
 	breakConnections (to);
 	livenodes[to] = 0;
 	buildCtrlPkt (MAXNA+1, to, PT_REBOOT);
@@ -1459,27 +1664,53 @@ pktSize (Byte pkt[])
 	return (pkt[PB_COUNT] ? PB_HSZ+1+pkt[PB_COUNT] : PB_HSZ);
 }
 
-/* send na bytes to tty.
+/* queue na bytes for tty, to for the counters.
+ * they are sent with others in one write by flushTTY() at the start of the
+ * next readLANpacket(), or at the latest when mainLoop() has served the
+ * clients, since nothing can come back until they are all out anyway.
+ */
+static void
+sendTTY (Byte a[], int na, int to)
+{
+	CSSNode *np = CSSNODE(to);
+
+	if (nlanobuf + na > LANOBUFSZ)
+	    flushTTY();
+	memcpy (&lanobuf[nlanobuf], a, na);
+	nlanobuf += na;
+	np->txpkts++;
+	np->txbytes += na;
+
+	if (verbose > 3 || (verbose > 2 && !isTokPkt(a))) {
+	    daemonLog ("Queued %d for %s:\n", na, tty);
+	    if (verbose > 4)
+		dump (a, na);
+	}
+}
+
+/* send all queued bytes to tty.
  * exit if fail.
  */
 static void
-sendTTY (Byte a[], int na)
+flushTTY (void)
 {
 	int s;
 
-	/* send array */
-	s = writeI (ttyfd, a, na);
-	if (s != na) {
+	if (!nlanobuf)
+	    return;
+
+	s = writeI (ttyfd, lanobuf, nlanobuf);
+	if (s != nlanobuf) {
 	    if (s < 0)
 		daemonLog ("Write(%s): %s\n", tty, strerror (errno));
 	    else
-		daemonLog ("Write(%s): short write: %d %d\n", tty, na, s);
+		daemonLog ("Write(%s): short write: %d %d\n", tty, nlanobuf, s);
 	    _exit (1);
-	} else if (verbose > 3 || (verbose > 2 && !isTokPkt(a))) {
-	    daemonLog ("Wrote %d to %s:\n", na, tty);
-	    if (verbose > 4)
-		dump (a, na);
+	} else if (verbose > 3) {
+	    daemonLog ("Wrote %d to %s\n", nlanobuf, tty);
 	}
+	css->lanwrites++;
+	nlanobuf = 0;
 }
 
 /* send the given packet to the csimc network.
@@ -1498,7 +1729,7 @@ sendPkt (Byte pkt[], int try)
 		dump (pkt, npkt);
 	}
 
-	sendTTY (pkt, npkt);
+	sendTTY (pkt, npkt, pkt[PB_TO]);
 }
 
 /* send curtoken onto the LAN.
@@ -1515,7 +1746,7 @@ sendCurToken()
 	if (verbose > 3)
 	    daemonLog ("Sending token to node %d\n", tok2addr(curtoken));
 
-	sendTTY (tpkt, 2);
+	sendTTY (tpkt, 2, tok2addr(curtoken));
 }
 
 /* close the client file descriptor cfd and associated bookkeeping */
@@ -1537,6 +1768,7 @@ closecfd (int cfd)
 	/* close real fd */
 	(void) close (cfd);
 	cip->inuse = 0;
+	css->host[cip-cinfo].toaddr = -1;
 
 	/* remove from clset, if claims to be in */
 	if (cip->cfdset) {
@@ -1589,35 +1821,6 @@ breakConnections (int to)
 		closecfd (cip->cfd);
 }
 
-/* dump np bytes to log starting at p */
-void
-dump (Byte *p, int np)
-{
-#define	BPR	8
-	int ntot = 0;
-	int i, n;
-
-	do {
-	    char buf[10*BPR], *bp = buf;
-	    n = np > BPR ? BPR : np;
-	    bp += sprintf (bp, "%3d..%3d: ", ntot, ntot+n-1);
-	    for (i = 0; i < BPR; i++)
-		if (i < n)
-		    bp += sprintf (bp, "%02x ", p[i]);
-		else
-		    bp += sprintf (bp, "   ");
-	    bp += sprintf (bp, "   ");
-	    for (i = 0; i < BPR; i++) {
-		*bp++ = (i < n && isprint(p[i])) ? p[i] : ' ';
-		*bp++ = ' ';
-	    }
-	    *bp = 0;
-	    daemonLog ("%s\n", buf);
-	    p += n;
-	    ntot += n;
-	} while (np -= n);
-}
-
 /* given a packet, return a string describing its type */
 char *
 p2tstr (Pkt *pkp)
@@ -1651,6 +1854,7 @@ why2str (OpenWhy why)
 	case FOR_BOOT:	 return ("FOR_BOOT");
 	case FOR_REBOOT: return ("FOR_REBOOT");
 	case FOR_SERIAL: return ("FOR_SERIAL");
+	case FOR_VARS:	 return ("FOR_VARS");
 	default:	 return ("FOR_???");
 	}
 }
@@ -1664,6 +1868,14 @@ onVerboseSig (int dummy)
 	daemonLog ("Verbose set to %d\n", verbose);
 }
 
+/* ask mainLoop to log the LAN counters */
+static void
+onStatsSig (int dummy)
+{
+	signal (SIGUSR1, onStatsSig);
+	logstats = 1;
+}
+
 static void
 onExit(void)
 {
@@ -1682,6 +1894,7 @@ onBye (int signo)
 	buildCtrlPkt (MAXNA+1, BRDCA, PT_REBOOT);
 	sendPkt (xpkt, 0);	/* get no ACKs from BRDCA */
 	sendPkt (xpkt, 0);	/* repeat for good measure */
+	flushTTY();
 
 	if (signo < 0)
 	    daemonLog ("Exit: Ok fine, we're outta here\n");
@@ -0,0 +1,176 @@
+/* the ring of bytes read from the CSIMC LAN, and finding packets in it.
+ * csimcd reads the LAN into the ring in whatever pieces arrive and takes
+ * out one packet or token at a time.
+ */
+
+#include <stdio.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "telenv.h"
+#include "csimc.h"
+#include "csimcstats.h"
+#include "lanring.h"
+
+#define	RB(rp,i)	(rp)->buf[((rp)->head+(i))&(LANBUFSZ-1)] /* ith from head */
+#define	RNODE(rp,a)	(&(rp)->css->node[(a) < NNODES ? (a) : CSS_NOADDR])
+
+static void lanSkip (LanRing *rp, int n, int fr);
+
+/* return where the next bytes read from the LAN go and in *roomp how many
+ * fit there without wrapping. add them with rp->tail += n.
+ */
+Byte *
+lanSpace (LanRing *rp, int *roomp)
+{
+	int off = rp->tail & (LANBUFSZ-1);
+	int room = LANBUFSZ - LANN(rp);
+
+	if (room > LANBUFSZ - off)
+	    room = LANBUFSZ - off;		/* just up to the wrap */
+	*roomp = room;
+	return (&rp->buf[off]);
+}
+
+/* drop n bytes from the front of the ring while looking for a packet.
+ * if they were part of a packet, count a resync against node fr.
+ */
+static void
+lanSkip (LanRing *rp, int n, int fr)
+{
+	rp->head += n;
+	if (n > 1)
+	    RNODE(rp, fr)->resyncs++;
+	else
+	    rp->css->lanjunk++;
+}
+
+/* decode the next thing in the lan ring.
+ * return LD_PKT with a checked packet in pkt[*lenp], LD_BROKTOK if the
+ * token came back, else LD_MORE if need more bytes. node tokens and
+ * anything not a packet are skipped.
+ */
+int
+lanDecode (LanRing *rp, Byte pkt[PMXLEN], int *lenp)
+{
+	while (LANN(rp) > 0) {
+	    int need, i, n, d;
+
+	    /* everything starts with SYNC */
+	    if (RB(rp, 0) != PSYNC) {
+		lanSkip (rp, 1, CSS_NOADDR);
+		continue;
+	    }
+	    if (LANN(rp) < 2)
+		return (LD_MORE);
+
+	    /* To or token */
+	    d = RB(rp, 1);
+	    if (d == BROKTOK) {
+		rp->head += 2;
+		return (LD_BROKTOK);
+	    }
+	    if (ISNTOK(d)) {
+		rp->head += 2;
+		continue;
+	    }
+
+	    /* SYNC never appears inside a packet so seeing one means start
+	     * over from there. first the header, then any data.
+	     */
+	    need = PB_HSZ;
+	    for (i = 1; i < need; i++) {
+		if (i >= (int)LANN(rp))
+		    return (LD_MORE);
+		if (RB(rp, i) == PSYNC)
+		    break;
+		if (i == PB_COUNT && RB(rp, i) > PMXDAT) {
+		    daemonLog ("Preposterous data count: %d\n", RB(rp, i));
+		    break;
+		}
+		if (i == PB_HCHK) {
+		    for (n = 0; n < PB_HSZ; n++)
+			pkt[n] = RB(rp, n);
+		    n = chkSum (pkt, PB_NHCHK);
+		    if (n != pkt[PB_HCHK]) {
+			daemonLog ("Bad header chksum: 0x%02x vs 0x%02x\n", n,
+								pkt[PB_HCHK]);
+			dump (pkt, PB_HSZ);
+			rp->css->node[CSS_NOADDR].hchkerrs++;
+			break;
+		    }
+		    if (pkt[PB_COUNT])
+			need = PB_NZHSZ + pkt[PB_COUNT];
+		}
+	    }
+	    if (i < need) {
+		lanSkip (rp, i, i > PB_HCHK ? pkt[PB_FR] : CSS_NOADDR);
+		continue;
+	    }
+
+	    /* have it all */
+	    for (n = PB_HSZ; n < need; n++)
+		pkt[n] = RB(rp, n);
+	    rp->head += need;
+	    *lenp = need;
+	    if (pkt[PB_COUNT]) {
+		n = chkSum (&pkt[PB_DATA], pkt[PB_COUNT]);
+		if (n != pkt[PB_DCHK]) {
+		    daemonLog ("Bad data chksum from %d: 0x%02x vs 0x%02x\n",
+						pkt[PB_FR], n, pkt[PB_DCHK]);
+		    dump (pkt, *lenp);
+		    RNODE(rp, pkt[PB_FR])->dchkerrs++;
+		    continue;
+		}
+	    }
+	    RNODE(rp, pkt[PB_FR])->rxpkts++;
+	    RNODE(rp, pkt[PB_FR])->rxbytes += need;
+	    return (LD_PKT);
+	}
+
+	return (LD_MORE);
+}
+
+/* compute check sum on the given array */
+int
+chkSum (Byte p[], int n)
+{
+	Word sum;
+
+	for (sum = 0; n > 0; --n)
+	    sum += *p++;
+	while (sum > 255)
+	    sum = (sum & 0xff) + (sum >> 8);
+	if (sum == PSYNC)
+	    sum = 1;
+	return (sum);
+}
+
+/* dump np bytes to log starting at p */
+void
+dump (Byte *p, int np)
+{
+#define	BPR	8
+	int ntot = 0;
+	int i, n;
+
+	do {
+	    char buf[10*BPR], *bp = buf;
+	    n = np > BPR ? BPR : np;
+	    bp += sprintf (bp, "%3d..%3d: ", ntot, ntot+n-1);
+	    for (i = 0; i < BPR; i++)
+		if (i < n)
+		    bp += sprintf (bp, "%02x ", p[i]);
+		else
+		    bp += sprintf (bp, "   ");
+	    bp += sprintf (bp, "   ");
+	    for (i = 0; i < BPR; i++) {
+		*bp++ = (i < n && isprint(p[i])) ? p[i] : ' ';
+		*bp++ = ' ';
+	    }
+	    *bp = 0;
+	    daemonLog ("%s\n", buf);
+	    p += n;
+	    ntot += n;
+	} while (np -= n);
+}
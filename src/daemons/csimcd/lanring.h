@@ -0,0 +1,33 @@
+/* the ring of bytes read from the CSIMC LAN, and finding packets in it.
+ * lanring.c is shared with src/tests/lancheck.c.
+ */
+
+#ifndef LANRING_H
+#define LANRING_H
+
+#include "csimc.h"
+#include "csimcstats.h"
+
+#define	LANBUFSZ	1024		/* bytes in LAN input ring, power of 2 */
+
+typedef struct {
+    Byte buf[LANBUFSZ];		/* ring of bytes read from the LAN */
+    unsigned head;		/* total bytes ever taken out of buf */
+    unsigned tail;		/* total bytes ever put in buf */
+    CSIMCStats *css;		/* counters to keep */
+} LanRing;
+
+#define	LANN(rp)	((rp)->tail - (rp)->head)	/* bytes in the ring */
+
+/* lanDecode() return values */
+enum {
+    LD_MORE, LD_PKT, LD_BROKTOK
+};
+
+/* lanring.c */
+extern Byte *lanSpace (LanRing *rp, int *roomp);
+extern int lanDecode (LanRing *rp, Byte pkt[PMXLEN], int *lenp);
+extern int chkSum (Byte p[], int n);
+extern void dump (Byte *p, int n);
+
+#endif // LANRING_H
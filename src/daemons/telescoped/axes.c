@@ -28,9 +28,22 @@
 
 static void recordLimit (MotorInfo *mip, char dir);
 static void recordStep (MotorInfo *mip, int motdiff, int encdiff);
+static void recordCal (MotorInfo *mip);
+static char axisLetter (MotorInfo *mip);
+
+/* return the most secs the mip axis should go without reporting progress
+ * while homing or finding limits. the only clue is the initial limit
+ * estimates, and it seeks at half speed.
+ * N.B. the caller keeps the time, so all axes can run at once.
+ */
+double
+axisSeekTime (MotorInfo *mip)
+{
+    return (4.5*(mip->poslim-mip->neglim)/mip->maxvel);
+}
 
 /* find home, direction as per POSSIDE.
- * return 1 if in-progress, 0 done, else -1.
+ * return 2 if in-progress and reported, 1 if in-progress, 0 done, else -1.
  * status logged to fid.
  * STO 10-9-2002 -- updated shm mip info to include 'ishomed' flag
  * and am setting this accordingly here
@@ -38,7 +51,6 @@ static void recordStep (MotorInfo *mip, int motdiff, int encdiff);
 int
 axis_home (MotorInfo *mip, FifoId fid, int first)
 {
-    static double mjdto[TEL_NM];
     int i = mip - &telstatshmp->minfo[0];
     int axis = (int)mip->axis;
     int cfd = MIPCFD(mip);
@@ -66,18 +78,6 @@ axis_home (MotorInfo *mip, FifoId fid, int first)
         mip->ishomed = 0;
         mip->cvel = mip->maxvel;
         mip->dpos = 0;
-
-        /* estimate a timeout -- only clue is initial limit estimates */
-        mjdto[i] = telstatshmp->now.n_mjd +
-                   4.5*(mip->poslim-mip->neglim)/mip->maxvel/SPD;
-        /* seeks at half speed */
-    }
-
-    /* check for timeout */
-    if (telstatshmp->now.n_mjd > mjdto[i]) {
-        csiStop (mip, 1);
-        fifoWrite (fid, -1, "Axis %d timed out finding home", axis);
-        return (-1);
     }
 
     /* check for motion errors */
@@ -125,13 +125,7 @@ axis_home (MotorInfo *mip, FifoId fid, int first)
     fifoWrite (fid, n, "Axis %d homing: %s", axis, buf+1);
 
     // STO: 10-01-2002 -- Update timeout on positive message
-    mjdto[i] = telstatshmp->now.n_mjd +
-    		4.5*(mip->poslim-mip->neglim)/mip->maxvel/SPD;
-    //ICE set 4.5 for double opteration instead of interger.
-    //4*(mip->poslim-mip->neglim)/mip->maxvel/SPD;
-    //
-
-    return (1);
+    return (2);
 }
 
 //ICE
@@ -198,7 +192,9 @@ axisMotionCheck (MotorInfo *mip, char msgbuf[])
 
 /* hunt for both axes' limits and record in home.cfg. if have an encoder, also
  * find and record new motor step scale.
- * return 1 if in-progress, 0 done, else -1.
+ * findlim() may report the motor and encoder positions in its final line,
+ * which saves asking for them.
+ * return 2 if in-progress and reported, 1 if in-progress, 0 done, else -1.
  */
 int
 axis_limits (MotorInfo *mip, FifoId fid, int first)
@@ -212,7 +208,6 @@ axis_limits (MotorInfo *mip, FifoId fid, int first)
         }
     }
 
-    static double mjdto[TEL_NM];
     int i = mip - telstatshmp->minfo;
 
     static char seeking[TEL_NM];	/* canonical dir we seek, '+'/'-' */
@@ -223,6 +218,7 @@ axis_limits (MotorInfo *mip, FifoId fid, int first)
     int cfd = MIPCFD(mip);
     char buf[1024];
     int hwdir;
+    int motnow, encnow;
     int n;
 
     if (!mip->havelim) {
@@ -255,19 +251,6 @@ axis_limits (MotorInfo *mip, FifoId fid, int first)
 
         /* for the eavesdroppers */
         mip->limiting = 1;
-
-        /* estimate a timeout -- only clue is initial limit estimates */
-        mjdto[i] = telstatshmp->now.n_mjd +
-                   4.5*(mip->poslim-mip->neglim)/mip->maxvel/SPD;
-        /* seeks at half speed */
-
-    }
-
-    /* check for timeout */
-    if (telstatshmp->now.n_mjd > mjdto[i]) {
-        csiStop(mip, 1);
-        fifoWrite (fid, -1, "Axis %d timed out finding limits", axis);
-        return (-1);
     }
 
     /* check for motion errors */
@@ -305,7 +288,14 @@ axis_limits (MotorInfo *mip, FifoId fid, int first)
     }
     if (n > 0) {
         fifoWrite (fid, n, "Axis %d: %s", axis, buf+1);	/* skip n */
-        return (1);
+        return (2);
+    }
+
+    /* where we stopped, from the script if it says */
+    if (mip->haveenc && sscanf (buf, "%*d Found limit %d %d", &motnow,
+                                                            &encnow) != 2) {
+        motnow = csi_rix (cfd, "=mpos;");
+        encnow = csi_rix (cfd, "=epos;");
     }
 
     /* found a limit */
@@ -317,9 +307,9 @@ axis_limits (MotorInfo *mip, FifoId fid, int first)
         found[i] = seeking[i];
         recordLimit (mip, found[i]);
         if (mip->haveenc) {
-            /* get motor and enc positions to find scale */
-            motbeg[i] = csi_rix (cfd, "=mpos;");
-            encbeg[i] = csi_rix (cfd, "=epos;");
+            /* note motor and enc positions to find scale */
+            motbeg[i] = motnow;
+            encbeg[i] = encnow;
         }
 
         /* turn around */
@@ -336,18 +326,16 @@ axis_limits (MotorInfo *mip, FifoId fid, int first)
         csi_w (cfd, "findlim(%d);", hwdir);
 
         /* continue */
-        return (1);
+        return (2);
 
     } else if (found[i] != seeking[i]) {
         /* ran into a different limit than before. this is good */
         recordLimit (mip, seeking[i]);
         if (mip->haveenc) {
-            /* get motor and enc again and compute/record scale */
-            int motend, encend;
-            motend = csi_rix (cfd, "=mpos;");
-            encend = csi_rix (cfd, "=epos;");
-            recordStep (mip, motend-motbeg[i], encend-encbeg[i]);
+            /* compute/record scale from motor and enc again */
+            recordStep (mip, motnow-motbeg[i], encnow-encbeg[i]);
         }
+        recordCal (mip);
 
         /* would like to back away but caller often issues stop and
          * rereads config file.
@@ -375,13 +363,8 @@ recordLimit (MotorInfo *mip, char dir)
 {
     char name[64], valu[64];
 
-    if (mip == &telstatshmp->minfo[TEL_HM])
-        name[0] = 'H';
-    else if (mip == &telstatshmp->minfo[TEL_DM])
-        name[0] = 'D';
-    else if (mip == &telstatshmp->minfo[TEL_RM])
-        name[0] = 'R';
-    else {
+    name[0] = axisLetter (mip);
+    if (!name[0]) {
         /* who could it be?? */
         tdlog ("Bogus mip passed to recordLimit: %ld", (long)mip);
         return;
@@ -437,3 +420,33 @@ recordStep (MotorInfo *mip, int motdiff, int encdiff)
     /* set new maxvel from new step */
     csiSetup (mip);
 }
+
+/* record when the limits and step of mip were last found, so a later
+ * limits command may skip it.
+ */
+static void
+recordCal (MotorInfo *mip)
+{
+    char name[64], valu[64];
+
+    name[0] = axisLetter (mip);
+    if (!name[0])
+        return;
+    strcpy (name+1, "LIMMJD");
+    sprintf (valu, "%.5f", telstatshmp->now.n_mjd);
+    if (writeCfgFile (hcfn, name, valu, NULL) < 0)
+        tdlog ("%s: %s in recordCal", hcfn, name);
+}
+
+/* return the home.cfg letter for mip, or 0 if it's not one of ours */
+static char
+axisLetter (MotorInfo *mip)
+{
+    if (mip == &telstatshmp->minfo[TEL_HM])
+        return ('H');
+    if (mip == &telstatshmp->minfo[TEL_DM])
+        return ('D');
+    if (mip == &telstatshmp->minfo[TEL_RM])
+        return ('R');
+    return (0);
+}
@@ -31,6 +31,8 @@ CSIMCInfo csii[NNODES];
 static char ipme[] = "127.0.0.1";
 static char *host;
 static int port = CSIMCPORT;
+static int getvar;		/* nodes support binary GETVAR/SETVAR */
+static int reboot = 1;		/* reboot nodes before loading scripts */
 static char *cfg = "csimc.cfg";
 
 /* insure csimcd is running and loaded with config scripts.
@@ -49,9 +51,17 @@ csiInit()
         daemonLog ("%15s = %s\n", "HOST", buf);
         host = strcpy (malloc(strlen(buf)+1), buf);
     }
+    if (!read1CfgEntry (0, cfg, "GETVAR", CFG_INT, &getvar, 0))
+        daemonLog ("%15s = %d\n", "GETVAR", getvar);
+    if (!read1CfgEntry (0, cfg, "REBOOT", CFG_INT, &reboot, 0))
+        daemonLog ("%15s = %d\n", "REBOOT", reboot);
 
-    /* start daemon, reboot and load config scripts */
-    sprintf (buf, "csimc -i %s %d -rl < /dev/null", host?host:ipme, port);
+    /* start daemon, reboot if asked and load config scripts.
+     * without a reboot csimc only sends each node the scripts that changed
+     * since it was last loaded, so a restart is quick when none did.
+     */
+    sprintf (buf, "csimc -i %s %d -%sl < /dev/null", host?host:ipme, port,
+                                                            reboot ? "r" : "");
     if (system (buf)) {
         tdlog ("Can not load csimc scripts\n");
         exit(1);
@@ -85,7 +95,7 @@ csiClose (int fd)
 }
 
 /* use csi_open() to open cfd and sfd for mip->axis using host and port from
- * config file.
+ * config file, and vfd too if GETVAR says the nodes support it.
  * exit if real trouble.
  */
 void
@@ -107,10 +117,19 @@ csiiOpen (MotorInfo *mip)
         exit(1);
     }
     MIPSFD(mip) = fd;
+
+    MIPVFD(mip) = 0;
+    if (getvar) {
+        fd = csi_vopen (host, port, addr);
+        if (fd < 0)
+            tdlog ("CSIMC vars open addr %d: %s\n", addr, strerror(errno));
+        else
+            MIPVFD(mip) = fd;
+    }
 }
 
-/* close both channels in csii[] for mip.
- * N.B. assumes indeed open.
+/* close all channels in csii[] for mip.
+ * N.B. assumes cfd and sfd indeed open.
  */
 void
 csiiClose (MotorInfo *mip)
@@ -120,6 +139,47 @@ csiiClose (MotorInfo *mip)
 
     csiClose (MIPSFD(mip));
     MIPSFD(mip) = 0;
+
+    if (MIPVFD(mip)) {
+        csiClose (MIPVFD(mip));
+        MIPVFD(mip) = 0;
+    }
+}
+
+/* put the values of the n node variables refs[] for mip into vals[].
+ * use one binary GETVAR on vfd for them all if open, else evaluate each
+ * exprs[], such as "=epos;", on sfd. if GETVAR fails, or the node does not
+ * answer within PV_WAIT, vfd is closed and we use the exprs from then on.
+ */
+void
+csiGetVars (MotorInfo *mip, int n, CSIVar refs[], char *exprs[], int vals[])
+{
+    int i;
+
+    if (MIPVFD(mip)) {
+        int r[PV_MAXN];
+
+        for (i = 0; i < n; i++)
+            r[i] = refs[i];
+        if (csi_getvars (MIPVFD(mip), n, r, vals) == 0)
+            return;
+        tdlog ("CSIMC GETVAR %d on addr %d failed.. using shell\n", refs[0],
+                                                                mip->axis);
+        csiClose (MIPVFD(mip));
+        MIPVFD(mip) = 0;
+    }
+    for (i = 0; i < n; i++)
+        vals[i] = csi_rix (MIPSFD(mip), exprs[i]);
+}
+
+/* return the value of node variable ref for mip, as csiGetVars() */
+int
+csiGetVar (MotorInfo *mip, CSIVar ref, char *expr)
+{
+    int v;
+
+    csiGetVars (mip, 1, &ref, &expr, &v);
+    return (v);
 }
 
 /* return 1 if given csimcd fd can be read, else 0 */
@@ -192,6 +252,9 @@ csiSetup (MotorInfo *mip)
 
 	csi_w(cfd, "mtvel=0;");
 
+    /* the controller remembers being homed across our restarts */
+    mip->ishomed = csi_rix (cfd, "=isHomed();") == 1;
+
     // wait again before continuing
     tv.tv_sec = 0;
     tv.tv_usec = 250000;  // 250 ms wait
@@ -0,0 +1,158 @@
+/* help the field rotator follow the parallactic angle.
+ *
+ * the rotator profile is a list of positions at even time steps which the
+ * controller interpolates linearly. far from the zenith of an alt-az mount
+ * the angle changes smoothly and the usual track spacing is plenty, but close
+ * to it the angle swings round quickly, so we pick the spacing from how fast
+ * the rate itself is changing. right through the zenith the rate can exceed
+ * what the rotator can do at all, so the profile is limited to the rotator's
+ * speed by working back from the end: the rotator starts turning early and
+ * is already most of the way round when the field spins.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "telstatshm.h"
+#include "csimc.h"
+
+#include "teled.h"
+
+/* remove whole turns from r[n] so each is as close as possible to the one
+ * before. r[0] is not changed.
+ */
+void
+derotUnwrap (double r[], int n)
+{
+    int i;
+
+    for (i = 1; i < n; i++) {
+        double d = r[i] - r[i-1];
+        r[i] -= 2*PI*floor((d + PI)/(2*PI));
+    }
+}
+
+/* move all of unwrapped r[n] by the same whole turns so it lies strictly
+ * between the limits lo and hi, as close as possible to where it is. a run
+ * that spans too much to fit starts as low as it can and is held just short
+ * of hi from there, so the limits are never planned through.
+ * return 0 if it all fits, else -1.
+ */
+int
+derotFit (double r[], int n, double lo, double hi)
+{
+    double min, max, s, best;
+    int i, ret = 0;
+
+    if (n < 1)
+        return (0);
+    min = max = r[0];
+    for (i = 1; i < n; i++) {
+        if (r[i] < min)
+            min = r[i];
+        if (r[i] > max)
+            max = r[i];
+    }
+
+    /* lowest turn clear of lo, then the fitting one closest to no move */
+    s = 2*PI*(floor((lo - min)/(2*PI)) + 1);
+    if (max + s >= hi)
+        ret = -1;
+    best = s;
+    for (; max + s < hi; s += 2*PI)
+        if (fabs(s) < fabs(best))
+            best = s;
+
+    for (i = 0; i < n; i++) {
+        r[i] += best;
+        if (r[i] >= hi)
+            r[i] = hi - 1e-6;
+    }
+
+    return (ret);
+}
+
+/* given r[n] spaced dt secs apart, return the largest spacing, from mindt
+ * to dt, at which linear interpolation stays within tol rads.
+ */
+double
+derotStep (double r[], int n, double dt, double tol, double mindt)
+{
+    double maxacc = 0, step;
+    int i;
+
+    for (i = 1; i < n-1; i++) {
+        double acc = fabs(r[i+1] - 2*r[i] + r[i-1])/(dt*dt);
+        if (acc > maxacc)
+            maxacc = acc;
+    }
+    if (maxacc == 0)
+        return (dt);
+
+    /* a chord over step secs misses a curve by acc*step^2/8 */
+    step = sqrt (8*tol/maxacc);
+    if (step > dt)
+        step = dt;
+    if (step < mindt)
+        step = mindt;
+    return (step);
+}
+
+/* limit r[n], spaced dt secs apart, so it never changes faster than vmax.
+ * work back from the end first so any rotation too fast to follow is started
+ * early, then forward from r[0] in case it was moved.
+ * return the largest change made to any point, rads.
+ */
+double
+derotLimit (double r[], int n, double dt, double vmax)
+{
+    double maxd = vmax*dt;
+    double maxchg = 0;
+    int i;
+
+    for (i = n-2; i >= 0; i--) {
+        double r0 = r[i];
+        if (r[i] > r[i+1] + maxd)
+            r[i] = r[i+1] + maxd;
+        else if (r[i] < r[i+1] - maxd)
+            r[i] = r[i+1] - maxd;
+        if (fabs(r[i] - r0) > maxchg)
+            maxchg = fabs(r[i] - r0);
+    }
+
+    for (i = 1; i < n; i++) {
+        double r0 = r[i];
+        if (r[i] > r[i-1] + maxd)
+            r[i] = r[i-1] + maxd;
+        else if (r[i] < r[i-1] - maxd)
+            r[i] = r[i-1] - maxd;
+        if (fabs(r[i] - r0) > maxchg)
+            maxchg = fabs(r[i] - r0);
+    }
+
+    return (maxchg);
+}
+
+/* return r[n], spaced dt secs apart, at t secs after r[0], interpolated as the
+ * controller does. hold the ends outside the list.
+ */
+double
+derotAt (double r[], int n, double dt, double t)
+{
+    double f;
+    int i;
+
+    if (n < 1)
+        return (0.0);
+    if (t <= 0 || dt <= 0)
+        return (r[0]);
+    i = (int) floor (t/dt);
+    if (i >= n-1)
+        return (r[n-1]);
+    f = t/dt - i;
+    return (r[i] + f*(r[i+1] - r[i]));
+}
@@ -43,6 +43,7 @@ typedef struct {
  */
 static FifoInfo fifo[] = {
     {Tel_Id,	"Tel",        tel_msg},
+    {Guide_Id,	"Guide",      guide_msg},
 };
 #define	N_F	(sizeof(fifo)/sizeof(fifo[0]))
 
@@ -80,6 +81,10 @@ fifoWrite (FifoId f, int code, char *fmt, ...)
     if (n < 0)
         tdlog ("%s: %s", fip->name, errmsg);
 
+    /* and to the socket client that sent the command, if any */
+    if (f == Tel_Id)
+        sock_reply (code, buf);
+
     /* log too if looks like an error message */
     if (code < 0)
         tdlog ("%s: %s", fip->name, buf);
@@ -93,6 +98,9 @@ close_fifos()
 
     for (fip = fifo; fip < &fifo[N_F]; fip++)
         close_1fifo (fip);
+    close_socks();
+    close_stats();
+    close_reload();
 }
 
 /* create all the public points of contact */
@@ -100,6 +108,9 @@ void
 init_fifos()
 {
     open_fifos();
+    init_socks();
+    init_stats();
+    init_reload();
 }
 
 /* check for and dispatch all incoming messages.
@@ -112,6 +123,7 @@ chk_fifos()
     FifoInfo *fip;
     struct timeval tv;
     fd_set rfdset;
+    double t0;
     int maxfdp1;
     int i, s;
 
@@ -123,6 +135,9 @@ chk_fifos()
         if (fifo[i].fd[0] > maxfdp1)
             maxfdp1 = fifo[i].fd[0];
     }
+    sock_fdset (&rfdset, &maxfdp1);
+    stat_fdset (&rfdset, &maxfdp1);
+    reload_fdset (&rfdset, &maxfdp1);
     maxfdp1++;
 
     /* set up the max polling delay */
@@ -136,6 +151,7 @@ chk_fifos()
         tdlog ("select(): %s", strerror(errno));
         return;	/* main will repeat -- we don't wanna die */
     }
+    t0 = profNow();
 
     /* dispatch any fifo messages */
     for (fip = fifo; s > 0 && fip < &fifo[N_F]; fip++) {
@@ -154,19 +170,35 @@ chk_fifos()
             /* keep time current */
             set_shmtime();
 
-            /* dispatch */
-            (*fip->fp) (msg);
+            /* dispatch, Tel by way of the socket clients' queue */
+            if (fip->id == Tel_Id)
+                sock_fifocmd (msg);
+            else
+                (*fip->fp) (msg);
 
             /* handled this one */
             s--;
         }
     }
 
+    /* then any socket client commands */
+    if (s > 0) {
+        set_shmtime();
+        sock_read (&rfdset);
+        stat_read (&rfdset);
+        reload_read (&rfdset);
+    }
+
     /* then call each handler in polling mode (ie, w/o message) */
     for (fip = fifo; fip < &fifo[N_F]; fip++) {
         set_shmtime();			/* keep time current */
         (*fip->fp) (NULL);			/* general update poll */
     }
+
+    /* start waiting socket commands and report changes */
+    sock_poll();
+    stat_poll();
+    profStop (PS_CYCLE, t0);
 }
 
 /* create and attach all the fifos */
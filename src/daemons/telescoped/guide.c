@@ -0,0 +1,209 @@
+/* closed-loop guiding over its own fifo pair, Guide.
+ *
+ * an autoguider sends one line per measurement:
+ *   t dRA dDec
+ * where t is when the guide frame was taken, in secs since 1970 (0 means
+ * now), and dRA/dDec are the arcsecs on the sky to move the telescope to
+ * put the star back where it belongs. corrections may arrive at up to
+ * about 10 Hz; those that arrive within GUIDEDT of the last one applied are
+ * summed and applied together. each is turned into axis motion through the
+ * same mount model used for tracking, then added to the controller's xdel
+ * (xtrack axes) or toffset (others), one packet per axis. there is no
+ * trajectory upload, so tracking carries on undisturbed.
+ *
+ * each application is answered with one line giving the offset applied,
+ * how many corrections it combined, the latency from the oldest of them
+ * and the total guide offset so far:
+ *   0 dRA=x dDec=y n=k latency=ms total=x,y steps=h,d
+ * corrections are refused with -1 unless the telescope is tracking.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "misc.h"
+#include "telstatshm.h"
+#include "csimc.h"
+
+#include "teled.h"
+
+#define	GUIDEDT		0.1	/* min secs between applications */
+#define	MINCOSDEC	0.01	/* limit dRA magnification near the pole */
+
+static double pra, pdec;	/* pending correction, rads on sky */
+static double pt0;		/* time of oldest pending correction */
+static int npend;		/* corrections pending */
+static double tlast;		/* when last applied */
+static double tra, tdec;	/* total applied this track, rads on sky */
+static double hres, dres;	/* fractional steps not yet applied */
+static int trackidx = -1;	/* telstateidx the totals refer to */
+
+static double tvNow (void);
+static void applyGuide (void);
+static double axisScale (MotorInfo *mip);
+static double wrapPI (double a);
+static int axisDelta (double dra, double ddec, double *dxp, double *dyp);
+
+/* called with each message from the Guide fifo, and with NULL to poll */
+void
+guide_msg (char *msg)
+{
+    double t, a, d;
+
+    if (msg) {
+        if (sscanf (msg, "%lf %lf %lf", &t, &a, &d) != 3) {
+            fifoWrite (Guide_Id, -1, "Expecting: t dRA dDec");
+            return;
+        }
+        if (telstatshmp->telstate != TS_TRACKING) {
+            fifoWrite (Guide_Id, -1, "Telescope is not tracking -- ignored");
+            npend = 0;
+            return;
+        }
+        if (t <= 0)
+            t = tvNow();
+        if (!npend || t < pt0)
+            pt0 = t;
+        if (!npend)
+            pra = pdec = 0;
+        pra += degrad (a/3600.);
+        pdec += degrad (d/3600.);
+        npend++;
+    }
+
+    if (npend && tvNow() - tlast >= GUIDEDT)
+        applyGuide();
+}
+
+/* apply the pending correction and report */
+static void
+applyGuide()
+{
+    TelStatShm *tsp = telstatshmp;
+    MotorInfo *mip;
+    double dx, dy, ds;
+    int hsteps, dsteps;
+    int n = npend;
+    double now;
+
+    npend = 0;
+    if (tsp->telstate != TS_TRACKING) {
+        fifoWrite (Guide_Id, -1, "Telescope is not tracking -- ignored");
+        return;
+    }
+
+    /* new track starts with the controllers' offsets at 0 */
+    if (tsp->telstateidx != trackidx && !tsp->jogging_ison) {
+        trackidx = tsp->telstateidx;
+        tra = tdec = hres = dres = 0;
+    }
+
+    if (axisDelta (pra, pdec, &dx, &dy) < 0) {
+        fifoWrite (Guide_Id, -1, "Can not map correction onto the axes");
+        return;
+    }
+
+    /* one packet per axis, carrying leftover fractional steps forward */
+    hsteps = dsteps = 0;
+    mip = HMOT;
+    if (mip->have) {
+        ds = dx*axisScale(mip) + hres;
+        hsteps = (int) floor (ds + .5);
+        hres = ds - hsteps;
+        if (hsteps)
+            csi_w (MIPCFD(mip), mip->xtrack ? "xdel += %d;" : "toffset += %d;",
+                                                                    hsteps);
+    }
+    mip = DMOT;
+    if (mip->have) {
+        ds = dy*axisScale(mip) + dres;
+        dsteps = (int) floor (ds + .5);
+        dres = ds - dsteps;
+        if (dsteps)
+            csi_w (MIPCFD(mip), mip->xtrack ? "xdel += %d;" : "toffset += %d;",
+                                                                    dsteps);
+    }
+
+    /* publish like the other jog paths */
+    tra += pra;
+    tdec += pdec;
+    tsp->jdha = -tra;
+    tsp->jddec = tdec;
+    tsp->jogging_ison = 1;
+    trackidx = tsp->telstateidx;
+
+    now = tvNow();
+    tlast = now;
+    fifoWrite (Guide_Id, 0,
+        "dRA=%.2f dDec=%.2f n=%d latency=%.0f total=%.2f,%.2f steps=%d,%d",
+        raddeg(pra)*3600, raddeg(pdec)*3600, n,
+        (now - pt0)*1000, raddeg(tra)*3600, raddeg(tdec)*3600, hsteps, dsteps);
+}
+
+/* find the change in axis positions, rads, for moving the telescope dra and
+ * ddec on the sky from where it is now tracking.
+ * use the real mount model so it's right for flips and nonperpendicularity.
+ * return 0 if ok, else -1.
+ */
+static int
+axisDelta (double dra, double ddec, double *dxp, double *dyp)
+{
+    TelStatShm *tsp = telstatshmp;
+    TelAxes ta0 = tsp->tax, ta = tsp->tax;
+    double ha = tsp->DAHA, dec = tsp->DADec;
+    double x0, y0, x1, y1;
+    double cd = cos (dec);
+
+    if (fabs(cd) < MINCOSDEC)
+        cd = cd < 0 ? -MINCOSDEC : MINCOSDEC;
+
+    tel_hadec2xy (ha, dec, &ta0, &x0, &y0);
+    tel_ideal2realxy (&ta0, &x0, &y0);
+
+    ha -= dra/cd;		/* moving E in RA means less HA */
+    dec += ddec;
+    hdRange (&ha, &dec);
+    tel_hadec2xy (ha, dec, &ta, &x1, &y1);
+    tel_ideal2realxy (&ta, &x1, &y1);
+
+    /* a flip between the two would be no small correction */
+    if (ta.GERMEQ_FLIP != ta0.GERMEQ_FLIP)
+        return (-1);
+
+    *dxp = wrapPI (x1 - x0);
+    *dyp = wrapPI (y1 - y0);
+    return (0);
+}
+
+/* return a reduced to the range -PI .. PI */
+static double
+wrapPI (double a)
+{
+    return (a - 2*PI*floor((a + PI)/(2*PI)));
+}
+
+/* canonical rads to controller steps for mip, as jogTrack() */
+static double
+axisScale (MotorInfo *mip)
+{
+    if (mip->haveenc)
+        return (mip->esign * mip->estep / (2*PI));
+    return (mip->sign * mip->step / (2*PI));
+}
+
+/* secs since 1970 */
+static double
+tvNow()
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return (tv.tv_sec + tv.tv_usec*1e-6);
+}
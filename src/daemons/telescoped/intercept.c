@@ -0,0 +1,126 @@
+/* time-optimal single axis trajectories for intercepting a moving target.
+ *
+ * an axis starts at rest and must arrive at a given position moving at a
+ * given velocity, keeping within its maxvel and maxacc. the fastest way is
+ * full acceleration toward a peak velocity, an optional cruise at maxvel,
+ * then full acceleration to the final velocity. to arrive at a later time
+ * it just waits at the start first.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "telstatshm.h"
+#include "csimc.h"
+
+#include "teled.h"
+
+#define	ISLOP	1e-6	/* secs by which a plan may come up short */
+
+static int minTime (MotorInfo *mip, double d, double v1, AxisTraj *tp);
+
+/* return the least secs for the mip axis to move d rads from rest and be
+ * moving at v1 rads/sec when it gets there, or -1 if it can never go that
+ * fast.
+ */
+double
+axisMinTime (MotorInfo *mip, double d, double v1)
+{
+    AxisTraj t;
+
+    if (minTime (mip, d, v1, &t) < 0)
+        return (-1.0);
+    return (t.tw + t.t1 + t.t2 + t.t3);
+}
+
+/* plan a trajectory for the mip axis to go from x0 at rest at time 0 to x1
+ * moving at v1 at time T.
+ * return 0 if ok, else -1 if it can not get there in time.
+ */
+int
+axisPlan (MotorInfo *mip, double x0, double x1, double v1, double T,
+AxisTraj *tp)
+{
+    double tmin;
+
+    if (minTime (mip, x1 - x0, v1, tp) < 0)
+        return (-1);
+    tmin = tp->t1 + tp->t2 + tp->t3;
+    if (tmin > T + ISLOP)
+        return (-1);
+    tp->x0 = x0;
+    tp->tw = tmin < T ? T - tmin : 0;
+    return (0);
+}
+
+/* return the position of the axis following tp at t secs after it starts.
+ * after the end it carries on at the final velocity.
+ */
+double
+axisTrajPos (AxisTraj *tp, double t)
+{
+    double a = tp->a, vp = tp->vp;
+    double p1, p2, p3;
+
+    t -= tp->tw;
+    if (t <= 0)
+        return (tp->x0);
+
+    p1 = a*tp->t1*tp->t1/2;
+    if (t < tp->t1)
+        return (tp->x0 + tp->s*(a*t*t/2));
+    t -= tp->t1;
+
+    p2 = p1 + vp*tp->t2;
+    if (t < tp->t2)
+        return (tp->x0 + tp->s*(p1 + vp*t));
+    t -= tp->t2;
+
+    if (t < tp->t3)
+        return (tp->x0 + tp->s*(p2 + vp*t - a*t*t/2));
+    t -= tp->t3;
+
+    p3 = p2 + vp*tp->t3 - a*tp->t3*tp->t3/2;
+    return (tp->x0 + tp->s*(p3 + tp->v1*t));
+}
+
+/* find the fastest profile from rest to d with final velocity v1.
+ * fill in all of *tp except x0, with tw 0.
+ * return 0 if ok, else -1 if v1 exceeds maxvel or mip can't move.
+ */
+static int
+minTime (MotorInfo *mip, double d, double v1, AxisTraj *tp)
+{
+    double a = mip->maxacc, vm = mip->maxvel;
+    double vp, dpk;
+
+    if (a <= 0 || vm <= 0 || fabs(v1) > vm)
+        return (-1);
+
+    /* work in the direction the peak velocity will be */
+    tp->s = d >= v1*fabs(v1)/(2*a) ? 1 : -1;
+    d *= tp->s;
+    v1 *= tp->s;
+
+    /* d = vp^2/2a + (vp^2 - v1^2)/2a, unless that exceeds maxvel */
+    vp = sqrt (a*d + v1*v1/2);
+    if (vp <= vm) {
+        tp->t2 = 0;
+    } else {
+        vp = vm;
+        dpk = vm*vm/(2*a) + (vm*vm - v1*v1)/(2*a);
+        tp->t2 = (d - dpk)/vm;
+    }
+
+    tp->a = a;
+    tp->vp = vp;
+    tp->v1 = v1;
+    tp->tw = 0;
+    tp->t1 = vp/a;
+    tp->t3 = (vp - v1)/a;
+    return (0);
+}
@@ -0,0 +1,120 @@
+/* time the stages of the control loop.
+ *
+ * each stage is timed with the monotonic clock from profNow() to
+ * profStop() and the times are gathered into a histogram of loghist.h, so
+ * it costs little enough to leave on all the time.
+ * stages may nest, each is the total time inside it. once a sec a summary
+ * of each is put in telstatshmp->prof[], and profLog() gives the whole
+ * thing to the log and optionally the Tel fifo.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "telstatshm.h"
+#include "csimc.h"
+#include "loghist.h"
+
+#include "teled.h"
+
+#define	PSHMINT		1.0	/* secs between updates to telstatshmp */
+
+/* what we know about one stage */
+typedef struct {
+    char *name;			/* for reports */
+    LogHist h;			/* its times */
+} ProfStat;
+
+/* N.B. must be in the same order as ProfStage */
+static ProfStat pstat[PS_N] = {
+    {"cycle"}, {"readRaw"}, {"clock"}, {"mkCook"},
+    {"findAxes"}, {"buildTrack"}, {"buildXTrack"}, {"log"},
+};
+
+static double pshmt;		/* when telstatshmp->prof[] was last set */
+
+static void profShm (void);
+
+/* secs from some arbitrary but steady epoch */
+double
+profNow()
+{
+    return (lhNow());
+}
+
+/* add the time from t0 until now to stage s.
+ * the whole cycle also updates telstatshmp now and then.
+ */
+void
+profStop (ProfStage s, double t0)
+{
+    double now = profNow();
+
+    lhAdd (&pstat[s].h, now - t0);
+
+    if (s == PS_CYCLE && now - pshmt >= PSHMINT) {
+        profShm();
+        pshmt = now;
+    }
+}
+
+/* log the profile of each stage, and report them too if fifo */
+void
+profLog (int fifo)
+{
+    ProfStat *psp;
+
+    for (psp = pstat; psp < &pstat[PS_N]; psp++) {
+        LogHist *hp = &psp->h;
+        char buf[512];
+        int b, l;
+
+        if (!hp->n)
+            continue;
+        /* snprintf() says what it would have written, so stop once full */
+        l = snprintf (buf, sizeof(buf), "%-11s n=%u mean=%.3fms p50=%.3fms "
+            "p99=%.3fms max=%.3fms hist", psp->name, hp->n,
+            1e3*hp->sum/hp->n, 1e3*lhQuantile(hp, .5),
+            1e3*lhQuantile(hp, .99), 1e3*hp->max);
+        for (b = 0; b < LH_NBUCKET && l < (int)sizeof(buf); b++)
+            if (hp->hist[b])
+                l += snprintf (buf+l, sizeof(buf)-l, " <%.0fus:%u",
+                                            ldexp(1.0, b+1), hp->hist[b]);
+        tdlog ("%s", buf);
+        if (fifo)
+            fifoWrite (Tel_Id, 1, "%s", buf);
+    }
+}
+
+/* start again */
+void
+profReset()
+{
+    ProfStat *psp;
+
+    for (psp = pstat; psp < &pstat[PS_N]; psp++)
+        memset ((void *)&psp->h, 0, sizeof(psp->h));
+    profShm();
+}
+
+/* put a summary of each stage in telstatshmp */
+static void
+profShm()
+{
+    int s;
+
+    for (s = 0; s < PS_N && s < TEL_NPROF; s++) {
+        LogHist *hp = &pstat[s].h;
+        ProfInfo *pip = &telstatshmp->prof[s];
+
+        pip->n = hp->n;
+        pip->mean = hp->n ? hp->sum/hp->n : 0;
+        pip->p99 = lhQuantile (hp, .99);
+        pip->max = hp->max;
+    }
+}
@@ -0,0 +1,288 @@
+/* reload the config entries that may change while tracking.
+ *
+ * archive/config is watched with inotify. when telescoped.cfg, telsched.cfg
+ * or telescoped.mesh is written, each name=value pair of the .cfg file is
+ * compared with what it was at the last Reset, as cfgSnap() kept it. if
+ * only entries in its safe[] list changed, those are read and used at once,
+ * between control cycles, and nothing stops. if any entry that needs a Reset
+ * changed, nothing in that file is used and the log says which; that file is
+ * compared with the same pairs next time, so putting them back makes it
+ * acceptable again. the mesh may always change, in either form, it goes with
+ * PTGRAD.
+ *
+ * optional in telescoped.cfg: HOTRELOAD 0 turns it all off.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/inotify.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "configfile.h"
+#include "strops.h"
+#include "telenv.h"
+#include "telstatshm.h"
+#include "csimc.h"
+
+#include "teled.h"
+
+/* one file we watch */
+typedef struct {
+    char *fn;			/* name from TELHOME */
+    char **safe;		/* names which may change while tracking */
+    char **stop;		/* names which need a Reset, NULL for all others */
+    int (*apply)(void);		/* read and use the safe ones, 0 if ok */
+    int snap;			/* set to compare pairs with was */
+    CfgSnap *was;		/* pairs as of last Reset */
+    int changed;		/* set when written */
+} WatchFile;
+
+/* what reload1() finds comparing one file with its snapshot */
+typedef struct {
+    WatchFile *wfp;		/* file being compared */
+    CfgSnap *other;		/* snapshot the pairs are looked up in */
+    int gone;			/* set if only names not in other count */
+    char safebuf[512];		/* " name" of each safe one changed */
+    char stopbuf[512];		/* " name" of each changed that needs Reset */
+    int nsafe, nstop;		/* count of each */
+} SnapDiff;
+
+static char *tdsafe[] = {
+    "TRACKINT", "TRACKACC", "FGUIDEVEL", "CGUIDEVEL", "XTRACKHORIZON",
+    "XTRACKBATCH", "XTRACKRELAX", "XTRACKJIT", "LIMITSKEEP", NULL
+};
+static char *tssafe[] = {
+    "PTGRAD", NULL
+};
+static char *tsstop[] = {	/* the rest are not ours, see init_cfg() */
+    "STOWALT", "STOWAZ", "LONGITUDE", "LATITUDE", "TEMPERATURE", "PRESSURE",
+    "ELEVATION", NULL
+};
+
+static WatchFile wfiles[] = {
+    {tdcfn,	tdsafe,	NULL,	tel_reload,		1},
+    {tscfn,	tssafe,	tsstop,	reload_mount_cor,	1},
+    {meshfn,	NULL,	NULL,	reload_mount_cor,	0},
+    {mbinfn,	NULL,	NULL,	reload_mount_cor,	0},
+};
+#define	NWFILES	(sizeof(wfiles)/sizeof(wfiles[0]))
+
+static char cfgdir[] = "archive/config";
+static int ifd = -1;		/* inotify fd, -1 if not watching */
+
+static void reload1 (WatchFile *wfp);
+static int diff1 (char *name, char *value, void *arg);
+static int onList (char **list, char *name);
+static void addName (char buf[], int *lp, int max, char *name);
+
+/* start watching, unless HOTRELOAD says not to.
+ * not fatal if trouble.
+ */
+void
+init_reload()
+{
+    int HOTRELOAD = 1;
+    char path[1024];
+
+    (void) read1CfgEntry (1, tdcfn, "HOTRELOAD", CFG_INT, &HOTRELOAD, 0);
+    if (!HOTRELOAD)
+        return;
+
+    ifd = inotify_init1 (IN_NONBLOCK|IN_CLOEXEC);
+    if (ifd < 0) {
+        tdlog ("inotify_init1(): %s", strerror(errno));
+        return;
+    }
+    telfixpath (path, cfgdir);
+    if (inotify_add_watch (ifd, path, IN_CLOSE_WRITE|IN_MOVED_TO) < 0) {
+        tdlog ("%s: %s", path, strerror(errno));
+        close (ifd);
+        ifd = -1;
+    }
+}
+
+/* stop watching */
+void
+close_reload()
+{
+    WatchFile *wfp;
+
+    if (ifd >= 0) {
+        close (ifd);
+        ifd = -1;
+    }
+    for (wfp = wfiles; wfp < &wfiles[NWFILES]; wfp++) {
+        cfgSnapFree (wfp->was);
+        wfp->was = NULL;
+    }
+}
+
+/* note the pairs in each file as they are now, as they have all just been
+ * read for a Reset.
+ */
+void
+reload_snap()
+{
+    WatchFile *wfp;
+
+    if (ifd < 0)
+        return;
+    for (wfp = wfiles; wfp < &wfiles[NWFILES]; wfp++) {
+        if (!wfp->snap)
+            continue;
+        cfgSnapFree (wfp->was);
+        wfp->was = cfgSnap (wfp->fn);
+        wfp->changed = 0;
+    }
+}
+
+/* add our fd to *fsp for reading and raise *maxfdp if need be */
+void
+reload_fdset (fd_set *fsp, int *maxfdp)
+{
+    if (ifd < 0)
+        return;
+    FD_SET (ifd, fsp);
+    if (ifd > *maxfdp)
+        *maxfdp = ifd;
+}
+
+/* if our fd in *fsp is ready, see which files changed and reload them */
+void
+reload_read (fd_set *fsp)
+{
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    WatchFile *wfp;
+    int n;
+
+    if (ifd < 0 || !FD_ISSET (ifd, fsp))
+        return;
+
+    /* gather all that have changed so each is only reloaded once */
+    while ((n = read (ifd, buf, sizeof(buf))) > 0) {
+        char *p;
+
+        for (p = buf; p < buf + n; ) {
+            struct inotify_event *ep = (struct inotify_event *)p;
+
+            for (wfp = wfiles; wfp < &wfiles[NWFILES]; wfp++)
+                if ((ep->mask & IN_Q_OVERFLOW) || (ep->len
+                                && !strcmp (ep->name, basenm(wfp->fn))))
+                    wfp->changed = 1;
+            p += sizeof(struct inotify_event) + ep->len;
+        }
+    }
+    if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        tdlog ("%s: %s", cfgdir, strerror(errno));
+        close_reload();
+        return;
+    }
+
+    for (wfp = wfiles; wfp < &wfiles[NWFILES]; wfp++) {
+        if (wfp->changed) {
+            wfp->changed = 0;
+            reload1 (wfp);
+        }
+    }
+}
+
+/* compare the pairs of wfp with its snapshot and reload it if we may */
+static void
+reload1 (WatchFile *wfp)
+{
+    char *bn = basenm (wfp->fn);
+    SnapDiff d;
+    CfgSnap *now;
+
+    if (!wfp->snap) {
+        if ((*wfp->apply)() == 0)
+            tdlog ("%s: reloaded", bn);
+        else
+            tdlog ("%s: not reloaded", bn);
+        return;
+    }
+
+    now = cfgSnap (wfp->fn);
+    if (!now) {
+        tdlog ("%s: %s", bn, strerror(errno));
+        return;
+    }
+
+    /* list each name that is new or different, then each that is gone */
+    memset (&d, 0, sizeof(d));
+    d.wfp = wfp;
+    d.other = wfp->was;
+    (void) cfgSnapEach (now, diff1, &d);
+    if (wfp->was) {
+        d.other = now;
+        d.gone = 1;
+        (void) cfgSnapEach (wfp->was, diff1, &d);
+    }
+
+    if (d.nstop) {
+        tdlog ("%s: not reloaded, Reset needed for%s", bn, d.stopbuf);
+        cfgSnapFree (now);
+        return;
+    }
+    if (!d.nsafe) {
+        cfgSnapFree (now);
+        return;
+    }
+    if ((*wfp->apply)() < 0) {
+        tdlog ("%s: not reloaded", bn);
+        cfgSnapFree (now);
+        return;
+    }
+
+    tdlog ("%s: reloaded%s", bn, d.safebuf);
+    cfgSnapFree (wfp->was);
+    wfp->was = now;
+}
+
+/* cfgSnapEach() function for reload1(): note name if its value differs in
+ * the other snapshot, or if only gone ones count and it is not there at all.
+ */
+static int
+diff1 (char *name, char *value, void *arg)
+{
+    SnapDiff *dp = (SnapDiff *)arg;
+    char *other = dp->other ? cfgSnapValue (dp->other, name) : NULL;
+
+    if (dp->gone ? other != NULL : other && !strcmp (other, value))
+        return (0);
+
+    if (onList (dp->wfp->safe, name))
+        addName (dp->safebuf, &dp->nsafe, sizeof(dp->safebuf), name);
+    else if (!dp->wfp->stop || onList (dp->wfp->stop, name))
+        addName (dp->stopbuf, &dp->nstop, sizeof(dp->stopbuf), name);
+    return (0);
+}
+
+/* return 1 if name is in the NULL-terminated list, else 0 */
+static int
+onList (char **list, char *name)
+{
+    if (list)
+        for (; *list; list++)
+            if (!strcasecmp (*list, name))
+                return (1);
+    return (0);
+}
+
+/* add " name" to buf[max] if there is room, and count it in *lp */
+static void
+addName (char buf[], int *lp, int max, char *name)
+{
+    int l = strlen (buf);
+
+    if (l + strlen(name) + 2 < max)
+        sprintf (buf+l, " %s", name);
+    (*lp)++;
+}
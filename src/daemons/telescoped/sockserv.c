@@ -0,0 +1,547 @@
+/* serve several clients at once over a Unix-domain stream socket.
+ *
+ * the socket is comm/Tel.sock, next to the Tel fifos. each client sends the
+ * same ASCII commands as the Tel fifo, one per line, and receives the same
+ * "code message" responses, one per line. commands from all clients, and
+ * from the fifo, are run one at a time in the order they arrive: a queued
+ * command is handed to tel_msg() only once the one before it has sent its
+ * final response (code <= 0). a few commands can not wait:
+ *   Stop		run at once; all queued commands are dropped
+ *   j*, Offset, xdelta	paddle and guiding, run at once
+ * Stop, and any command from the fifo, preempts any other client's
+ * unfinished command, just as a new fifo command always has. paddle and
+ * guiding commands preempt nothing: their responses go to their own client
+ * and the command already running carries on. a running command is given
+ * up, and the queue moves on, if its client goes away or it has not
+ * finished after SQMAXRUN seconds.
+ *
+ * a few more commands are answered here without involving tel_msg() or the
+ * controllers at all:
+ *   status		one line of state from the latest TelStatShm snapshot
+ *   subscribe		push events when things change, see chkEvents()
+ *   unsubscribe	stop pushing events
+ * events are lines beginning with "! ", so they can not be mistaken for
+ * the response to a command.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "configfile.h"
+#include "misc.h"
+#include "telenv.h"
+#include "telstatshm.h"
+#include "csimc.h"
+
+#include "teled.h"
+
+#define	MAXLINE		1024	/* max message from a client */
+#define	MAXSCLI		16	/* max clients connected at once */
+#define	MAXSQ		32	/* max commands waiting to run */
+#define	NOCLI		(-1)	/* owner when command came from the fifo */
+#define	SQMAXRUN	600	/* secs a command may run before queue moves on */
+
+/* info about one client connection */
+typedef struct {
+    int fd;			/* connection, or -1 if slot is unused */
+    int subscribe;		/* set to receive events */
+    int nbuf;			/* chars in buf[] */
+    char buf[MAXLINE];		/* partial command line */
+} SockCli;
+
+/* one command waiting its turn */
+typedef struct {
+    int cli;			/* index into scli[] */
+    char msg[MAXLINE];		/* command */
+} SockCmd;
+
+static char sockname[] = "comm/Tel.sock";
+static int lfd = -1;		/* listening socket */
+static SockCli scli[MAXSCLI];	/* clients */
+static SockCmd sq[MAXSQ];	/* commands waiting to run, oldest first */
+static int nsq;			/* n entries in sq[] */
+static int owner = NOCLI;	/* client of the current command */
+static int running;		/* set until current command sends code <= 0 */
+static time_t runstart;		/* when the running command started */
+static int aside;		/* set while tel_msg() runs a paddle command */
+static int asidecli;		/* client of that command, or NOCLI */
+
+/* what subscribers last heard */
+static TelState evstate;
+static int evstateidx;
+static int evontarget;
+static int evlim[TEL_NM];
+
+static char *statename[] = {
+    "Absent", "Stopped", "Hunting", "Tracking", "Slewing", "Homing",
+    "Limiting"
+};
+
+static void accept1 (void);
+static void read1 (int c);
+static void line1 (int c, char *line);
+static void close1 (int c);
+static void send1 (int c, char *fmt, ...);
+static void sendEvent (char *fmt, ...);
+static void dispatch (int c, char *msg);
+static void flushQueue (char *why);
+static void runQueue (void);
+static void chkEvents (void);
+static void sayStatus (int c);
+static int isImmediate (char *msg);
+static int isAside (char *msg);
+static int limBits (MotorInfo *mip);
+
+/* create the listening socket.
+ * not fatal if trouble, we still have the fifo.
+ */
+void
+init_socks()
+{
+    struct sockaddr_un sun;
+    char path[1024];
+    int i;
+
+    for (i = 0; i < MAXSCLI; i++)
+        scli[i].fd = -1;
+    evstate = telstatshmp->telstate;
+    evstateidx = telstatshmp->telstateidx;
+
+    telfixpath (path, sockname);
+    if (strlen(path) >= sizeof(sun.sun_path)) {
+        tdlog ("%s: path too long", path);
+        return;
+    }
+    (void) unlink (path);
+
+    lfd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        tdlog ("socket(): %s", strerror(errno));
+        return;
+    }
+    memset ((void *)&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    strcpy (sun.sun_path, path);
+    if (bind (lfd, (struct sockaddr *)&sun, sizeof(sun)) < 0
+                                                || listen (lfd, MAXSCLI) < 0) {
+        tdlog ("%s: %s", path, strerror(errno));
+        close (lfd);
+        lfd = -1;
+        return;
+    }
+    (void) fcntl (lfd, F_SETFL, O_NONBLOCK);
+
+    /* cooperate with teloper group, as the fifos */
+    (void) chmod (path, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP);
+}
+
+/* close the listening socket and all clients */
+void
+close_socks()
+{
+    char path[1024];
+    int i;
+
+    for (i = 0; i < MAXSCLI; i++)
+        if (scli[i].fd >= 0)
+            close1 (i);
+    if (lfd >= 0) {
+        close (lfd);
+        lfd = -1;
+        telfixpath (path, sockname);
+        (void) unlink (path);
+    }
+}
+
+/* add our fds to *fsp for reading and raise *maxfdp to the largest */
+void
+sock_fdset (fd_set *fsp, int *maxfdp)
+{
+    int i;
+
+    if (lfd < 0)
+        return;
+    FD_SET (lfd, fsp);
+    if (lfd > *maxfdp)
+        *maxfdp = lfd;
+    for (i = 0; i < MAXSCLI; i++) {
+        int fd = scli[i].fd;
+        if (fd >= 0) {
+            FD_SET (fd, fsp);
+            if (fd > *maxfdp)
+                *maxfdp = fd;
+        }
+    }
+}
+
+/* handle any of our fds in *fsp that are ready to read */
+void
+sock_read (fd_set *fsp)
+{
+    int i;
+
+    if (lfd < 0)
+        return;
+    for (i = 0; i < MAXSCLI; i++)
+        if (scli[i].fd >= 0 && FD_ISSET (scli[i].fd, fsp))
+            read1 (i);
+    if (FD_ISSET (lfd, fsp))
+        accept1();
+}
+
+/* called after each tel_msg(NULL) poll: tell subscribers what changed then
+ * start the next queued command if the current one is finished.
+ */
+void
+sock_poll()
+{
+    if (lfd < 0)
+        return;
+    chkEvents();
+    runQueue();
+}
+
+/* called with each command from the Tel fifo, in place of tel_msg() */
+void
+sock_fifocmd (char *msg)
+{
+    dispatch (NOCLI, msg);
+}
+
+/* called by fifoWrite() with every Tel response.
+ * pass it to the client whose command is running, if any, and note when
+ * that command is finished. responses while a paddle command runs are its
+ * own. limit hits are also events.
+ */
+void
+sock_reply (int code, char *msg)
+{
+    if (aside) {
+        if (asidecli != NOCLI)
+            send1 (asidecli, "%d %s", code, msg);
+    } else {
+        if (owner != NOCLI)
+            send1 (owner, "%d %s", code, msg);
+        if (code <= 0)
+            running = 0;
+    }
+    if (code <= -2 && code >= -4)
+        sendEvent ("limit %d %s", code, msg);
+}
+
+/* accept a new client */
+static void
+accept1()
+{
+    int fd, i;
+
+    fd = accept (lfd, NULL, NULL);
+    if (fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            tdlog ("accept(): %s", strerror(errno));
+        return;
+    }
+
+    for (i = 0; i < MAXSCLI; i++)
+        if (scli[i].fd < 0)
+            break;
+    if (i == MAXSCLI) {
+        tdlog ("%s: more than %d clients", sockname, MAXSCLI);
+        close (fd);
+        return;
+    }
+
+    (void) fcntl (fd, F_SETFL, O_NONBLOCK);
+    scli[i].fd = fd;
+    scli[i].subscribe = 0;
+    scli[i].nbuf = 0;
+}
+
+/* read whatever client c has sent and act on each complete line */
+static void
+read1 (int c)
+{
+    SockCli *sp = &scli[c];
+    char *bp, *nl;
+    int n;
+
+    n = read (sp->fd, sp->buf + sp->nbuf, sizeof(sp->buf) - 1 - sp->nbuf);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
+    if (n <= 0) {
+        close1 (c);
+        return;
+    }
+    sp->nbuf += n;
+    sp->buf[sp->nbuf] = '\0';
+
+    bp = sp->buf;
+    while ((nl = strchr (bp, '\n')) != NULL) {
+        *nl = '\0';
+        if (nl > bp && nl[-1] == '\r')
+            nl[-1] = '\0';
+        line1 (c, bp);
+        if (sp->fd < 0)
+            return;		/* dropped while replying */
+        bp = nl + 1;
+    }
+
+    /* keep any partial line, discard one that can never fit */
+    sp->nbuf -= bp - sp->buf;
+    if (sp->nbuf == sizeof(sp->buf) - 1) {
+        send1 (c, "-1 Command too long");
+        sp->nbuf = 0;
+    } else
+        memmove (sp->buf, bp, sp->nbuf);
+}
+
+/* act on one command line from client c */
+static void
+line1 (int c, char *line)
+{
+    while (*line == ' ' || *line == '\t')
+        line++;
+    if (*line == '\0')
+        return;
+
+    if (strcasecmp (line, "status") == 0)
+        sayStatus (c);
+    else if (strcasecmp (line, "subscribe") == 0) {
+        scli[c].subscribe = 1;
+        send1 (c, "0 Subscribed");
+    } else if (strcasecmp (line, "unsubscribe") == 0) {
+        scli[c].subscribe = 0;
+        send1 (c, "0 Unsubscribed");
+    } else if (isImmediate (line) || (!running && nsq == 0))
+        dispatch (c, line);
+    else if (nsq == MAXSQ)
+        send1 (c, "-1 Too many commands waiting");
+    else {
+        sq[nsq].cli = c;
+        strcpy (sq[nsq].msg, line);
+        nsq++;
+        send1 (c, "1 Queued, %d ahead", nsq - 1 + running);
+    }
+}
+
+/* hand msg from client c (or NOCLI for the fifo) to tel_msg().
+ * paddle commands leave the running command, and its owner, alone.
+ */
+static void
+dispatch (int c, char *msg)
+{
+    if (isAside (msg)) {
+        aside = 1;
+        asidecli = c;
+        tel_msg (msg);
+        aside = 0;
+        return;
+    }
+
+    /* anyone still waiting on a command is now out of luck */
+    if (running && owner != c && owner != NOCLI)
+        send1 (owner, "-1 Preempted by another command");
+
+    if (strncasecmp (msg, "stop", 4) == 0)
+        flushQueue ("Stopped");
+
+    owner = c;
+    running = 1;
+    runstart = time (NULL);
+    tel_msg (msg);
+}
+
+/* drop all waiting commands, telling each owner why.
+ * N.B. send1() may drop a client, and with it entries in sq[], so work
+ * from a copy.
+ */
+static void
+flushQueue (char *why)
+{
+    SockCmd fq[MAXSQ];
+    int i, n;
+
+    n = nsq;
+    memcpy (fq, sq, n * sizeof(sq[0]));
+    nsq = 0;
+
+    for (i = 0; i < n; i++)
+        send1 (fq[i].cli, "-1 %s before \"%s\" could run", why, fq[i].msg);
+}
+
+/* start the oldest waiting command if nothing is running */
+static void
+runQueue()
+{
+    SockCmd cmd;
+
+    if (running && time (NULL) - runstart > SQMAXRUN) {
+        tdlog ("Tel.sock: giving up on command after %d secs", SQMAXRUN);
+        if (owner != NOCLI)
+            send1 (owner, "-1 No response after %d secs", SQMAXRUN);
+        running = 0;
+    }
+    if (running || nsq == 0)
+        return;
+    cmd = sq[0];
+    memmove (&sq[0], &sq[1], --nsq * sizeof(sq[0]));
+    dispatch (cmd.cli, cmd.msg);
+}
+
+/* tell subscribers about any change in state, tracking or limits */
+static void
+chkEvents()
+{
+    TelStatShm *tsp = telstatshmp;
+    int ontarget;
+    int i;
+
+    if (tsp->telstate != evstate || tsp->telstateidx != evstateidx) {
+        evstate = tsp->telstate;
+        evstateidx = tsp->telstateidx;
+        sendEvent ("telstate %s %d", statename[evstate], evstateidx);
+    }
+
+    ontarget = tsp->telstate == TS_TRACKING;
+    if (ontarget != evontarget) {
+        evontarget = ontarget;
+        sendEvent ("ontarget %d", ontarget);
+    }
+
+    for (i = 0; i < TEL_NM; i++) {
+        MotorInfo *mip = &tsp->minfo[i];
+        int l = limBits (mip);
+
+        if (l != evlim[i]) {
+            evlim[i] = l;
+            sendEvent ("limits %d homed=%d homing=%d limiting=%d", i,
+                            !!mip->ishomed, !!mip->homing, !!mip->limiting);
+        }
+    }
+}
+
+/* pack the homing and limits flags of mip so changes are easy to spot.
+ * N.B. they are 1-bit signed fields, so they read as -1 when set.
+ */
+static int
+limBits (MotorInfo *mip)
+{
+    if (!mip->have)
+        return (0);
+    return (1 | !!mip->ishomed << 1 | !!mip->homing << 2 | !!mip->limiting << 3);
+}
+
+/* answer a status query from a snapshot of telstatshmp */
+static void
+sayStatus (int c)
+{
+    TelStatShm ts;
+
+    ts = *telstatshmp;
+    send1 (c, "0 state=%s idx=%d ontarget=%d jog=%d homed=%d,%d,%d "
+        "mjd=%.6f ra=%.6f dec=%.6f ha=%.6f alt=%.6f az=%.6f "
+        "dra=%.6f ddec=%.6f dalt=%.6f daz=%.6f xtq=%d xtunder=%d "
+        "rerr=%.6f waiting=%d",
+        statename[ts.telstate], ts.telstateidx,
+        ts.telstate == TS_TRACKING, ts.jogging_ison,
+        ts.minfo[TEL_HM].have ? !!ts.minfo[TEL_HM].ishomed : -1,
+        ts.minfo[TEL_DM].have ? !!ts.minfo[TEL_DM].ishomed : -1,
+        ts.minfo[TEL_RM].have ? !!ts.minfo[TEL_RM].ishomed : -1,
+        ts.now.n_mjd, ts.CJ2kRA, ts.CJ2kDec, ts.CAHA, ts.Calt, ts.Caz,
+        ts.DJ2kRA, ts.DJ2kDec, ts.Dalt, ts.Daz, ts.xtqdepth, ts.xtunderrun,
+        ts.Rerr, nsq + running);
+}
+
+/* return 1 if msg should not wait for commands ahead of it, else 0 */
+static int
+isImmediate (char *msg)
+{
+    return (strncasecmp (msg, "stop", 4) == 0 || isAside (msg));
+}
+
+/* return 1 if msg is a paddle or guiding command, which runs alongside
+ * whatever command is running rather than in place of it, else 0.
+ */
+static int
+isAside (char *msg)
+{
+    return (msg[0] == 'j' || strncmp (msg, "Offset ", 7) == 0
+                    || strncmp (msg, "xdelta(", 7) == 0);
+}
+
+/* forget client c, including any commands it left waiting */
+static void
+close1 (int c)
+{
+    int i, j;
+
+    close (scli[c].fd);
+    scli[c].fd = -1;
+
+    for (i = j = 0; i < nsq; i++)
+        if (sq[i].cli != c)
+            sq[j++] = sq[i];
+    nsq = j;
+
+    /* no one is left to hear how its command ends */
+    if (owner == c) {
+        owner = NOCLI;
+        running = 0;
+    }
+    if (aside && asidecli == c)
+        asidecli = NOCLI;
+}
+
+/* send one line to client c. drop the client if it can not keep up. */
+static void
+send1 (int c, char *fmt, ...)
+{
+    char buf[MAXLINE+64];
+    va_list ap;
+    int l;
+
+    if (scli[c].fd < 0)
+        return;
+
+    va_start (ap, fmt);
+    l = vsnprintf (buf, sizeof(buf) - 1, fmt, ap);
+    va_end (ap);
+    if (l > (int)sizeof(buf) - 2)
+        l = sizeof(buf) - 2;
+    buf[l++] = '\n';
+
+    if (send (scli[c].fd, buf, l, MSG_NOSIGNAL) != l)
+        close1 (c);
+}
+
+/* send an event line to all subscribers */
+static void
+sendEvent (char *fmt, ...)
+{
+    char buf[MAXLINE];
+    va_list ap;
+    int i;
+
+    va_start (ap, fmt);
+    vsnprintf (buf, sizeof(buf), fmt, ap);
+    va_end (ap);
+
+    for (i = 0; i < MAXSCLI; i++)
+        if (scli[i].fd >= 0 && scli[i].subscribe)
+            send1 (i, "! %s", buf);
+}
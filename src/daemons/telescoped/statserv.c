@@ -0,0 +1,275 @@
+/* publish binary status frames over a Unix-domain stream socket.
+ *
+ * the socket is comm/TelStat.sock, next to Tel.sock. clients just connect
+ * and read; nothing they send is used. STATRATE times a second the words of
+ * telstatframe.h are taken from telstatshmp and sent to every client: a key
+ * frame to each new client and to all every STATKEYINT secs, else a delta
+ * frame of just the words that changed. a client too far behind to take a
+ * whole frame misses it and gets a key frame when it catches up, so a
+ * delta always follows on from the frame before.
+ *
+ * both are optional in telescoped.cfg; STATRATE 0 turns it all off.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "configfile.h"
+#include "misc.h"
+#include "telenv.h"
+#include "telstatshm.h"
+#include "telstatframe.h"
+#include "csimc.h"
+
+#include "teled.h"
+
+#define	MAXTCLI		16	/* max clients connected at once */
+
+static double STATRATE;		/* frames per sec, 0 for none */
+static double STATKEYINT;	/* secs between key frames */
+
+static CfgEntry statcfg[] = {
+    {"STATRATE",	CFG_DBL, &STATRATE},
+    {"STATKEYINT",	CFG_DBL, &STATKEYINT},
+};
+
+static char sockname[] = "comm/TelStat.sock";
+static int lfd = -1;		/* listening socket */
+static int tcli[MAXTCLI];	/* client fds, -1 if unused */
+static int tneedkey[MAXTCLI];	/* set until client gets a key frame */
+static int lastw[TSF_NW];	/* words of the frame last sent */
+static unsigned seq;		/* number of the frame last sent */
+static double tnext;		/* when next frame is due */
+static double tkey;		/* when next key frame is due */
+
+static void accept1 (void);
+static void close1 (int c);
+static int send1 (int c, char *buf, int n);
+static double tvNow (void);
+
+/* create the listening socket, unless STATRATE says not to.
+ * not fatal if trouble.
+ */
+void
+init_stats()
+{
+    struct sockaddr_un sun;
+    char path[1024];
+    int i;
+
+    for (i = 0; i < MAXTCLI; i++)
+        tcli[i] = -1;
+
+    STATRATE = 10;
+    STATKEYINT = 10;
+    (void) readCfgFile (1, tdcfn, statcfg,
+                                    sizeof(statcfg)/sizeof(statcfg[0]));
+    if (STATRATE <= 0)
+        return;
+
+    telfixpath (path, sockname);
+    if (strlen(path) >= sizeof(sun.sun_path)) {
+        tdlog ("%s: path too long", path);
+        return;
+    }
+    (void) unlink (path);
+
+    lfd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        tdlog ("socket(): %s", strerror(errno));
+        return;
+    }
+    memset ((void *)&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    strcpy (sun.sun_path, path);
+    if (bind (lfd, (struct sockaddr *)&sun, sizeof(sun)) < 0
+                                                || listen (lfd, MAXTCLI) < 0) {
+        tdlog ("%s: %s", path, strerror(errno));
+        close (lfd);
+        lfd = -1;
+        return;
+    }
+    (void) fcntl (lfd, F_SETFL, O_NONBLOCK);
+
+    /* anyone in the group may watch */
+    (void) chmod (path, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP);
+}
+
+/* close the listening socket and all clients */
+void
+close_stats()
+{
+    char path[1024];
+    int i;
+
+    for (i = 0; i < MAXTCLI; i++)
+        if (tcli[i] >= 0)
+            close1 (i);
+    if (lfd >= 0) {
+        close (lfd);
+        lfd = -1;
+        telfixpath (path, sockname);
+        (void) unlink (path);
+    }
+}
+
+/* add our fds to *fsp for reading and raise *maxfdp to the largest.
+ * we only read clients to notice when they go away.
+ */
+void
+stat_fdset (fd_set *fsp, int *maxfdp)
+{
+    int i;
+
+    if (lfd < 0)
+        return;
+    FD_SET (lfd, fsp);
+    if (lfd > *maxfdp)
+        *maxfdp = lfd;
+    for (i = 0; i < MAXTCLI; i++) {
+        int fd = tcli[i];
+        if (fd >= 0) {
+            FD_SET (fd, fsp);
+            if (fd > *maxfdp)
+                *maxfdp = fd;
+        }
+    }
+}
+
+/* handle any of our fds in *fsp that are ready to read */
+void
+stat_read (fd_set *fsp)
+{
+    char junk[256];
+    int i, n;
+
+    if (lfd < 0)
+        return;
+    for (i = 0; i < MAXTCLI; i++) {
+        if (tcli[i] < 0 || !FD_ISSET (tcli[i], fsp))
+            continue;
+        n = read (tcli[i], junk, sizeof(junk));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+            close1 (i);
+    }
+    if (FD_ISSET (lfd, fsp))
+        accept1();
+}
+
+/* called after each poll: send a frame to everyone if one is due */
+void
+stat_poll()
+{
+    int w[TSF_NW];
+    char kbuf[TSF_MAXBYTES], dbuf[TSF_MAXBYTES];
+    int kn = 0, dn = 0;
+    int allkey;
+    double now;
+    int i;
+
+    if (lfd < 0)
+        return;
+    now = tvNow();
+    if (now < tnext)
+        return;
+    tnext = now < tnext + 1/STATRATE ? tnext + 1/STATRATE : now + 1/STATRATE;
+
+    allkey = now >= tkey;
+    if (allkey)
+        tkey = now + STATKEYINT;
+
+    tsfFill (telstatshmp, w);
+    seq++;
+    for (i = 0; i < MAXTCLI; i++) {
+        if (tcli[i] < 0)
+            continue;
+        if (allkey || tneedkey[i]) {
+            if (!kn)
+                kn = tsfKey (w, seq, kbuf);
+            if (send1 (i, kbuf, kn) == 0)
+                tneedkey[i] = 0;
+        } else {
+            if (!dn)
+                dn = tsfDelta (lastw, w, seq, dbuf);
+            (void) send1 (i, dbuf, dn);
+        }
+    }
+    memcpy ((void *)lastw, (void *)w, sizeof(lastw));
+}
+
+/* accept a new client */
+static void
+accept1()
+{
+    int fd, i;
+
+    fd = accept (lfd, NULL, NULL);
+    if (fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            tdlog ("accept(): %s", strerror(errno));
+        return;
+    }
+
+    for (i = 0; i < MAXTCLI; i++)
+        if (tcli[i] < 0)
+            break;
+    if (i == MAXTCLI) {
+        tdlog ("%s: more than %d clients", sockname, MAXTCLI);
+        close (fd);
+        return;
+    }
+
+    (void) fcntl (fd, F_SETFL, O_NONBLOCK);
+    tcli[i] = fd;
+    tneedkey[i] = 1;
+}
+
+/* close client c */
+static void
+close1 (int c)
+{
+    close (tcli[c]);
+    tcli[c] = -1;
+}
+
+/* send the frame buf[n] to client c, all or nothing.
+ * if there is no room at all it gets a key frame next time instead.
+ * return 0 if sent, else -1.
+ */
+static int
+send1 (int c, char *buf, int n)
+{
+    int s;
+
+    s = send (tcli[c], buf, n, MSG_DONTWAIT|MSG_NOSIGNAL);
+    if (s == n)
+        return (0);
+    if (s < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        tneedkey[c] = 1;
+    else
+        close1 (c);		/* gone, or part of a frame sent */
+    return (-1);
+}
+
+/* secs since 1970 */
+static double
+tvNow()
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return (tv.tv_sec + tv.tv_usec*1e-6);
+}
@@ -11,6 +11,7 @@
 #include <fcntl.h>
 #include <time.h>
 #include <assert.h>
+#include <ctype.h>
 
 #include "P_.h"
 #include "astro.h"
@@ -63,14 +64,26 @@ static void tel_park(int first, int ha_enc, int dec_enc); // RGW
 static int dbformat(char *msg, Obj *op, double *drap, double *ddecp);
 static void initCfg(void);
 static void hd2xyr(double ha, double dec, double *xp, double *yp, double *rp);
+static void hdm2xyr(double ha, double dec, double *xp, double *yp, double *rp);
 static void readRaw(void);
+static MotorInfo *readRawClock(int *clockp);
 static void mkCook(void);
 static void dummyTarg(void);
 static void stopTel(int fast);
 static int onTarget(MotorInfo **mipp);
 static int atTarget(void);
 static int trackObj(Obj *op, int first);
+static void planIntercept(Now *np, Obj *op);
+static int xtDepth(double tnow);
+static void targetAxes(Now *np, Obj *op, double t, double xyr[], double v[]);
 static void findAxes(Now *np, Obj *op, double *xp, double *yp, double *rp);
+static void findHADec(Now *np, Obj *op, double *hap, double *decp, double *rap,
+		double *adecp);
+static int fastTrack(Now *np, Obj *op, double dur, double x[], double y[],
+		double r[]);
+static double pmPI(double a);
+static void sendTrack(MotorInfo *mip, double pos[], double dt);
+static void buildRotTrack(Now *np, Obj *op);
 static int chkLimits(int wrapok, double *xp, double *yp, double *rp);
 static void jogTrack(int first, char dircode, int velocity);
 static void jogSlew(int first, char dircode, int velocity);
@@ -80,14 +93,39 @@ static char *sayWhere(double alt, double az);
 /* RGW */
 static void readStats(void);
 
+/* homing or finding limits on several axes at once */
+typedef struct
+{
+	int (*fp)(MotorInfo *mip, FifoId fid, int first); /* axis_home/limits */
+	char *what; /* for messages */
+	int code; /* fifo code when an axis is done */
+	int want[NMOT]; /* set for each axis still going */
+	int nwant; /* n set in want[] */
+	double to[NMOT]; /* mjd by which each must next report */
+} AxisSeq;
+static AxisSeq homeseq = { axis_home, "home", 1 };
+static AxisSeq limseq = { axis_limits, "limits", 2 };
+static double limmjd[NMOT]; /* when each axis' limits were last found */
+static double LIMITSKEEP; /* days "limits auto" trusts them, 0 never */
+static void seqWant(AxisSeq *sp, char *msg);
+static int seqRun(AxisSeq *sp, int first);
+
 /* config entries */
 static double TRACKACC; /* tracking accuracy, rads. 0 means 1 enc step*/
 static double FGUIDEVEL; /* fine jogging motion rate, rads/sec */
 static double CGUIDEVEL; /* coarse jogging motion rate, rads/sec */
 static int TRACKINT; /* tracking interval for each e/mtrack, secs */
 static int XTRACKINT; /* ICE tracking interval for each xtrack, secs */
+static double XTRACKHORIZON; /* secs of xpos to keep queued, 0 for 2*XTRACKINT */
+static int XTRACKBATCH; /* max xpos points per packet */
+static int XTRACKRELAX; /* first xpos offset, halved each point, steps */
+static double XTRACKJIT; /* alternating xpos dither once relaxed, steps */
+
+#define	XTLATMARGIN	4.0	/* horizon covers XTRACKINT + this * peak latency */
+#define	XTLATDECAY	0.99	/* peak latency decay per trackObj() call */
 
 #define	PPTRACK		60	/* number of positions to e/mtrack */
+#define	FASTTOL		(0.25/3600*PI/180) /* max fastTrack() error, rads */
 
 /* offsets to apply to target object location, if any */
 static double r_offset; /* delta ra to be added */
@@ -95,66 +133,383 @@ static double d_offset; /* delta dec to be added */
 
 #define	MAXJITTER	10.0	/* max clock vs host difference */
 static double strack; /* when current e/mtrack started */
+static double trackend; /* when current e/mtrack needs replacing */
+
+/* planned intercept of the target when tracking starts */
+#define	IMAXITER	20	/* max iterations to find intercept time */
+#define	ITOL		0.01	/* intercept time tolerance, secs */
+#define	IMINTIME	1.0	/* don't bother with an intercept sooner, secs */
+#define	ITAIL		30.0	/* secs of target track after an intercept */
+#define	IMAXDT		0.5	/* max secs between intercept profile points */
+static AxisTraj itraj[NMOT]; /* trajectory for each axis from rest */
+static double itime; /* secs from start to intercept, 0 if none */
+static double istart; /* mjd when itraj[] starts */
+
+/* field derotation, see derot.c */
+#define	RDEROTTOL	(10.0/3600*PI/180) /* max rotator interp error, rads */
+#define	RMINDT		0.5	/* min secs between rotator profile points */
+#define	RVELFRAC	0.9	/* fraction of maxvel to plan rotator moves */
+#define	RRELOAD		0.5	/* fraction of dense rotator profile to use */
+static double rprof[PPTRACK]; /* rotator profile as sent */
+static int rprofok; /* set when rprof[] is in use */
+static double rdt; /* secs between rprof[] points */
+static double rstrack; /* when rprof[] started */
+static double rtrackend; /* when to replace a dense rprof[], else 0 */
+
+/* the commands we understand, tried in order by tel_msg().
+ * each parse function gets the whole message and the text just past the
+ * keyword. it returns 0 if it took the command, else -1 to let later
+ * entries try.
+ */
+typedef struct
+{
+	char *kw; /* leading keyword */
+	int nocase; /* set to match kw regardless of case */
+	int (*fp)(char *msg, char *args); /* parse args and run command */
+	int kwlen; /* strlen(kw), set on first use */
+	int n; /* times run */
+	double sum, max; /* time spent starting it, secs */
+} TelCmd;
+
+static int cmdReset(char *msg, char *args);
+static int cmdHome(char *msg, char *args);
+static int cmdLimits(char *msg, char *args);
+static int cmdStow(char *msg, char *args);
+static int cmdPark(char *msg, char *args);
+static int cmdStatus(char *msg, char *args);
+static int cmdCmdStats(char *msg, char *args);
+static int cmdRA(char *msg, char *args);
+static int cmdDb(char *msg, char *args);
+static int cmdAlt(char *msg, char *args);
+static int cmdHA(char *msg, char *args);
+static int cmdJog(char *msg, char *args);
+static int cmdOffset(char *msg, char *args);
+static int cmdXdelta(char *msg, char *args);
+static int cmdStop(char *msg, char *args);
+static int getNum(char **spp, double *dp);
+static int getKey(char **spp, char *key);
+static int cmdProfile(char *msg, char *args);
+
+/* N.B. order matters: keywords that may begin a .edb line must come before
+ * cmdDb, which takes anything else with a comma, and cmdStop must be last.
+ */
+static TelCmd telcmds[] =
+{
+	{ "reset", 1, cmdReset },
+	{ "home", 1, cmdHome },
+	{ "limits", 1, cmdLimits },
+	{ "stow", 1, cmdStow },
+	{ "park", 0, cmdPark },
+	{ "status", 1, cmdStatus },
+	{ "cmdstats", 1, cmdCmdStats },
+	{ "profile", 1, cmdProfile },
+	{ "RA:", 0, cmdRA },
+	{ "", 0, cmdDb },
+	{ "Alt:", 0, cmdAlt },
+	{ "HA:", 0, cmdHA },
+	{ "j", 0, cmdJog },
+	{ "Offset", 0, cmdOffset },
+	{ "xdelta(", 0, cmdXdelta },
+	{ "", 0, cmdStop },
+};
+#define	NTELCMDS	(sizeof(telcmds)/sizeof(telcmds[0]))
+static TelCmd *jogcmd; /* guider fast path, found by findCmd() */
+static TelCmd *offsetcmd; /* guider fast path, found by findCmd() */
+
+/* return the telcmds[] entry that runs fp */
+static TelCmd *findCmd(int (*fp)(char *msg, char *args))
+{
+	TelCmd *tcp;
+
+	for (tcp = telcmds; tcp < &telcmds[NTELCMDS]; tcp++)
+		if (tcp->fp == fp)
+			return (tcp);
+	tdlog("Bug! no telcmds[] entry for a fast path");
+	die();
+	return (NULL);
+}
+
+/* run one command from tcp, keeping its latency stats.
+ * return as the parse function.
+ */
+static int runCmd(TelCmd *tcp, char *msg)
+{
+	double t0 = profNow();
+	double dt;
+
+	if (!tcp->kwlen)
+		tcp->kwlen = strlen(tcp->kw);
+	if (tcp->nocase ? strncasecmp(msg, tcp->kw, tcp->kwlen) :
+			strncmp(msg, tcp->kw, tcp->kwlen))
+		return (-1);
+	if ((*tcp->fp)(msg, msg + tcp->kwlen) < 0)
+		return (-1);
+
+	dt = profNow() - t0;
+	tcp->n++;
+	tcp->sum += dt;
+	if (dt > tcp->max)
+		tcp->max = dt;
+	return (0);
+}
 
 /* called when we receive a message from the Tel fifo.
  * as well as regularly with !msg just to update things.
  */
-/* ARGSUSED */
-void tel_msg(msg)
-	char *msg;
+void tel_msg(char *msg)
 {
-	double a, b, c;
-	int d, e;
-	char jog_dir[8];
-	int vel;
-	Obj o;
-	int jogargs = 0;
+	TelCmd *tcp;
+
+	if (!msg)
+	{
+		tel_poll();
+		return;
+	}
+
+	tdlog("KMI - Dispatch message %s", msg);
+
+	/* guider corrections come often so try them first.
+	 * a jog has no comma so it can not be a .edb line, and an Offset
+	 * never cracks as one.
+	 */
+	if (!jogcmd)
+	{
+		jogcmd = findCmd(cmdJog);
+		offsetcmd = findCmd(cmdOffset);
+	}
+	if (msg[0] == 'j' && !strchr(msg, ','))
+	{
+		if (runCmd(jogcmd, msg) == 0)
+			return;
+	}
+	else if (msg[0] == 'O' && runCmd(offsetcmd, msg) == 0)
+		return;
 
 	/* dispatch -- stop by default */
+	for (tcp = telcmds; tcp < &telcmds[NTELCMDS]; tcp++)
+		if (runCmd(tcp, msg) == 0)
+			return;
+}
+
+/* log the latency stats for each command, and report them too if fifo */
+static void cmdLogStats(int fifo)
+{
+	TelCmd *tcp;
 
-	if (msg)
+	for (tcp = telcmds; tcp < &telcmds[NTELCMDS]; tcp++)
 	{
-		tdlog("KMI - Dispatch message %s", msg);
+		char buf[128];
+		char *name = tcp->kw[0] ? tcp->kw : (tcp->fp == cmdDb ? "edb"
+				: "stop");
+
+		if (!tcp->n)
+			continue;
+		sprintf(buf, "%-8s n=%d mean=%.3fms max=%.3fms", name, tcp->n,
+				1e3 * tcp->sum / tcp->n, 1e3 * tcp->max);
+		tdlog("%s", buf);
+		if (fifo)
+			fifoWrite(Tel_Id, 1, "%s", buf);
 	}
+}
 
-	if (!msg)
-		tel_poll();
-	else if (strncasecmp(msg, "reset", 5) == 0)
-		tel_reset(1);
-	else if (strncasecmp(msg, "home", 4) == 0)
-		tel_home(1, msg);
-	else if (strncasecmp(msg, "limits", 6) == 0)
-		tel_limits(1, msg);
-	else if (strncasecmp(msg, "stow", 4) == 0)
-		tel_stow(1, msg);
-	else if (sscanf(msg, "park %d %d", &d, &e) == 2)
-		tel_park(1, d, e);
-	else if (strncasecmp(msg, "status", 6) == 0) //IEEC
-		tel_status(1);                           //IEEC
-	else if (sscanf(msg, "RA:%lf Dec:%lf Epoch:%lf", &a, &b, &c) == 3)
+static int cmdReset(char *msg, char *args)
+{
+	cmdLogStats(0);
+	profLog(0);
+	tel_reset(1);
+	return (0);
+}
+
+static int cmdHome(char *msg, char *args)
+{
+	tel_home(1, msg);
+	return (0);
+}
+
+static int cmdLimits(char *msg, char *args)
+{
+	tel_limits(1, msg);
+	return (0);
+}
+
+static int cmdStow(char *msg, char *args)
+{
+	tel_stow(1, msg);
+	return (0);
+}
+
+/* park ha_enc dec_enc */
+static int cmdPark(char *msg, char *args)
+{
+	double h, d;
+
+	if (getNum(&args, &h) < 0 || getNum(&args, &d) < 0)
+		return (-1);
+	tel_park(1, (int) h, (int) d);
+	return (0);
+}
+
+static int cmdStatus(char *msg, char *args)
+{
+	tel_status(1);
+	return (0);
+}
+
+static int cmdCmdStats(char *msg, char *args)
+{
+	cmdLogStats(1);
+	fifoWrite(Tel_Id, 0, "Command stats complete");
+	return (0);
+}
+
+/* profile [reset] */
+static int cmdProfile(char *msg, char *args)
+{
+	char key[32];
+
+	if (sscanf(args, "%31s", key) == 1 && strcasecmp(key, "reset") == 0)
+	{
+		profReset();
+		fifoWrite(Tel_Id, 0, "Profile reset");
+		return (0);
+	}
+	profLog(1);
+	fifoWrite(Tel_Id, 0, "Profile complete");
+	return (0);
+}
+
+/* RA:a Dec:b [Epoch:c] */
+static int cmdRA(char *msg, char *args)
+{
+	double a, b, c;
+
+	if (getNum(&args, &a) < 0 || getKey(&args, "Dec:") < 0
+			|| getNum(&args, &b) < 0)
+		return (-1);
+	if (getKey(&args, "Epoch:") == 0 && getNum(&args, &c) == 0)
 		tel_radecep(1, a, b, c);
-	else if (sscanf(msg, "RA:%lf Dec:%lf", &a, &b) == 2)
-		tel_radeceod(1, a, b);
-	else if (dbformat(msg, &o, &a, &b) == 0)
-		tel_op(1, &o, a, b);
-	else if (sscanf(msg, "Alt:%lf Az:%lf", &a, &b) == 2)
-		tel_altaz(1, a, b);
-	else if (sscanf(msg, "HA:%lf Dec:%lf", &a, &b) == 2)
-		tel_hadec(1, a, b);
-	else if ((jogargs = sscanf(msg, "j%7[NSEWnsew0] %d", jog_dir, &vel)) == 2)
-		tel_jog(1, jog_dir, vel); // Variable-velocity jog, KMI 8/19/05
-	// Vel ranges from 0 to VEL_MAX, indicating some fraction of the
-	// max velocity for a particular axis
-	else if (jogargs == 1)
-		tel_jog(1, jog_dir, VEL_MAX); // Slow/fast jog
-	else if (sscanf(msg, "Offset %lf,%lf", &a, &b) == 2)
-		offsetTracking(1, a, b);
-	//ICE
-	else if (sscanf(msg, "xdelta(%lf,%lf)", &a, &b) == 2)
-		tel_set_xdelta(a, b);
-	//ICE
 	else
-		tel_stop(1);
+		tel_radeceod(1, a, b);
+	return (0);
+}
+
+/* [dRA:x dDec:y #] .edb line */
+static int cmdDb(char *msg, char *args)
+{
+	double a, b;
+	Obj o;
+
+	if (!strchr(msg, ',') || dbformat(msg, &o, &a, &b) < 0)
+		return (-1);
+	tel_op(1, &o, a, b);
+	return (0);
+}
+
+/* Alt:a Az:b */
+static int cmdAlt(char *msg, char *args)
+{
+	double a, b;
+
+	if (getNum(&args, &a) < 0 || getKey(&args, "Az:") < 0
+			|| getNum(&args, &b) < 0)
+		return (-1);
+	tel_altaz(1, a, b);
+	return (0);
+}
+
+/* HA:a Dec:b */
+static int cmdHA(char *msg, char *args)
+{
+	double a, b;
+
+	if (getNum(&args, &a) < 0 || getKey(&args, "Dec:") < 0
+			|| getNum(&args, &b) < 0)
+		return (-1);
+	tel_hadec(1, a, b);
+	return (0);
+}
+
+/* j<dirs> [vel]: variable-velocity jog, KMI 8/19/05.
+ * vel ranges from 0 to VEL_MAX, indicating some fraction of the max velocity
+ * for a particular axis. without it, slow/fast jog.
+ */
+static int cmdJog(char *msg, char *args)
+{
+	char jog_dir[8];
+	double v;
+	int n;
+
+	for (n = 0; n < 7 && args[n] && strchr("NSEWnsew0", args[n]); n++)
+		jog_dir[n] = args[n];
+	if (n == 0)
+		return (-1);
+	jog_dir[n] = '\0';
+	args += n;
+
+	if (getNum(&args, &v) < 0)
+		v = VEL_MAX;
+	tel_jog(1, jog_dir, (int) v);
+	return (0);
+}
+
+/* Offset a,b */
+static int cmdOffset(char *msg, char *args)
+{
+	double a, b;
+
+	if (getNum(&args, &a) < 0 || getKey(&args, ",") < 0
+			|| getNum(&args, &b) < 0)
+		return (-1);
+	offsetTracking(1, a, b);
+	return (0);
+}
+
+/* xdelta(a,b) */
+static int cmdXdelta(char *msg, char *args)
+{
+	double a, b;
+
+	if (getNum(&args, &a) < 0 || getKey(&args, ",") < 0
+			|| getNum(&args, &b) < 0)
+		return (-1);
+	tel_set_xdelta(a, b);
+	return (0);
+}
+
+static int cmdStop(char *msg, char *args)
+{
+	tel_stop(1);
+	return (0);
+}
+
+/* skip white space at *spp then crack a number, advancing *spp past it.
+ * return 0 if ok, else -1 and *spp is unchanged.
+ */
+static int getNum(char **spp, double *dp)
+{
+	char *end;
+
+	*dp = strtod(*spp, &end);
+	if (end == *spp)
+		return (-1);
+	*spp = end;
+	return (0);
+}
+
+/* skip white space at *spp then match key exactly, advancing *spp past it.
+ * return 0 if ok, else -1 and *spp is unchanged.
+ */
+static int getKey(char **spp, char *key)
+{
+	char *s = *spp;
+	int l = strlen(key);
+
+	while (isspace(*s))
+		s++;
+	if (strncmp(s, key, l))
+		return (-1);
+	*spp = s + l;
+	return (0);
 }
 
 /* no new messages.
@@ -202,11 +557,11 @@ static void tel_reset(int first)
 	fifoWrite(Tel_Id, 0, "Reset complete");
 }
 
-/* seek telescope axis home positions.. all or as per HDR */
+/* seek telescope axis home positions.. all or as per HDR, all at once.
+ * with "auto" skip any the controller says are still homed.
+ */
 static void tel_home(int first, ...)
 {
-	static int want[NMOT];
-	static int nwant;
 	MotorInfo *mip;
 	int i;
 
@@ -225,101 +580,51 @@ static void tel_home(int first, ...)
 
 		/* start fresh */
 		stopTel(0);
-		memset((void *) want, 0, sizeof(want));
-
-		/* find which axes to do, or all if none specified */
-		nwant = 0;
-		if (strchr(msg, 'H'))
-		{
-			nwant++;
-			want[TEL_HM] = 1;
-		}
-		if (strchr(msg, 'D'))
-		{
-			nwant++;
-			want[TEL_DM] = 1;
-		}
-		if (strchr(msg, 'R'))
+		seqWant(&homeseq, msg);
+		if (strstr(msg, "auto"))
 		{
-			nwant++;
-			want[TEL_RM] = 1;
-		}
-		if (!nwant)
-		{
-			nwant = 3;
-			want[TEL_HM] = want[TEL_DM] = want[TEL_RM] = 1;
-		}
-
-		FEM (mip)
-		{
-			i = mip - &telstatshmp->minfo[0];
-			if (want[i])
+			FEM (mip)
 			{
-				switch (axis_home(mip, Tel_Id, 1))
+				i = mip - &telstatshmp->minfo[0];
+				if (homeseq.want[i] && mip->ishomed
+						&& csi_rix(MIPSFD(mip), "=isHomed();") == 1)
 				{
-				case -1:
-					/* abort all axes if any fail */
-					stopTel(1);
-					active_func = NULL;
-					return;
-				case 1:
-					continue;
-				case 0:
-					want[i] = 0;
-					nwant--;
-					break;
+					fifoWrite(Tel_Id, 1, "Axis %d: already homed", mip->axis);
+					homeseq.want[i] = 0;
+					homeseq.nwant--;
 				}
 			}
 		}
 
-		/* if get here, set new state */
+		/* set new state */
 		active_func = tel_home;
 		telstatshmp->telstate = TS_HOMING;
 		telstatshmp->telstateidx++;
 	}
 
 	/* continue to seek home on each axis still not done */
-	FEM (mip)
+	switch (seqRun(&homeseq, first))
 	{
-		i = mip - &telstatshmp->minfo[0];
-		if (want[i])
-		{
-			switch (axis_home(mip, Tel_Id, 0))
-			{
-			case -1:
-				/* abort all axes if any fail */
-				stopTel(1);
-				active_func = NULL;
-				return;
-			case 1:
-				continue;
-			case 0:
-				fifoWrite(Tel_Id, 1, "Axis %d: home complete", mip->axis);
-				want[i] = 0;
-				nwant--;
-				break;
-			}
-		}
-
+	case -1:
+		active_func = NULL;
+		return;
+	case 1:
+		return;
 	}
 
 	/* really done when none left */
-	if (!nwant)
-	{
-		telstatshmp->telstate = TS_STOPPED;
-		telstatshmp->telstateidx++;
-		active_func = NULL;
-		fifoWrite(Tel_Id, 0, "Scope homing complete");
-	}
+	telstatshmp->telstate = TS_STOPPED;
+	telstatshmp->telstateidx++;
+	active_func = NULL;
+	fifoWrite(Tel_Id, 0, "Scope homing complete");
 }
 
-/* find limit positions and H/D motor steps and signs.
+/* find limit positions and H/D motor steps and signs, all axes at once.
+ * with "auto" skip any found within LIMITSKEEP days.
  * N.B. set tax->h*lim as soon as we know TEL_HM limits.
  */
 static void tel_limits(int first, ...)
 {
-	static int want[NMOT];
-	static int nwant;
 	MotorInfo *mip;
 	int i;
 
@@ -339,49 +644,22 @@ static void tel_limits(int first, ...)
 
 		/* start fresh */
 		stopTel(0);
-		memset((void *) want, 0, sizeof(want));
-
-		/* find which axes to do, or all if none specified */
-		nwant = 0;
-		if (strchr(msg, 'H'))
-		{
-			nwant++;
-			want[TEL_HM] = 1;
-		}
-		if (strchr(msg, 'D'))
-		{
-			nwant++;
-			want[TEL_DM] = 1;
-		}
-		if (strchr(msg, 'R'))
-		{
-			nwant++;
-			want[TEL_RM] = 1;
-		}
-		if (!nwant)
+		seqWant(&limseq, msg);
+		if (strstr(msg, "auto"))
 		{
-			nwant = 3;
-			want[TEL_HM] = want[TEL_DM] = want[TEL_RM] = 1;
-		}
-
-		FEM (mip)
-		{
-			i = mip - &telstatshmp->minfo[0];
-			if (want[i])
+			FEM (mip)
 			{
-				switch (axis_limits(mip, Tel_Id, 1))
+				double age;
+
+				i = mip - &telstatshmp->minfo[0];
+				age = telstatshmp->now.n_mjd - limmjd[i];
+				if (limseq.want[i] && mip->ishomed && limmjd[i] > 0
+						&& age < LIMITSKEEP)
 				{
-				case -1:
-					/* abort all axes if any fail */
-					stopTel(1);
-					active_func = NULL;
-					return;
-				case 1:
-					continue;
-				case 0:
-					want[i] = 0;
-					nwant--;
-					break;
+					fifoWrite(Tel_Id, 2, "Axis %d: keeping limits from %.1f days ago",
+							mip->axis, age);
+					limseq.want[i] = 0;
+					limseq.nwant--;
 				}
 			}
 		}
@@ -393,52 +671,93 @@ static void tel_limits(int first, ...)
 	}
 
 	/* continue to seek limits on each axis still not done */
-	FEM (mip)
+	switch (seqRun(&limseq, first))
 	{
-		i = mip - &telstatshmp->minfo[0];
-		if (want[i])
-		{
-			switch (axis_limits(mip, Tel_Id, 0))
-			{
-			case -1:
-				/* abort all axes if any fail */
-				stopTel(1);
-				active_func = NULL;
-				return;
-			case 1:
-				continue;
-			case 0:
-				fifoWrite(Tel_Id, 2, "Axis %d: limits complete", mip->axis);
-				mip->cvel = 0;
-				want[i] = 0;
-				nwant--;
-				break;
-			}
-		}
-
+	case -1:
+		active_func = NULL;
+		return;
+	case 1:
+		return;
 	}
 
 	/* really done when none left */
-	if (!nwant)
+	stopTel(0);
+	initCfg(); /* read new limits */
+	active_func = NULL;
+	fifoWrite(Tel_Id, 0, "All Scope limits are complete.");
+
+	/* N.B. save TEL_HM limits in tax */
+	telstatshmp->tax.hneglim = HMOT->neglim;
+	telstatshmp->tax.hposlim = HMOT->poslim;
+}
+
+/* set sp to do the axes named H, D and R in msg, or all if none.
+ * axes we don't have are left out.
+ */
+static void seqWant(AxisSeq *sp, char *msg)
+{
+	MotorInfo *mip;
+	int all = !strchr(msg, 'H') && !strchr(msg, 'D') && !strchr(msg, 'R');
+
+	sp->nwant = 0;
+	FEM (mip)
 	{
-		//        char buf[128];
+		int i = mip - &telstatshmp->minfo[0];
 
-		stopTel(0);
-		initCfg(); /* read new limits */
-		active_func = NULL;
-		fifoWrite(Tel_Id, 0, "All Scope limits are complete.");
+		sp->want[i] = mip->have && (all || strchr(msg, "HDR"[i]));
+		sp->nwant += sp->want[i];
+	}
+}
+
+/* start or continue sp->fp on each axis it still wants, all together.
+ * each axis must report progress within axisSeekTime() or it times out.
+ * return 1 while any are still going, 0 when all are done, or -1 if any
+ * failed, when all are stopped.
+ */
+static int seqRun(AxisSeq *sp, int first)
+{
+	MotorInfo *mip;
 
-		/* N.B. save TEL_HM limits in tax */
-		telstatshmp->tax.hneglim = HMOT->neglim;
-		telstatshmp->tax.hposlim = HMOT->poslim;
+	FEM (mip)
+	{
+		int i = mip - &telstatshmp->minfo[0];
 
-		// Move to the stow position
-		mip->ishomed = 1; // we really are homed
-		//        fifoWrite (Tel_Id, 0, "Now moving to stow position");
-		//        allstop();
-		//        sprintf (buf, "Alt:%g Az:%g", STOWALT, STOWAZ);
-		//        tel_msg (buf);
+		if (!sp->want[i])
+			continue;
+
+		switch ((*sp->fp)(mip, Tel_Id, first))
+		{
+		case -1:
+			/* abort all axes if any fail */
+			stopTel(1);
+			return (-1);
+		case 0:
+			if (!first)
+				fifoWrite(Tel_Id, sp->code, "Axis %d: %s complete", mip->axis,
+						sp->what);
+			mip->cvel = 0;
+			sp->want[i] = 0;
+			sp->nwant--;
+			break;
+		case 2:
+			/* heard from it, so start its time again */
+			sp->to[i] = telstatshmp->now.n_mjd + axisSeekTime(mip) / SPD;
+			break;
+		default:
+			if (first)
+				sp->to[i] = telstatshmp->now.n_mjd + axisSeekTime(mip) / SPD;
+			else if (telstatshmp->now.n_mjd > sp->to[i])
+			{
+				fifoWrite(Tel_Id, -1, "Axis %d timed out finding %s",
+						mip->axis, sp->what);
+				stopTel(1);
+				return (-1);
+			}
+			break;
+		}
 	}
+
+	return (sp->nwant > 0 ? 1 : 0);
 }
 
 /* Place the telescope in STOW position
@@ -853,12 +1172,13 @@ static void tel_status(int first, ...)
     int hstatus, dstatus;
     hstatus = dstatus = -1;
 
+    /* homed state is kept in shm, no need to ask the controllers */
     readRaw();
     mkCook();
     if (HMOT->have)
-        hstatus = csi_rix(MIPCFD(HMOT),"=isHomed();");
+        hstatus = HMOT->ishomed ? 1 : 0;
     if (DMOT->have)
-        dstatus = csi_rix(MIPCFD(DMOT),"=isHomed();");
+        dstatus = DMOT->ishomed ? 1 : 0;
 
     if(hstatus==1 && dstatus==1)
 	{
@@ -896,8 +1216,233 @@ static int dbformat(char *msg, Obj *op, double *drap, double *ddecp)
 	return (db_crack_line(msg, op, NULL));
 }
 
+/* find the soonest time each axis can be moving along with the target,
+ * starting from rest where it is now, and plan the trajectories to get
+ * there. leave itime 0 if there's no need or no way.
+ * np is when tracking starts.
+ */
+static void planIntercept(Now *np, Obj *op)
+{
+	double xyr[NMOT], v[NMOT];
+	double T, Tn;
+	MotorInfo *mip;
+	int i;
+
+	itime = 0;
+
+	/* each pass finds how long to reach where the target will be */
+	T = 0;
+	for (i = 0; i < IMAXITER; i++)
+	{
+		targetAxes(np, op, T, xyr, v);
+		Tn = 0;
+		FEM(mip)
+		{
+			int ax = mip - telstatshmp->minfo;
+			double t;
+
+			if (!mip->have)
+				continue;
+			t = axisMinTime(mip, xyr[ax] - mip->cpos, v[ax]);
+			if (t < 0)
+			{
+				tdlog("Axis %d can not keep up with target", mip->axis);
+				return;
+			}
+			if (t > Tn)
+				Tn = t;
+		}
+		if (fabs(Tn - T) < ITOL)
+			break;
+		T = Tn;
+	}
+	if (i == IMAXITER)
+	{
+		tdlog("No intercept found after %g secs", T);
+		return;
+	}
+	if (Tn < IMINTIME)
+		return;
+
+	/* plan each axis to arrive together */
+	T = Tn + ITOL;
+	targetAxes(np, op, T, xyr, v);
+	FEM(mip)
+	{
+		int ax = mip - telstatshmp->minfo;
+		AxisTraj *tp = &itraj[ax];
+
+		if (!mip->have)
+		{
+			memset((void *) tp, 0, sizeof(*tp));
+			continue;
+		}
+		if (axisPlan(mip, mip->cpos, xyr[ax], v[ax], T, tp) < 0)
+			return;
+	}
+
+	itime = T;
+	istart = np->n_mjd;
+	tdlog("Intercept planned in %.1f secs", T);
+}
+
+/* find the target's axis positions and velocities t secs after np */
+static void targetAxes(Now *np, Obj *op, double t, double xyr[], double v[])
+{
+	Now n = *np;
+	double x0, y0, r0, x1, y1, r1;
+
+	n.n_mjd = np->n_mjd + (t - 0.5) / SPD;
+	findAxes(&n, op, &x0, &y0, &r0);
+	(void) chkLimits(1, &x0, &y0, &r0);
+	n.n_mjd = np->n_mjd + (t + 0.5) / SPD;
+	findAxes(&n, op, &x1, &y1, &r1);
+	(void) chkLimits(1, &x1, &y1, &r1);
+
+	xyr[TEL_HM] = (x0 + x1) / 2;
+	xyr[TEL_DM] = (y0 + y1) / 2;
+	xyr[TEL_RM] = (r0 + r1) / 2;
+	v[TEL_HM] = x1 - x0;
+	v[TEL_DM] = y1 - y0;
+	v[TEL_RM] = r1 - r0;
+}
+
+/* fill x/y/r[PPTRACK] with axis positions for fixed op over dur secs from
+ * np, without a full reduction for each.
+ * the apparent place is found once and the hour angle advanced at the
+ * sidereal rate. refraction and mesh corrections are found by the full model
+ * at the ends and interpolated linearly between. the result is checked
+ * against the full model in the middle, where the interpolation is worst.
+ * return 0 if ok, else -1 if the full model is needed.
+ */
+static int fastTrack(Now *np, Obj *op, double dur, double x[], double y[],
+		double r[])
+{
+	double w = 2 * PI / (SPD * SIDRATE); /* sidereal rate, rads/sec */
+	double tend = (PPTRACK - 1) * dur / PPTRACK;
+	double ha0 = 0, adec0 = 0;
+	double ch[2], cd[2];
+	double xf, yf, rf;
+	Now n = *np;
+	int i;
+
+	/* corrections to the geometric ha/dec at each end */
+	for (i = 0; i < 2; i++)
+	{
+		double ha, dec, ra, adec, lst, mdha, mddec;
+
+		n.n_mjd = np->n_mjd + i * tend / SPD;
+		findHADec(&n, op, &ha, &dec, &ra, &adec);
+		tel_mount_cor(ha, dec, &mdha, &mddec);
+		if (i == 0)
+		{
+			now_lst(&n, &lst);
+			ha0 = hrrad(lst) - ra;
+			adec0 = adec;
+		}
+		ch[i] = pmPI(ha + mdha - (ha0 + w * i * tend));
+		cd[i] = dec + mddec - adec0;
+	}
+	for (i = 0; i < PPTRACK; i++)
+	{
+		double t = i * dur / PPTRACK;
+		double f = t / tend;
+
+		hdm2xyr(ha0 + w * t + ch[0] + f * (ch[1] - ch[0]),
+				adec0 + cd[0] + f * (cd[1] - cd[0]), &x[i], &y[i], &r[i]);
+		(void) chkLimits(1, &x[i], &y[i], &r[i]); /* let limit protect */
+	}
+
+	/* bound check */
+	i = PPTRACK / 2;
+	n.n_mjd = np->n_mjd + i * dur / (PPTRACK * SPD);
+	findAxes(&n, op, &xf, &yf, &rf);
+	(void) chkLimits(1, &xf, &yf, &rf);
+	if (fabs(pmPI(xf - x[i])) > FASTTOL || fabs(pmPI(yf - y[i])) > FASTTOL
+			|| (RMOT->have && fabs(pmPI(rf - r[i])) > FASTTOL))
+		return (-1);
+
+	return (0);
+}
+
+/* return a reduced to the range -PI .. PI */
+static double pmPI(double a)
+{
+	return (a - 2 * PI * floor((a + PI) / (2 * PI)));
+}
+
+/* send PPTRACK positions pos[], dt secs apart from clock 0, to mip */
+static void sendTrack(MotorInfo *mip, double pos[], double dt)
+{
+	double scale;
+	int cfd = MIPCFD(mip);
+	int i;
+
+	//	    tdlog ("Creating track profile:");
+	if (mip->haveenc)
+	{
+		scale = mip->esign * mip->estep / (2 * PI);
+		csi_w(cfd, "etrack");
+	}
+	else
+	{
+		scale = mip->sign * mip->step / (2 * PI);
+		csi_w(cfd, "mtrack");
+	}
+	csi_w(cfd, "(0,%.0f", 1000. * dt + .5);
+
+	/* TODO: pack into longer commands */
+	for (i = 0; i < PPTRACK; i++)
+	{
+		csi_w(cfd, ",%.0f", scale * pos[i] + .5);
+	}
+	csi_w(cfd, ");");
+	fflush(stdout);
+}
+
+/* build and load a rotator profile of PPTRACK points rdt secs apart from np,
+ * with its own clock. plan over twice as long so the rotator can start early
+ * on any rotation too fast to follow.
+ */
+static void buildRotTrack(Now *np, Obj *op)
+{
+	double rr[2 * PPTRACK];
+	double x, y, r0;
+	Now n = *np;
+	int i;
+
+	for (i = 2 * PPTRACK; --i >= 0;)
+	{
+		n.n_mjd = np->n_mjd + i * rdt / SPD;
+		findAxes(&n, op, &x, &y, &rr[i]);
+	}
+
+	/* start from where the rotator is, whole turns chosen by the limits */
+	(void) chkLimits(1, &x, &y, &rr[0]);
+	derotUnwrap(rr, 2 * PPTRACK);
+	if (derotFit(rr, 2 * PPTRACK, RMOT->neglim, RMOT->poslim) < 0)
+		tdlog("Rotator profile held at its limit");
+	r0 = rr[0];
+	rr[0] = RMOT->cpos;
+	if (fabs(rr[0] - r0) > PI)
+		tdlog("Rotator is %.1f degs from its target", raddeg(rr[0] - r0));
+	(void) derotLimit(rr, 2 * PPTRACK, rdt, RVELFRAC * RMOT->maxvel);
+
+	csi_w(MIPSFD(RMOT), "clock=0;");
+	csi_w(MIPSFD(RMOT), "timeout=%d;", (int) ceil(PPTRACK * rdt * 1000));
+	sendTrack(RMOT, rr, rdt);
+
+	memcpy(rprof, rr, sizeof(rprof));
+	rstrack = np->n_mjd;
+	rtrackend = rstrack + RRELOAD * PPTRACK * rdt / SPD;
+	rprofok = 1;
+}
+
 /* build and load an e/mtrack sequence for op.
  * time starts at np. it is ok to modify np->n_mjd.
+ * while an intercept is under way the axes follow itraj[], in profiles of
+ * at most PPTRACK*IMAXDT secs so the points stay close enough to follow
+ * its acceleration.
  * N.B. we assume clocks have been set to 0
  */
 static void buildTrack(Now *np, Obj *op)
@@ -905,6 +1450,9 @@ static void buildTrack(Now *np, Obj *op)
 	double *x, *y, *r;
 	double *xyr[NMOT];
 	double mjd0;
+	double dur; /* secs covered by profile */
+	double t0; /* secs into itraj[] at mjd0 */
+	double ti; /* secs of intercept still to go, else 0 */
 	MotorInfo *mip;
 	int i;
 
@@ -916,48 +1464,81 @@ static void buildTrack(Now *np, Obj *op)
 	xyr[TEL_DM] = y;
 	xyr[TEL_RM] = r;
 
-	/* build list of PPTRACK values beginning at mjd */
+	/* an intercept gets short dense profiles, the last replaced once on
+	 * target.
+	 */
 	mjd0 = mjd;
-	for (i = 0; i < PPTRACK; i++)
+	t0 = (mjd0 - istart) * SPD;
+	ti = itime > t0 ? itime - t0 : 0;
+	if (ti == 0)
 	{
-		mjd = mjd0 + i * TRACKINT / (PPTRACK * SPD);
-		findAxes(np, op, &x[i], &y[i], &r[i]);
-		(void) chkLimits(1, &x[i], &y[i], &r[i]); /* let limit protect */
+		dur = TRACKINT;
+		trackend = mjd0 + TRACKINT / SPD;
 	}
-
-	/* send to each controller */
-	FEM (mip)
+	else if (ti + ITAIL > PPTRACK * IMAXDT)
 	{
-		double scale;
-		double *xyrp;
-		int cfd;
-
-		if (!mip->have || mip->xtrack)
-			continue;
+		dur = PPTRACK * IMAXDT;
+		trackend = mjd0 + dur / 2 / SPD;
+	}
+	else
+	{
+		dur = ti + ITAIL;
+		trackend = mjd0 + (ti + ITAIL / 2) / SPD;
+	}
 
-		xyrp = xyr[mip - telstatshmp->minfo];
-		cfd = MIPCFD(mip);
-		//	    tdlog ("Creating track profile:");
-		if (mip->haveenc)
+	/* build list of PPTRACK values beginning at mjd.
+	 * fixed objects can usually skip the full reduction for each.
+	 */
+	if (op->o_type != FIXED || fastTrack(np, op, dur, x, y, r) < 0)
+	{
+		for (i = 0; i < PPTRACK; i++)
 		{
-			scale = mip->esign * mip->estep / (2 * PI);
-			csi_w(cfd, "etrack");
+			mjd = mjd0 + i * dur / (PPTRACK * SPD);
+			findAxes(np, op, &x[i], &y[i], &r[i]);
+			(void) chkLimits(1, &x[i], &y[i], &r[i]); /* let limit protect */
 		}
+		mjd = mjd0;
+	}
+	for (i = 0; i < PPTRACK && i * dur / PPTRACK < ti; i++)
+	{
+		double t = i * dur / PPTRACK;
+
+		x[i] = axisTrajPos(&itraj[TEL_HM], t0 + t);
+		y[i] = axisTrajPos(&itraj[TEL_DM], t0 + t);
+		r[i] = axisTrajPos(&itraj[TEL_RM], t0 + t);
+	}
+
+	/* the rotator gets its own denser profile if the field spins fast */
+	rprofok = 0;
+	if (RMOT->have && !RMOT->xtrack)
+	{
+		double dt = dur / PPTRACK;
+
+		derotUnwrap(r, PPTRACK);
+		if (derotFit(r, PPTRACK, RMOT->neglim, RMOT->poslim) < 0)
+			tdlog("Rotator profile held at its limit");
+		rdt = ti > 0 ? dt : derotStep(r, PPTRACK, dt, RDEROTTOL, RMINDT);
+		if (rdt < dt)
+			buildRotTrack(np, op);
 		else
 		{
-			scale = mip->sign * mip->step / (2 * PI);
-			csi_w(cfd, "mtrack");
+			if (ti == 0)
+				(void) derotLimit(r, PPTRACK, dt, RVELFRAC * RMOT->maxvel);
+			memcpy(rprof, r, sizeof(rprof));
+			rstrack = mjd0;
+			rtrackend = 0;
+			rprofok = 1;
 		}
-		csi_w(cfd, "(0,%.0f", 1000. * TRACKINT / PPTRACK + .5);
+		telstatshmp->Rdt = rdt;
+	}
 
-		/* TODO: pack into longer commands */
-		for (i = 0; i < PPTRACK; i++)
-		{
-			csi_w(cfd, ",%.0f", scale * xyrp[i] + .5);
-		}
-		csi_w(cfd, ");");
+	/* send to each controller */
+	FEM (mip)
+	{
+		if (!mip->have || mip->xtrack || (mip == RMOT && rtrackend))
+			continue;
+		sendTrack(mip, xyr[mip - telstatshmp->minfo], dur / PPTRACK);
 	}
-	fflush(stdout);
 
 	/* done */
 	free((void *) x);
@@ -999,6 +1580,40 @@ static void tel_set_xdelta(double HA, double DEC)
 	return;
 }
 
+/* note how long one csimcd round trip took, secs, to size the xtrack horizon.
+ * keep a smoothed mean for the record and a slowly decaying peak to plan by.
+ */
+static void xtNoteLatency(double dt)
+{
+	static double peak;
+
+	telstatshmp->xtlatency = 0.9 * telstatshmp->xtlatency + 0.1 * dt;
+	peak *= XTLATDECAY;
+	if (dt > peak)
+		peak = dt;
+
+	telstatshmp->xthorizon = XTRACKHORIZON > 0 ? XTRACKHORIZON
+			: 2.0 * XTRACKINT;
+	if (telstatshmp->xthorizon < XTRACKINT + XTLATMARGIN * peak)
+		telstatshmp->xthorizon = XTRACKINT + XTLATMARGIN * peak;
+}
+
+/* send whatever xpos points are waiting in buf to the axis on cfd */
+static void xtFlush(int cfd, char *buf, int *np)
+{
+	if (*np)
+	{
+		csi_w(cfd, "%s", buf);
+		buf[0] = '\0';
+		*np = 0;
+	}
+}
+
+/* keep each xtrack axis supplied with xpos points out to the current horizon
+ * past the controller clock. points for each axis are packed up to
+ * XTRACKBATCH per packet.
+ * return 0 if ok, else -1 if must stop.
+ */
 static int buildXTrack(Now *np, Obj *op)
 {
 	double x, y, r;
@@ -1011,6 +1626,9 @@ static int buildXTrack(Now *np, Obj *op)
 	int axis;
 	static int axrelax[NMOT];
 	static float axjit[NMOT];
+	char pk[NMOT][PMXDAT + 1]; /* xpos points waiting to send */
+	int npk[NMOT]; /* n points in pk[] */
+	int batch = XTRACKBATCH > 0 ? XTRACKBATCH : 1;
 
 	double tnow = (localNow.n_mjd - xstrack) * SPD;
 
@@ -1018,12 +1636,28 @@ static int buildXTrack(Now *np, Obj *op)
 	if(xttrack==0) {
 	  int idx;
 	  for(idx=0; idx<NMOT; idx++) {
-	    axrelax[idx]=4;
-	    axjit[idx]=0.5;
+	    axrelax[idx]=XTRACKRELAX;
+	    axjit[idx]=XTRACKJIT;
 	  }
+	  telstatshmp->xtqdepth = 0;
+	  telstatshmp->xtunderrun = 0;
+	  if (telstatshmp->xthorizon < XTRACKINT)
+		telstatshmp->xthorizon = 2.0 * XTRACKINT;
+	}
+	else if (xttrack - XTRACKINT <= tnow)
+	{
+		/* the last point we sent is already past */
+		if (telstatshmp->xtunderrun++ == 0)
+			tdlog("xtrack queue ran dry %.1f secs after start", tnow);
+	}
+
+	for (axis = 0; axis < NMOT; axis++)
+	{
+		pk[axis][0] = '\0';
+		npk[axis] = 0;
 	}
 
-	while ((xttrack - tnow) <= 2 * XTRACKINT)
+	while ((xttrack - tnow) <= telstatshmp->xthorizon)
 	{
 		xyr[TEL_HM] = &x;
 		xyr[TEL_DM] = &y;
@@ -1033,6 +1667,13 @@ static int buildXTrack(Now *np, Obj *op)
 		localNow.n_mjd = xstrack + xttrack / SPD;
 		findAxes(&localNow, op, &x, &y, &r);
 		(void) chkLimits(1, &x, &y, &r); /* let limit protect */
+		if (xttrack < itime)
+		{
+			/* on the way to intercept, xpos times are whole secs */
+			x = axisTrajPos(&itraj[TEL_HM], xttrack);
+			y = axisTrajPos(&itraj[TEL_DM], xttrack);
+			r = axisTrajPos(&itraj[TEL_RM], xttrack);
+		}
 
 		FEM(mip)
 		{
@@ -1073,19 +1714,51 @@ static int buildXTrack(Now *np, Obj *op)
 				}
 				else
 				{
-					csi_w(cfd, "xpos(%.0f,%.0f);", round(xttrack), rpos);
+					char pt[64];
+					int l = sprintf(pt, "xpos(%.0f,%.0f);", round(xttrack),
+							rpos);
+
+					if (strlen(pk[axis]) + l > PMXDAT)
+						xtFlush(cfd, pk[axis], &npk[axis]);
+					strcat(pk[axis], pt);
+					if (++npk[axis] >= batch)
+						xtFlush(cfd, pk[axis], &npk[axis]);
 				}
 				axrelax[axis]/=2;
 				axjit[axis]=-axjit[axis];
-
-				fflush(stdout);
 			}
 		}
-		xttrack += XTRACKINT;
+		xttrack += xttrack < itime ? 1 : XTRACKINT;
+	}
+
+	FEM(mip)
+	{
+		axis = mip - telstatshmp->minfo;
+		if (mip->have && mip->xtrack)
+			xtFlush(MIPCFD(mip), pk[axis], &npk[axis]);
 	}
+
+	/* points now queued ahead of the controller */
+	telstatshmp->xtqdepth = xtDepth(tnow);
 	return 0;
 }
 
+/* return the number of xpos points sent for times after tnow.
+ * they are 1 sec apart up to the intercept, XTRACKINT after.
+ */
+static int xtDepth(double tnow)
+{
+	double k = ceil(itime); /* first point XTRACKINT from the next */
+	double end = xttrack < k ? xttrack : k; /* end of the 1 sec points */
+	int n = 0;
+
+	if (end > tnow)
+		n += (int) (end - floor(tnow)) - 1;
+	if (xttrack > k)
+		n += (int) floor((xttrack - (tnow > k ? tnow : k)) / XTRACKINT);
+	return (n);
+}
+
 double xgetvar(int sfd, int index)
 {
 	double value;
@@ -1114,6 +1787,7 @@ static int trackObj(Obj *op, int first)
 	Now now = telstatshmp->now; /* stable and changeable copy */
 	double ra, dec, lst, ha;
 	double x, y, r;
+	double t0;
 	int clocknow;
 	MotorInfo *mip;
 
@@ -1123,6 +1797,13 @@ static int trackObj(Obj *op, int first)
 			xtrack_mode = 1;
 	}
 
+	/* plan how to catch up with the target from where we are now */
+	if (first)
+	{
+		readRaw();
+		planIntercept(&now, op);
+	}
+
 	//ICE
 	if (xtrack_mode)
 	{
@@ -1133,14 +1814,16 @@ static int trackObj(Obj *op, int first)
 		}
 
 		int error;
+		t0 = profNow();
 		error = buildXTrack(&now, op);
+		profStop(PS_BUILDXTRACK, t0);
 		if (error)
 			return -1;
 	}
 	//	else
 	{
 		/* download tracking profile if new or expired */
-		if (first || mjd > strack + TRACKINT / SPD)
+		if (first || mjd > trackend)
 		{
 			/* sync all clocks to 0 */
 			/* N.B. use MIPSFD to insure precedes main loop clock reads */
@@ -1187,19 +1870,22 @@ static int trackObj(Obj *op, int first)
 			}
 
 			/* now build and install tracking profiles */
+			t0 = profNow();
 			buildTrack(&now, op);
+			profStop(PS_BUILDTRACK, t0);
+		}
+		/* a dense rotator profile runs out sooner */
+		else if (rtrackend && mjd > rtrackend)
+		{
+			buildRotTrack(&now, op);
 		}
 	}
 	//ICE
 
-	/* update actual position info */
-	readRaw();
-
-	/* quick, get current value of typical clock.
+	/* update actual position info, and get current value of typical clock.
 	 * use this to compute desired to avoid host computer time jitter
 	 */
-	mip = HMOT->have ? HMOT : DMOT; /* surely we have one ! */
-	clocknow = csi_rix(MIPSFD(mip), "=clock;");
+	mip = readRawClock(&clocknow);
 
 	mkCook();
 
@@ -1222,6 +1908,7 @@ static int trackObj(Obj *op, int first)
 				"Motion controller clock drift exceeds %g sec: %g", MAXJITTER,
 				x);
 		fifoWrite(Tel_Id, -5, "clocknow=%d. strack=%g", clocknow, strack);
+		profLog(0); /* where did the time go */
 		stopTel(0);
 		return (-1);
 	}
@@ -1248,6 +1935,14 @@ static int trackObj(Obj *op, int first)
 	DMOT->dpos = y;
 	RMOT->dpos = r;
 
+	/* the rotator follows its speed-limited profile, not the field itself */
+	if (RMOT->have && rprofok)
+	{
+		x = derotAt(rprof, PPTRACK, rdt, (now.n_mjd - rstrack) * SPD);
+		RMOT->dpos = r + pmPI(x - r);
+		telstatshmp->Rerr = pmPI(RMOT->cpos - r);
+	}
+
 	/* check progress, revert to hunting if lose track */
 	switch (telstatshmp->telstate)
 	{
@@ -1268,6 +1963,7 @@ static int trackObj(Obj *op, int first)
 					4,
 					"Axis %d lost tracking lock deltaradians=%f (set TRACKACC telescope.cfg)",
 					mip->axis, delra(mip->cpos - mip->dpos));
+			profLog(0);
 			telstatshmp->telstate = TS_HUNTING;
 			telstatshmp->telstateidx++;
 		}
@@ -1287,7 +1983,21 @@ static int trackObj(Obj *op, int first)
  */
 static void findAxes(Now *np, Obj *op, double *xp, double *yp, double *rp)
 {
-	double ha, dec;
+	double ha, dec, ra, adec;
+	double t0 = profNow();
+
+	findHADec(np, op, &ha, &dec, &ra, &adec);
+	hd2xyr(ha, dec, xp, yp, rp);
+	profStop(PS_FINDAXES, t0);
+}
+
+/* find the refracted apparent ha/dec of op at np, allowing for any
+ * r_offset/d_offset. also return the unrefracted apparent ra/dec.
+ * N.B. o_type of *op may be different upon return.
+ */
+static void findHADec(Now *np, Obj *op, double *hap, double *decp, double *rap,
+		double *adecp)
+{
 	Obj fobj;
 
 	if (r_offset || d_offset)
@@ -1305,6 +2015,7 @@ static void findAxes(Now *np, Obj *op, double *xp, double *yp, double *rp)
 		dec += d_offset;
 
 		op = &fobj;
+		memset((void *) op, 0, sizeof(*op));
 		op->o_type = FIXED;
 		op->f_RA = ra;
 		op->f_dec = dec;
@@ -1313,8 +2024,9 @@ static void findAxes(Now *np, Obj *op, double *xp, double *yp, double *rp)
 
 	epoch = EOD;
 	obj_cir(np, op);
-	aa_hadec(lat, op->s_alt, op->s_az, &ha, &dec);
-	hd2xyr(ha, dec, xp, yp, rp);
+	aa_hadec(lat, op->s_alt, op->s_az, hap, decp);
+	*rap = op->s_ra;
+	*adecp = op->s_dec;
 }
 
 /* convert an ha/dec to scope x/y/r, allowing for mesh corrections.
@@ -1322,14 +2034,21 @@ static void findAxes(Now *np, Obj *op, double *xp, double *yp, double *rp)
  */
 static void hd2xyr(double ha, double dec, double *xp, double *yp, double *rp)
 {
-	TelAxes *tap = &telstatshmp->tax;
 	double mdha, mddec;
-	double x, y, r;
 
 	tel_mount_cor(ha, dec, &mdha, &mddec);
 	//tdlog("hd2xyr: ha %.4lf dec %.4lf mdha %.4lf mddec %.4lf\n",ha,dec,mdha,mddec);
 	ha += mdha;
 	dec += mddec;
+	hdm2xyr(ha, dec, xp, yp, rp);
+}
+
+/* convert an ha/dec, already corrected by the mesh, to scope x/y/r */
+static void hdm2xyr(double ha, double dec, double *xp, double *yp, double *rp)
+{
+	TelAxes *tap = &telstatshmp->tax;
+	double x, y, r;
+
 	hdRange(&ha, &dec);
 	//tdlog("ha and dec after hdRange: %.4lf  %.4lf\n",ha,dec);
 	tel_hadec2xy(ha, dec, tap, &x, &y);
@@ -1360,6 +2079,7 @@ static void mkCook()
 	double lst, ra, ha, dec, alt, az;
 	double mdha, mddec;
 	double x, y, r;
+	double t0 = profNow();
 
 	/* handy axis values */
 	x = HMOT->cpos;
@@ -1405,35 +2125,70 @@ static void mkCook()
 	/* find position angle */
 	tel_hadec2PA(ha, dec, tap, lat, &r);
 	telstatshmp->CPA = r;
+	profStop(PS_MKCOOK, t0);
 }
 
 /* read the raw values */
 static void readRaw()
 {
+	(void) readRawClock(NULL);
+}
+
+/* read the raw values, and if clockp the clock of a typical axis into
+ * *clockp, fetched in the same GETVAR as that axis' position.
+ * return that axis.
+ */
+static MotorInfo *readRawClock(int *clockp)
+{
+	MotorInfo *cmip = HMOT->have ? HMOT : DMOT; /* surely we have one ! */
 	MotorInfo *mip;
+	double t0 = profNow();
 
 	FEM(mip)
 	{
+		CSIVar refs[2];
+		char *exprs[2];
+		int vals[2];
+		int n = 1;
+		double t1;
+
 		if (!mip->have)
 			continue;
 
+		refs[0] = mip->haveenc ? CV_EPOS : CV_MPOS;
+		exprs[0] = mip->haveenc ? "=epos;" : "=mpos;";
+		if (clockp && mip == cmip)
+		{
+			refs[n] = CV_CLOCK;
+			exprs[n++] = "=clock;";
+		}
+		t1 = profNow();
+		csiGetVars(mip, n, refs, exprs, vals);
+		if (n > 1)
+		{
+			*clockp = vals[1];
+			xtNoteLatency(profNow() - t1);
+			profStop(PS_CLOCK, t1);
+		}
+
 		if (mip->haveenc)
 		{
 			double draw;
-			int raw;
+			int raw = vals[0];
 			/* just change by half-step if encoder changed by 1 */
-			raw = csi_rix(MIPSFD(mip), "=epos;");
 			draw = abs(raw - mip->raw) == 1 ? (raw + mip->raw) / 2.0 : raw;
 			mip->raw = raw;
 			mip->cpos = (2 * PI) * mip->esign * draw / mip->estep;
 		}
 		else
 		{
-			mip->raw = csi_rix(MIPSFD(mip), "=mpos;");
+			mip->raw = vals[0];
 			mip->cpos = (2 * PI) * mip->sign * mip->raw / mip->step;
 		
 		}
 	}
+	profStop(PS_READRAW, t0);
+	return (cmip);
 }
 
 /* issue a stop to all telescope axes */
@@ -1916,6 +2671,24 @@ static void initCfg()
 	{
 	{ "LARGEXP", CFG_INT, &LARGEXP }, };
 
+	/* optional, when limits were last found, see axes.c */
+	static CfgEntry hcfg3[] =
+	{
+	{ "HLIMMJD", CFG_DBL, &limmjd[TEL_HM] },
+	{ "DLIMMJD", CFG_DBL, &limmjd[TEL_DM] },
+	{ "RLIMMJD", CFG_DBL, &limmjd[TEL_RM] }, };
+	static CfgEntry lkcfg[] =
+	{
+	{ "LIMITSKEEP", CFG_DBL, &LIMITSKEEP }, };
+
+	/* optional xtrack streaming tuning */
+	static CfgEntry xtcfg[] =
+	{
+	{ "XTRACKHORIZON", CFG_DBL, &XTRACKHORIZON },
+	{ "XTRACKBATCH", CFG_INT, &XTRACKBATCH },
+	{ "XTRACKRELAX", CFG_INT, &XTRACKRELAX },
+	{ "XTRACKJIT", CFG_DBL, &XTRACKJIT }, };
+
 	MotorInfo *mip;
 	TelAxes *tap;
 	int n;
@@ -1944,6 +2717,17 @@ static void initCfg()
 		XP += (PI / 2);
 	}
 
+	memset((void *) limmjd, 0, sizeof(limmjd));
+	(void) readCfgFile(1, hcfn, hcfg3, sizeof(hcfg3) / sizeof(hcfg3[0]));
+	LIMITSKEEP = 30;
+	(void) readCfgFile(1, tdcfn, lkcfg, 1);
+
+	XTRACKHORIZON = 0;
+	XTRACKBATCH = 3;
+	XTRACKRELAX = 4;
+	XTRACKJIT = 0.5;
+	(void) readCfgFile(1, tdcfn, xtcfg, sizeof(xtcfg) / sizeof(xtcfg[0]));
+
 	/* misc checks */
 	if (TRACKINT <= 0)
 	{
@@ -2130,10 +2914,84 @@ static void initCfg()
 	/* re-read the mesh  file */
 	init_mount_cor();
 
+	/* this is now what hot reloads are compared with */
+	reload_snap();
+
 #undef	NTDCFG
 #undef	NHCFG
 }
 
+/* re-read just the telescoped.cfg entries that may change while tracking,
+ * see reload.c. all are read and checked before any is used.
+ * return 0 if ok, else -1 and nothing changes.
+ */
+int tel_reload()
+{
+#define	NRCFG	(sizeof(rcfg)/sizeof(rcfg[0]))
+#define	NRREQ	4	/* the first NRREQ in rcfg[] must be present */
+
+	static double trackacc, fguidevel, cguidevel, xthorizon, xtjit, limkeep;
+	static int trackint, xtbatch, xtrelax;
+
+	static CfgEntry rcfg[] =
+	{
+	{ "TRACKINT", CFG_INT, &trackint },
+	{ "TRACKACC", CFG_DBL, &trackacc },
+	{ "FGUIDEVEL", CFG_DBL, &fguidevel },
+	{ "CGUIDEVEL", CFG_DBL, &cguidevel },
+
+	{ "XTRACKHORIZON", CFG_DBL, &xthorizon },
+	{ "XTRACKBATCH", CFG_INT, &xtbatch },
+	{ "XTRACKRELAX", CFG_INT, &xtrelax },
+	{ "XTRACKJIT", CFG_DBL, &xtjit },
+	{ "LIMITSKEEP", CFG_DBL, &limkeep }, };
+
+	int n;
+
+	/* same defaults as initCfg() */
+	xthorizon = 0;
+	xtbatch = 3;
+	xtrelax = 4;
+	xtjit = 0.5;
+	limkeep = 30;
+
+	n = readCfgFile(1, tdcfn, rcfg, NRCFG);
+	if (n < 0)
+	{
+		cfgFileError(tdcfn, n, (CfgPrFp) tdlog, rcfg, NRCFG);
+		return (-1);
+	}
+	for (n = 0; n < NRREQ; n++)
+	{
+		if (!rcfg[n].found)
+		{
+			tdlog("%s: %s not found", basenm(tdcfn), rcfg[n].name);
+			return (-1);
+		}
+	}
+	if (trackint <= 0)
+	{
+		tdlog("TRACKINT must be > 0\n");
+		return (-1);
+	}
+
+	/* ok, all at once. a new TRACKINT starts with the next track */
+	TRACKINT = trackint;
+	TRACKACC = trackacc;
+	FGUIDEVEL = fguidevel;
+	CGUIDEVEL = cguidevel;
+	XTRACKHORIZON = xthorizon;
+	XTRACKBATCH = xtbatch;
+	XTRACKRELAX = xtrelax;
+	XTRACKJIT = xtjit;
+	LIMITSKEEP = limkeep;
+
+	return (0);
+
+#undef	NRCFG
+#undef	NRREQ
+}
+
 /* check for stuck axes.
  * return 0 if all ok, else -1
  */
@@ -3,19 +3,33 @@
  * N.B. see fifos[] in telescoped.c
  */
 typedef enum {
-    Tel_Id
+    Tel_Id, Guide_Id
 } FifoId;
 
 /* CSIMC info */
 typedef struct {
     int cfd;		/* command fifo, ok to leave return info pending */
     int sfd;		/* status fifo, always block to capture anything back */
+    int vfd;		/* binary variable channel, 0 if not in use */
 } CSIMCInfo;
 
+/* one axis trajectory from rest to a moving target, see intercept.c */
+typedef struct {
+    double x0;		/* start position, rads */
+    double s;		/* +1 or -1, direction of peak velocity */
+    double a;		/* acceleration used, rads/sec/sec */
+    double vp;		/* peak speed, rads/sec */
+    double v1;		/* final velocity in direction s, rads/sec */
+    double tw;		/* secs waiting at rest before starting */
+    double t1, t2, t3;	/* secs accelerating, cruising, matching v1 */
+} AxisTraj;
+
 #define	MIPCFD(mip)	(csii[(int)((mip)->axis)].cfd)	/* handy mip ==> cfd */
 #define	MIPSFD(mip)	(csii[(int)((mip)->axis)].sfd)	/* handy mip ==> sfd */
+#define	MIPVFD(mip)	(csii[(int)((mip)->axis)].vfd)	/* handy mip ==> vfd */
 
 /* axes.c */
+extern double axisSeekTime (MotorInfo *mip);
 extern int axis_home (MotorInfo *mip, FifoId fid, int first);
 extern int axis_limits (MotorInfo *mip, FifoId fid, int first);
 extern int axisLimitCheck (MotorInfo *mip, char msgbuf[]);
@@ -31,21 +45,85 @@ extern void csiStop (MotorInfo *mip, int fast);
 extern void csiiOpen (MotorInfo *mip);
 extern void csiiClose (MotorInfo *mip);
 extern int csiOpen (int addr);
+extern void csiGetVars (MotorInfo *mip, int n, CSIVar refs[],
+    char *exprs[], int vals[]);
+extern int csiGetVar (MotorInfo *mip, CSIVar ref, char *expr);
 extern int csiClose (int addr);
 extern int csiIsReady (int fd);
 
+/* derot.c */
+extern void derotUnwrap (double r[], int n);
+extern int derotFit (double r[], int n, double lo, double hi);
+extern double derotStep (double r[], int n, double dt, double tol,
+    double mindt);
+extern double derotLimit (double r[], int n, double dt, double vmax);
+extern double derotAt (double r[], int n, double dt, double t);
+
 /* fifoio.c */
 extern void fifoWrite (FifoId f, int code, char *fmt, ...);
 extern void init_fifos(void);
 extern void chk_fifos(void);
 extern void close_fifos(void);
 
+/* guide.c */
+extern void guide_msg (char *msg);
+
+/* intercept.c */
+extern double axisMinTime (MotorInfo *mip, double d, double v1);
+extern int axisPlan (MotorInfo *mip, double x0, double x1, double v1,
+    double T, AxisTraj *tp);
+extern double axisTrajPos (AxisTraj *tp, double t);
+
 /* mountcor.c */
+extern char meshfn[];
+extern char mbinfn[];
 extern void init_mount_cor(void);
+extern int reload_mount_cor(void);
 extern void tel_mount_cor (double ha, double dec, double *dhap, double *ddecp);
 
+/* prof.c */
+typedef enum {
+    PS_CYCLE,			/* one pass of chk_fifos() after select() */
+    PS_READRAW,			/* reading all axis positions */
+    PS_CLOCK,			/* reading the controller clock */
+    PS_MKCOOK,			/* axes to sky */
+    PS_FINDAXES,		/* sky to axes */
+    PS_BUILDTRACK,		/* building and loading a track profile */
+    PS_BUILDXTRACK,		/* building and streaming xtrack points */
+    PS_LOG,			/* tdlog() */
+    PS_N
+} ProfStage;
+extern double profNow (void);
+extern void profStop (ProfStage s, double t0);
+extern void profLog (int fifo);
+extern void profReset (void);
+
+/* reload.c */
+extern void init_reload(void);
+extern void close_reload(void);
+extern void reload_snap(void);
+extern void reload_fdset (fd_set *fsp, int *maxfdp);
+extern void reload_read (fd_set *fsp);
+
+/* sockserv.c */
+extern void init_socks(void);
+extern void close_socks(void);
+extern void sock_fdset (fd_set *fsp, int *maxfdp);
+extern void sock_read (fd_set *fsp);
+extern void sock_poll(void);
+extern void sock_fifocmd (char *msg);
+extern void sock_reply (int code, char *msg);
+
+/* statserv.c */
+extern void init_stats(void);
+extern void close_stats(void);
+extern void stat_fdset (fd_set *fsp, int *maxfdp);
+extern void stat_read (fd_set *fsp);
+extern void stat_poll(void);
+
 /* tel.c */
 extern void tel_msg (char *msg);
+extern int tel_reload (void);
 
 /* telescoped.c */
 extern double STOWALT, STOWAZ;
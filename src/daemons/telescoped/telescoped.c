@@ -13,6 +13,11 @@
  *
  * FIFO pairs:
  *   Tel	telescope axes, field rotator
+ *   Guide	autoguider corrections while tracking, see guide.c
+ *
+ * Sockets, in comm with the fifos:
+ *   Tel.sock	Tel commands from several clients at once, see sockserv.c
+ *   TelStat.sock	binary status frames, see statserv.c
  *
  * v0.1	10/28/93 First draft: Elwood C. Downey
  */
@@ -30,8 +35,10 @@
 #include <sys/shm.h>
 
 #include "P_.h"
+#include "astro.h"
 #include "circum.h"
 #include "configfile.h"
+#include "misc.h"
 #include "strops.h"
 #include "telstatshm.h"
 #include "running.h"
@@ -55,6 +62,8 @@ static void on_sig(int fake);
 static void main_loop(void);
 
 static char logdir[] = "archive/logs";
+
+#define TSDAYS  32          /* days of time scale tables built on reset */
 static char *progname;
 
 // Global values read from config
@@ -107,6 +116,7 @@ void
 tdlog (char *fmt, ...)
 {
     char buf[1024];
+    double t0 = profNow();
     va_list ap;
     int l;
 
@@ -127,6 +137,7 @@ tdlog (char *fmt, ...)
     /* log to stdout */
     fputs (buf, stdout);
     fflush (stdout);
+    profStop (PS_LOG, t0);
 }
 
 /* stop the telescope then exit */
@@ -179,6 +190,10 @@ init_cfg()
     pressure = PRESSURE;		/* we want mB */
     elev = ELEVATION/ERAD;		/* we want earth radii*/
 
+    /* time scale tables from yesterday on; beyond falls back to full calcs */
+    if (ts_init (mjd_now() - 1, TSDAYS) < 0)
+        tdlog ("No memory for time scale tables");
+
 #undef NTSCFG
 }
 
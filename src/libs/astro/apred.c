@@ -0,0 +1,236 @@
+/* batch reduction of star lists from mean catalogue place to geocentric
+ * apparent place of date.
+ *
+ * precession, nutation and the earth's position and velocity only depend on
+ * the two epochs involved so they are folded into an APTerms once with
+ * ap_terms() and then applied to any number of stars with ap_reduce(). the
+ * per-star work is then just a 3x3 rotation, a few vector adds and the
+ * conversions in and out of cartesian. stars are handled in blocks so the
+ * arithmetic pass runs over plain arrays without any branches, which leaves
+ * the compiler free to vectorize it.
+ *
+ * the precession angles and nutation rotation are the same as used by
+ * precess() and nut_eq(); aberration uses the same secular orbit as ab_eq().
+ * relativistic light deflection is not included; it is < .01" except within
+ * a few degrees of the sun.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+
+#define ABERR_CONST	(20.49552/3600./180.*PI)  /* aberr const in rad */
+#define	DAYPERYR	365.25		/* julian year, for proper motion */
+#define	APBLK		64		/* stars per pass */
+
+static void ap_prec P_((double yr, double p[3][3]));
+
+/* fill in *tp with everything needed to reduce stars whose positions and
+ * equinox are for mjd0 to apparent place at mjd.
+ */
+void
+ap_terms (mjd0, mjd, tp)
+double mjd0, mjd;
+APTerms *tp;
+{
+	double p0[3][3], p1[3][3], n[3][3], pt[3][3];
+	double yr0, yr1;
+	double eps, deps, dpsi;
+	double se, ce, sp, cp, sede, cede;
+	double lsn, rsn;
+	double T, eexc, leperi;
+	double vx, vy;
+	int i, j, k;
+
+	tp->mjd0 = mjd0;
+	tp->mjd = mjd;
+	tp->dt = (mjd - mjd0)/DAYPERYR;
+
+	/* precession mjd0 to J2000 is the transpose of J2000 to mjd0 */
+	mjd_year (mjd0, &yr0);
+	mjd_year (mjd, &yr1);
+	ap_prec (yr0, p0);
+	ap_prec (yr1, p1);
+	for (i = 0; i < 3; i++)
+	    for (j = 0; j < 3; j++) {
+		double s = 0;
+		for (k = 0; k < 3; k++)
+		    s += p1[i][k]*p0[j][k];
+		pt[i][j] = s;
+	    }
+
+	/* nutation, just as in nut_eq() */
+	obliquity (mjd, &eps);
+	nutation (mjd, &deps, &dpsi);
+	se = sin(eps);
+	ce = cos(eps);
+	sp = sin(dpsi);
+	cp = cos(dpsi);
+	sede = sin(eps + deps);
+	cede = cos(eps + deps);
+
+	n[0][0] = cp;
+	n[0][1] = -sp*ce;
+	n[0][2] = -sp*se;
+	n[1][0] = cede*sp;
+	n[1][1] = cede*cp*ce+sede*se;
+	n[1][2] = cede*cp*se-sede*ce;
+	n[2][0] = sede*sp;
+	n[2][1] = sede*cp*ce-cede*se;
+	n[2][2] = sede*cp*se+cede*ce;
+
+	/* combined matrix, mean of mjd0 to true of mjd */
+	for (i = 0; i < 3; i++)
+	    for (j = 0; j < 3; j++) {
+		double s = 0;
+		for (k = 0; k < 3; k++)
+		    s += n[i][k]*pt[k][j];
+		tp->m[i][j] = s;
+	    }
+
+	/* earth velocity in units of c, from the same secular orbit as
+	 * ab_eq(). in ecliptic coords the earth moves towards lsn-90 degs.
+	 */
+	sunpos (mjd + ts_deltat(mjd)/86400.0, &lsn, &rsn, NULL);
+	T = (mjd - J2000)/36525.;
+	eexc = 0.016708617 - (42.037e-6 + 0.1236e-6 * T) * T;
+	leperi = degrad(102.93735 + (0.71953 + 0.00046 * T) * T);
+	vx = ABERR_CONST*(sin(lsn) - eexc*sin(leperi));
+	vy = -ABERR_CONST*(cos(lsn) - eexc*cos(leperi));
+	tp->v[0] = vx;
+	tp->v[1] = vy*ce;
+	tp->v[2] = vy*se;
+
+	/* heliocentric earth position, AU, equatoreal of date */
+	tp->e[0] = -rsn*cos(lsn);
+	tp->e[1] = -rsn*sin(lsn)*ce;
+	tp->e[2] = -rsn*sin(lsn)*se;
+}
+
+/* reduce n stars at *tp->mjd0 to apparent place at tp->mjd, IN PLACE.
+ * ra[] and dec[] are in radians. pmra[] is the proper motion in ra, already
+ * multiplied by cos(dec), and pmdec[] that in dec, both in rads/year; px[]
+ * is the annual parallax in rads. any of pmra, pmdec or px may be NULL if
+ * none of the stars have them.
+ */
+void
+ap_reduce (tp, n, ra, dec, pmra, pmdec, px)
+APTerms *tp;
+int n;
+double ra[], dec[];
+double pmra[], pmdec[], px[];
+{
+	double x[APBLK], y[APBLK], z[APBLK];
+	double w[APBLK];
+	double tx[APBLK], ty[APBLK], tz[APBLK];
+	double dt = tp->dt;
+	double m00 = tp->m[0][0], m01 = tp->m[0][1], m02 = tp->m[0][2];
+	double m10 = tp->m[1][0], m11 = tp->m[1][1], m12 = tp->m[1][2];
+	double m20 = tp->m[2][0], m21 = tp->m[2][1], m22 = tp->m[2][2];
+	double vx = tp->v[0], vy = tp->v[1], vz = tp->v[2];
+	double ex = tp->e[0], ey = tp->e[1], ez = tp->e[2];
+	int b, i, nb;
+
+	for (b = 0; b < n; b += APBLK) {
+	    nb = n - b < APBLK ? n - b : APBLK;
+
+	    /* unit vectors plus space motion over dt in the mean frame */
+	    for (i = 0; i < nb; i++) {
+		double sa = sin(ra[b+i]), ca = cos(ra[b+i]);
+		double sd = sin(dec[b+i]), cd = cos(dec[b+i]);
+		double pa = pmra ? pmra[b+i]*dt : 0.0;
+		double pd = pmdec ? pmdec[b+i]*dt : 0.0;
+
+		x[i] = cd*ca - pa*sa - pd*sd*ca;
+		y[i] = cd*sa + pa*ca - pd*sd*sa;
+		z[i] = sd + pd*cd;
+		w[i] = px ? px[b+i] : 0.0;
+	    }
+
+	    /* rotate to true of date, remove parallax, add aberration */
+	    for (i = 0; i < nb; i++) {
+		double xx, yy, zz, uv, r;
+
+		xx = m00*x[i] + m01*y[i] + m02*z[i] - w[i]*ex;
+		yy = m10*x[i] + m11*y[i] + m12*z[i] - w[i]*ey;
+		zz = m20*x[i] + m21*y[i] + m22*z[i] - w[i]*ez;
+		r = 1.0/sqrt(xx*xx + yy*yy + zz*zz);
+		xx *= r;
+		yy *= r;
+		zz *= r;
+
+		uv = xx*vx + yy*vy + zz*vz;
+		tx[i] = xx + vx - uv*xx;
+		ty[i] = yy + vy - uv*yy;
+		tz[i] = zz + vz - uv*zz;
+	    }
+
+	    /* back to spherical */
+	    for (i = 0; i < nb; i++) {
+		double a = atan2(ty[i], tx[i]);
+
+		ra[b+i] = a < 0 ? a + 2*PI : a;
+		dec[b+i] = atan2(tz[i], sqrt(tx[i]*tx[i] + ty[i]*ty[i]));
+	    }
+	}
+}
+
+/* correct ra and dec, in rads, for the annual parallax px, also in rads, at
+ * mjd, given the geocentric ecliptic longitude of the sun, lsn, and its
+ * distance, rsn, as from sunpos().
+ * N.B. ra and dec are modifed IN PLACE.
+ */
+void
+ap_parallax (mjd, lsn, rsn, px, ra, dec)
+double mjd, lsn, rsn, px;
+double *ra, *dec;
+{
+	double eps, x, y, z, r;
+
+	if (px == 0.0)
+	    return;
+
+	obliquity (mjd, &eps);
+	sphcart (*ra, *dec, 1.0, &x, &y, &z);
+	x += px*rsn*cos(lsn);
+	y += px*rsn*sin(lsn)*cos(eps);
+	z += px*rsn*sin(lsn)*sin(eps);
+	cartsph (x, y, z, ra, dec, &r);
+	if (*ra < 0.) *ra += 2.*PI;
+}
+
+/* rotation matrix for precession from J2000 to the given decimal year,
+ * using the same angles as precess().
+ */
+static void
+ap_prec (yr, p)
+double yr;
+double p[3][3];
+{
+	double T, zeta, z, theta;
+	double sze, cze, sz, cz, sth, cth;
+
+	T = (yr - 2000.0)/100.0;
+	zeta  = degrad(0.6406161* T + 0.0000839* T*T + 0.0000050* T*T*T);
+	z     = degrad(0.6406161* T + 0.0003041* T*T + 0.0000051* T*T*T);
+	theta = degrad(0.5567530* T - 0.0001185* T*T - 0.0000116* T*T*T);
+
+	sze = sin(zeta);
+	cze = cos(zeta);
+	sz = sin(z);
+	cz = cos(z);
+	sth = sin(theta);
+	cth = cos(theta);
+
+	p[0][0] = cze*cz*cth - sze*sz;
+	p[0][1] = -sze*cz*cth - cze*sz;
+	p[0][2] = -cz*sth;
+	p[1][0] = cze*sz*cth + sze*cz;
+	p[1][1] = -sze*sz*cth + cze*cz;
+	p[1][2] = -sz*sth;
+	p[2][0] = cze*sth;
+	p[2][1] = -sze*sth;
+	p[2][2] = cth;
+}
@@ -41,6 +41,17 @@
 #define MJD0  2415020.0
 #define J2000 (2451545.0 - MJD0)      /* let compiler optimise */
 
+/* everything needed to reduce many stars from mean place at mjd0 to
+ * apparent place at mjd. see apred.c.
+ */
+typedef struct {
+    double mjd0, mjd;	/* catalogue and apparent epochs */
+    double dt;		/* mjd - mjd0, years */
+    double m[3][3];	/* precession*nutation, mean of mjd0 to true of mjd */
+    double v[3];	/* earth velocity, units of c, equatoreal of date */
+    double e[3];	/* heliocentric earth position, AU, equatoreal of date */
+} APTerms;
+
 
 /* global function declarations */
 
@@ -60,6 +71,13 @@ extern void airmass P_((double aa, double *Xp));
 /* anomaly.c */
 extern void anomaly P_((double ma, double s, double *nu, double *ea));
 
+/* apred.c */
+extern void ap_terms P_((double mjd0, double mjd, APTerms *tp));
+extern void ap_reduce P_((APTerms *tp, int n, double ra[], double dec[],
+    double pmra[], double pmdec[], double px[]));
+extern void ap_parallax P_((double mjd, double lsn, double rsn, double px,
+    double *ra, double *dec));
+
 /* chap95.c */
 extern int chap95 P_((double mjd, int obj, double prec, double *ret));
 
@@ -136,6 +154,8 @@ extern void moon_colong P_((double jd, double lt, double lg, double *cp, double
 
 /* nutation.c */
 extern void nutation P_((double mjd, double *deps, double *dpsi));
+extern void nutation_n P_((int n, double mjd[], double deps[], double dpsi[],
+    int fast));
 extern void nut_eq P_((double mjd, double *ra, double *dec));
 
 /* obliq.c */
@@ -174,6 +194,12 @@ extern void cartsph P_((double x, double y, double z, double *l, double *b,
 /* sun.c */
 extern void sunpos P_((double mjd, double *lsn, double *rsn, double *bsn));
 
+/* tscale.c */
+extern int ts_init P_((double mjd, int ndays));
+extern double ts_deltat P_((double mjd));
+extern double ts_gmst P_((double mjd));
+extern double ts_gast P_((double mjd));
+
 /* utc_gst.c */
 extern void utc_gst P_((double mjd, double utc, double *gst));
 extern void gst_utc P_((double mjd, double gst, double *utc));
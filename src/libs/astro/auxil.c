@@ -43,5 +43,5 @@ double
 mm_mjed (np)
 Now *np;
 {
-	return (mjd + deltat(mjd)/86400.0);
+	return (mjd + ts_deltat(mjd)/86400.0);
 }
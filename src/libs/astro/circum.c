@@ -32,6 +32,7 @@ static void elongation P_((double lam, double bet, double lsn, double *el));
 static void deflect P_((double mjd1, double lpd, double psi, double rsn,
     double lsn, double rho, double *ra, double *dec));
 static double h_albsize P_((double H));
+static void fixed_pm P_((Obj *op, double mjd0, double *ra, double *dec));
 
 /* given a Now and an Obj, fill in the approprirate s_* fields within Obj.
  * return 0 if all ok, else -1.
@@ -117,8 +118,9 @@ Obj *op;
 	     * we change the original to save time next time assuming the
 	     * user is likely to stick with this for a while.
 	     */
-	    double tra = op->f_RA, tdec = op->f_dec;
+	    double tra, tdec;
 	    float tepoch = (float)epoch;	/* compare w/float precision */
+	    fixed_pm (op, tepoch, &tra, &tdec);
 	    precess (op->f_epoch, tepoch, &tra, &tdec);
 	    op->f_epoch = tepoch;
 	    op->f_RA = (float)tra;
@@ -126,8 +128,7 @@ Obj *op;
 	}
 
 	/* set ra/dec to astrometric @ epoch of date */
-	ra = op->f_RA;
-	dec = op->f_dec;
+	fixed_pm (op, mjd, &ra, &dec);
 	precess (op->f_epoch, mjd, &ra, &dec);
 
 	/* convert equatoreal ra/dec to mean geocentric ecliptic lat/long */
@@ -139,7 +140,8 @@ Obj *op;
 	/* allow for relativistic light bending near the sun */
 	deflect (mjd, lam, bet, lsn, rsn, 1e10, &ra, &dec);
 
-	/* TODO: correction for annual parallax would go here */
+	/* annual parallax */
+	ap_parallax (mjd, lsn, rsn, op->f_px, &ra, &dec);
 
 	/* correct EOD equatoreal for nutation/aberation to form apparent 
 	 * geocentric
@@ -182,6 +184,30 @@ Obj *op;
 	return (0);
 }
 
+/* find the ra/dec of fixed object op at mjd0, still referred to its own
+ * equinox f_epoch, after allowing for its proper motion since then.
+ */
+static void
+fixed_pm (op, mjd0, ra, dec)
+Obj *op;
+double mjd0;
+double *ra, *dec;
+{
+	double dt, cd;
+
+	*ra = op->f_RA;
+	*dec = op->f_dec;
+	if (op->f_pmRA == 0.0 && op->f_pmdec == 0.0)
+	    return;
+
+	dt = (mjd0 - op->f_epoch)/365.25;
+	cd = cos(*dec);
+	if (cd > 1e-9)
+	    *ra += op->f_pmRA*dt/cd;
+	*dec += op->f_pmdec*dt;
+	range (ra, 2*PI);
+}
+
 /* compute sky circumstances of an object in heliocentric elliptic orbit at *np.
  */
 static int
@@ -127,6 +127,9 @@ typedef struct {
     float fo_epoch;	/* epoch of f_RA/dec */
     float fo_ra;	/* ra, rads, at given epoch */
     float fo_dec;	/* dec, rads, at given epoch */
+    float fo_pmra;	/* proper motion in ra*cos(dec), rads/year */
+    float fo_pmdec;	/* proper motion in dec, rads/year */
+    float fo_px;	/* annual parallax, rads */
 } ObjF;
 
 #define	fo_mag	co_mag	/* pseudonym for so_mag since it is not computed */
@@ -279,6 +282,9 @@ typedef union {
 #define	f_epoch	f.fo_epoch
 #define	f_RA	f.fo_ra
 #define	f_dec	f.fo_dec
+#define	f_pmRA	f.fo_pmra
+#define	f_pmdec	f.fo_pmdec
+#define	f_px	f.fo_px
 #define	f_mag	f.fo_mag
 #define	f_size	f.fo_size
 
@@ -131,20 +131,15 @@ Now *np;
 double *lstp;
 {
 	static double last_mjd = -23243, last_lng = 121212, last_lst;
-	double eps, lst, deps, dpsi;
+	double lst;
 
 	if (last_mjd == mjd && last_lng == lng) {
 	    *lstp = last_lst;
 	    return;
 	}
 
-	utc_gst (mjd_day(mjd), mjd_hr(mjd), &lst);
-	lst += radhr(lng);
-
-	obliquity(mjd, &eps);
-	nutation(mjd, &deps, &dpsi);
-	lst += radhr(dpsi*cos(eps+deps));
-
+	/* gast includes the equation of the equinoxes */
+	lst = ts_gast (mjd) + radhr(lng);
 	range (&lst, 24.0);
 
 	last_mjd = mjd;
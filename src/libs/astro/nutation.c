@@ -9,7 +9,6 @@
 
 #define NUT_SCALE	1e4
 #define NUT_SERIES	106
-#define NUT_MAXMUL	4
 #define SECPERCIRC	(3600.*360.)
 
 /* Delaunay arguments, in arc seconds; they differ slightly from ELP82B */
@@ -267,24 +266,31 @@ static short ampconst[NUT_SERIES][2] = {
     {1,0}
 };
 
+/* the series above repacked, once as the library is loaded so no caller
+ * can race to do it, into one row per term so it may be evaluated for many
+ * epochs at once by nut_block():
+ * nutmul[i] are the Delaunay multipliers of term i, nutamp[i] its amplitudes
+ * {dPSI, T/10 in dPSI, dEPS, T/10 in dEPS}, both as doubles.
+ */
+static double nutmul[NUT_SERIES][5];
+static double nutamp[NUT_SERIES][4];
+
+#define	NUT_BLK		32	/* epochs per pass of nut_block() */
+#define	NUT_IPSPAN	1.0	/* max span for quadratic interpolation, days */
+
+static void nut_pack P_((void)) __attribute__ ((constructor));
+static void nut_block P_((int n, double mjd[], double deps[], double dpsi[]));
+
 /* given the modified JD, mjd, find the nutation in obliquity, *deps, and
  * the nutation in longitude, *dpsi, each in radians.
  */
 void
 nutation (mjd, deps, dpsi)
 double mjd;
-double *deps;	/* on input:  precision parameter in arc seconds */
+double *deps;
 double *dpsi;
 {
 	static double lastmjd = -10000, lastdeps, lastdpsi;
-	double T, T2, T3, T10;			/* jul cent since J2000 */
-	double prec;				/* series precis in arc sec */
-	int i, isecul;				/* index in term table */
-	static double delcache[5][2*NUT_MAXMUL+1];
-			/* cache for multiples of delaunay args
-			 * [M',M,F,D,Om][-min*x, .. , 0, .., max*x]
-			 * make static to have unfilled fields cleared on init
-			 */
 
 	if (mjd == lastmjd) {
 	    *deps = lastdeps;
@@ -292,78 +298,67 @@ double *dpsi;
 	    return;
 	}
 
-	prec = 0.0;
-
-#if 0	/* this is if deps should contain a precision value */
-	prec =* deps;
-	if (prec < 0.0 || prec > 1.0)	/* accept only sane value */
-		prec = 1.0;
-#endif
-
-	/* augment for abundance of small terms */
-	prec *= NUT_SCALE/10;
-
-	T = (mjd - J2000)/36525.;
-	T2 = T * T;
-	T3 = T2 * T;
-	T10 = T/10.;
+	nut_block (1, &mjd, &lastdeps, &lastdpsi);
 
-	/* calculate delaunay args and place in cache */
-	for (i = 0; i < 5; ++i) {
-	    double x;
-	    short j;
-
-	    x = delaunay[i][0] +
-		delaunay[i][1] * T +
-		delaunay[i][2] * T2 +
-		delaunay[i][3] * T3;
-
-	    /* convert to radians */
-	    x /= SECPERCIRC;
-	    x -= floor(x);
-	    x *= 2.*PI;
+	lastmjd = mjd;
+	*deps = lastdeps;
+	*dpsi = lastdpsi;
+}
 
-	    /* fill cache table */
-	    for (j = 0; j <= 2*NUT_MAXMUL; ++j)
-		delcache[i][j] = (j - NUT_MAXMUL) * x;
-	}
+/* find the nutation in obliquity, deps[i], and in longitude, dpsi[i], each in
+ * radians, for each of the n modified JDs mjd[i]. the results are the same
+ * as from calling nutation() for each one.
+ * if fast and all the epochs lie within NUT_IPSPAN days of each other the
+ * full series is only evaluated at the ends and middle of the span and the
+ * rest are interpolated from a quadratic through those; the error is then
+ * at most about .0004" over a whole day, and less over shorter spans.
+ */
+void
+nutation_n (n, mjd, deps, dpsi, fast)
+int n;
+double mjd[];
+double deps[], dpsi[];
+int fast;
+{
+	double t[3], e[3], p[3];
+	double m0, m1, h;
+	int i;
 
-	/* find dpsi and deps */
-	lastdpsi = lastdeps = 0.;
-	for (i = isecul = 0; i < NUT_SERIES ; ++i) {
-	    double arg = 0., ampsin, ampcos;
-	    short j;
+	if (n <= 0)
+	    return;
 
-	    if (ampconst[i][0] || ampconst[i][1]) {
-		/* take non-secular terms from simple array */
-		ampsin = ampconst[i][0];
-		ampcos = ampconst[i][1];
-	    } else {
-		/* secular terms from different array */
-		ampsin = ampsecul[isecul][1] + ampsecul[isecul][2] * T10;
-		ampcos = ampsecul[isecul][3] + ampsecul[isecul][4] * T10;
-		++isecul;
+	if (fast && n > 3) {
+	    m0 = m1 = mjd[0];
+	    for (i = 1; i < n; i++) {
+		if (mjd[i] < m0) m0 = mjd[i];
+		if (mjd[i] > m1) m1 = mjd[i];
+	    }
+	    if (m1 - m0 <= NUT_IPSPAN) {
+		h = (m1 - m0)/2;
+		if (h <= 0) {
+		    nut_block (1, mjd, e, p);
+		    for (i = 0; i < n; i++) {
+			deps[i] = e[0];
+			dpsi[i] = p[0];
+		    }
+		    return;
+		}
+		t[0] = m0;
+		t[1] = m0 + h;
+		t[2] = m1;
+		nut_block (3, t, e, p);
+		for (i = 0; i < n; i++) {
+		    double x = (mjd[i] - t[1])/h;	/* -1 .. 1 */
+
+		    deps[i] = e[1] + x*(e[2]-e[0])/2 + x*x*(e[2]-2*e[1]+e[0])/2;
+		    dpsi[i] = p[1] + x*(p[2]-p[0])/2 + x*x*(p[2]-2*p[1]+p[0])/2;
+		}
+		return;
 	    }
-
-	    for (j = 0; j < 5; ++j)
-		arg += delcache[j][NUT_MAXMUL + multarg[i][j]];
-
-	    if (fabs(ampsin) >= prec)
-		lastdpsi += ampsin * sin(arg);
-
-	    if (fabs(ampcos) >= prec)
-		lastdeps += ampcos * cos(arg);
-
 	}
 
-	/* convert to radians.
-	 */
-	lastdpsi = degrad(lastdpsi/3600./NUT_SCALE);
-	lastdeps = degrad(lastdeps/3600./NUT_SCALE);
-
-	lastmjd = mjd;
-	*deps = lastdeps;
-	*dpsi = lastdpsi;
+	for (i = 0; i < n; i += NUT_BLK)
+	    nut_block (n - i < NUT_BLK ? n - i : NUT_BLK, mjd+i, deps+i,dpsi+i);
 }
 
 /* given the modified JD, mjd, correct, IN PLACE, the right ascension *ra
@@ -437,3 +432,86 @@ double mjd, *ra, *dec;
 	cartsph(x, y, z, ra, dec, &zold);	/* radius should be 1.0 */
 	if (*ra < 0.) *ra += 2.*PI;		/* make positive for display */
 }
+
+/* build nutmul[] and nutamp[] from the tables above.
+ */
+static void
+nut_pack()
+{
+	int i, j, isecul;
+
+	for (i = isecul = 0; i < NUT_SERIES; ++i) {
+	    for (j = 0; j < 5; ++j)
+		nutmul[i][j] = multarg[i][j];
+
+	    if (ampconst[i][0] || ampconst[i][1]) {
+		nutamp[i][0] = ampconst[i][0];
+		nutamp[i][1] = 0.;
+		nutamp[i][2] = ampconst[i][1];
+		nutamp[i][3] = 0.;
+	    } else {
+		nutamp[i][0] = ampsecul[isecul][1];
+		nutamp[i][1] = ampsecul[isecul][2];
+		nutamp[i][2] = ampsecul[isecul][3];
+		nutamp[i][3] = ampsecul[isecul][4];
+		++isecul;
+	    }
+	}
+}
+
+/* evaluate the full series for n <= NUT_BLK epochs.
+ * the loop over terms is outermost so each term's multipliers and
+ * amplitudes are fetched once and the inner loop runs straight down the
+ * epochs.
+ */
+static void
+nut_block (n, mjd, deps, dpsi)
+int n;
+double mjd[];
+double deps[], dpsi[];
+{
+	double D[5][NUT_BLK], T10[NUT_BLK];
+	double spsi[NUT_BLK], seps[NUT_BLK];
+	int i, k;
+
+	for (k = 0; k < n; k++) {
+	    double T = (mjd[k] - J2000)/36525.;
+	    double T2 = T * T;
+	    double T3 = T2 * T;
+
+	    for (i = 0; i < 5; ++i) {
+		double x;
+
+		x = delaunay[i][0] +
+		    delaunay[i][1] * T +
+		    delaunay[i][2] * T2 +
+		    delaunay[i][3] * T3;
+		x /= SECPERCIRC;
+		x -= floor(x);
+		D[i][k] = x * 2.*PI;
+	    }
+	    T10[k] = T/10.;
+	    spsi[k] = seps[k] = 0.;
+	}
+
+	for (i = 0; i < NUT_SERIES; ++i) {
+	    double *m = nutmul[i], *a = nutamp[i];
+
+	    for (k = 0; k < n; k++) {
+		double arg = 0.;
+
+		arg += m[0]*D[0][k];
+		arg += m[1]*D[1][k];
+		arg += m[2]*D[2][k];
+		arg += m[3]*D[3][k];
+		arg += m[4]*D[4][k];
+		spsi[k] += (a[0] + a[1]*T10[k]) * sin(arg);
+		seps[k] += (a[2] + a[3]*T10[k]) * cos(arg);
+	    }
+	}
+
+	for (k = 0; k < n; k++) {
+	    dpsi[k] = degrad(spsi[k]/3600./NUT_SCALE);
+	    deps[k] = degrad(seps[k]/3600./NUT_SCALE);
+	}
+}
@@ -0,0 +1,178 @@
+/* time scale tables: DeltaT, GMST and the equation of the equinoxes
+ * precomputed once per day so the hot reduction path need not run the
+ * Besselian interpolation in deltat() or the nutation series again for every
+ * new mjd.
+ *
+ * ts_init() fills a table of ndays days. each day holds GMST at 0h UT plus
+ * quadratics in the fraction of the day for DeltaT and for the equation of
+ * the equinoxes, fit through the start, middle and end of that day. a lookup
+ * is then an index and two or three multiply-adds.
+ *
+ * the lookups only read the table so they may be used from any number of
+ * threads at once. ts_init() itself is not; call it before starting any
+ * threads that use the table. mjds outside the table fall back to the full
+ * computation, which is not thread safe either.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+
+typedef struct {
+    double gmst0;		/* GMST at 0h UT, hours */
+    double dt[3];		/* DeltaT, secs: dt0 + x*(dt1 + x*dt2) */
+    double eq[3];		/* eq of equinoxes, hours, likewise */
+} TSDay;
+
+static TSDay *tstab;		/* malloced table of tsndays days */
+static double tsbase;		/* mjd of 0h UT of tstab[0] */
+static int tsndays;		/* n entries in tstab */
+
+static void ts_eqeq P_((double mjd, double *eqp));
+static TSDay *ts_day P_((double mjd, double *xp));
+
+/* (re)build the tables for ndays days starting with the day containing mjd.
+ * return 0 if ok, else -1 if no memory, in which case any previous table
+ * stays in effect.
+ */
+int
+ts_init (mjd, ndays)
+double mjd;
+int ndays;
+{
+	TSDay *tp;
+	double d0;
+	int i;
+
+	if (ndays <= 0)
+	    return (-1);
+	tp = (TSDay *) malloc (ndays * sizeof(TSDay));
+	if (!tp)
+	    return (-1);
+
+	d0 = mjd_day (mjd);
+	for (i = 0; i < ndays; i++) {
+	    TSDay *dp = &tp[i];
+	    double d = d0 + i;
+	    double f0, fm, f1;
+
+	    utc_gst (d, 0.0, &dp->gmst0);
+
+	    f0 = deltat (d);
+	    fm = deltat (d + 0.5);
+	    f1 = deltat (d + 1.0);
+	    dp->dt[0] = f0;
+	    dp->dt[2] = 2*(f0 - 2*fm + f1);
+	    dp->dt[1] = f1 - f0 - dp->dt[2];
+
+	    ts_eqeq (d, &f0);
+	    ts_eqeq (d + 0.5, &fm);
+	    ts_eqeq (d + 1.0, &f1);
+	    dp->eq[0] = f0;
+	    dp->eq[2] = 2*(f0 - 2*fm + f1);
+	    dp->eq[1] = f1 - f0 - dp->eq[2];
+	}
+
+	if (tstab)
+	    free ((char *)tstab);
+	tstab = tp;
+	tsbase = d0;
+	tsndays = ndays;
+	return (0);
+}
+
+/* return ET - UT1 at mjd, in seconds; same as deltat().
+ */
+double
+ts_deltat (mjd)
+double mjd;
+{
+	TSDay *dp;
+	double x;
+
+	dp = ts_day (mjd, &x);
+	if (!dp)
+	    return (deltat (mjd));
+	return (dp->dt[0] + x*(dp->dt[1] + x*dp->dt[2]));
+}
+
+/* return greenwich mean sidereal time at mjd, in hours.
+ */
+double
+ts_gmst (mjd)
+double mjd;
+{
+	TSDay *dp;
+	double x, gst;
+
+	dp = ts_day (mjd, &x);
+	if (!dp)
+	    utc_gst (mjd_day(mjd), mjd_hr(mjd), &gst);
+	else {
+	    gst = dp->gmst0 + (24.0/SIDRATE)*x;
+	    range (&gst, 24.0);
+	}
+	return (gst);
+}
+
+/* return greenwich apparent sidereal time at mjd, in hours.
+ */
+double
+ts_gast (mjd)
+double mjd;
+{
+	TSDay *dp;
+	double x, gst, eq;
+
+	dp = ts_day (mjd, &x);
+	if (!dp) {
+	    utc_gst (mjd_day(mjd), mjd_hr(mjd), &gst);
+	    ts_eqeq (mjd, &eq);
+	} else {
+	    gst = dp->gmst0 + (24.0/SIDRATE)*x;
+	    eq = dp->eq[0] + x*(dp->eq[1] + x*dp->eq[2]);
+	}
+	gst += eq;
+	range (&gst, 24.0);
+	return (gst);
+}
+
+/* find the table entry for the day containing mjd and the fraction of that
+ * day, *xp. return NULL if mjd is not covered.
+ */
+static TSDay *
+ts_day (mjd, xp)
+double mjd;
+double *xp;
+{
+	double t;
+	int i;
+
+	if (!tstab)
+	    return (NULL);
+	t = mjd - tsbase;
+	if (t < 0)
+	    return (NULL);
+	i = (int)t;
+	if (i >= tsndays)
+	    return (NULL);
+	*xp = t - i;
+	return (&tstab[i]);
+}
+
+/* equation of the equinoxes at mjd, in hours, just as now_lst() adds it.
+ */
+static void
+ts_eqeq (mjd, eqp)
+double mjd;
+double *eqp;
+{
+	double eps, deps, dpsi;
+
+	obliquity (mjd, &eps);
+	nutation (mjd, &deps, &dpsi);
+	*eqp = radhr (dpsi*cos(eps+deps));
+}
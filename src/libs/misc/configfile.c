@@ -1,5 +1,13 @@
 /* manage a config file of name=value pairs.
  * see nextPair for a full description of syntax.
+ *
+ * each file is parsed once into a hash table of its pairs, keyed on the name
+ * without regard to case, and kept. it is parsed again only when a stat()
+ * shows it is no longer the same file, size or modification time, so asking
+ * for one entry at a time costs little more than asking for them all.
+ * cfgSnap() holds on to the pairs of a file as they are now, for comparing
+ * with how they are later; a file parsed again is only freed once no
+ * snapshot holds it.
  */
 
 #include <stdio.h>
@@ -9,11 +17,42 @@
 #include <errno.h>
 #include <time.h>
 #include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "configfile.h"
 #include "strops.h"
 #include "telenv.h"
 
+#define	CFGNHASH	128	/* hash buckets per file, a power of 2 */
+
+/* one name=value pair, the strings follow in the same malloc */
+typedef struct CfgPair {
+    struct CfgPair *next;	/* next in same bucket */
+    char *name;			/* name, as in file */
+    char *value;		/* its last value in the file */
+} CfgPair;
+
+/* one file we have parsed */
+typedef struct CfgFile {
+    struct CfgFile *next;	/* next file in cfgfiles */
+    char *path;			/* as opened */
+    dev_t dev;			/* which file it was .. */
+    ino_t ino;
+    off_t size;			/* .. and how it was */
+    struct timespec mtime;
+    int nref;			/* 1 while in cfgfiles, +1 per cfgSnap() */
+    CfgPair *hash[CFGNHASH];	/* pairs by cfgHash() of name */
+} CfgFile;
+
+static CfgFile *cfgfiles;	/* all files parsed so far */
+
+static CfgFile *cfgCache (char *fn);
+static CfgPair *cfgPair (CfgFile *cfp, char *name);
+static void cfgDrop (CfgFile *cfp);
+static void cfgFree (CfgFile *cfp);
+static unsigned cfgHash (char *name);
+
 /* read the given list of params from the given config file.
  * return number of entries found, or -1 if can not even open file.
  * if trace each entry found is traced to stderr as "filename: name = value".
@@ -24,53 +63,41 @@ readCfgFile (int trace, char *cfn, CfgEntry cea[], int ncea)
 {
 	char *bn = basenm(cfn);
 	CfgEntry *cep, *lcea = cea+ncea;
-	char name[256];
 	char valu[1024];
+	CfgFile *cfp;
 	int nfound;
-	FILE *fp;
 
-	/* open file */
-	fp = telfopen (cfn, "r");
-	if (!fp)
+	/* get file's pairs */
+	cfp = cfgCache (cfn);
+	if (!cfp)
 	    return (-1);
 
-	/* reset found flags */
-	for (cep = cea; cep < lcea; cep++)
-	    cep->found = 0;
-
-	/* for each pair in file
-	 *   fill if in cea list
-	 */
+	/* fill each in cea list if in file */
 	nfound = 0;
-	while (!nextPair (fp, cfn, name, sizeof(name), valu, sizeof(valu))) {
-	    for (cep = cea; cep < lcea; cep++) {
-		if (!strcasecmp (cep->name, name)) {
-		    switch (cep->type) {
-		    case CFG_INT:
-			*((int *)cep->valp) = atoi(valu);
-			break;
-		    case CFG_DBL:
-			*((double *)cep->valp) = atof(valu);
-			break;
-		    case CFG_STR:
-			(void) strncpy ((char *)(cep->valp), valu, cep->slen);
-			break;
-		    default:
-			fprintf (stderr, "%s: bad type: %d\n", bn, cep->type);
-			exit(1);
-		    }
-		    if (!cep->found) {
-			cep->found = 1;
-			nfound++;	/* just count once */
-		    }
-		    break;
-		}
+	for (cep = cea; cep < lcea; cep++) {
+	    CfgPair *pp = cfgPair (cfp, cep->name);
+
+	    cep->found = 0;
+	    if (!pp)
+		continue;
+	    switch (cep->type) {
+	    case CFG_INT:
+		*((int *)cep->valp) = atoi(pp->value);
+		break;
+	    case CFG_DBL:
+		*((double *)cep->valp) = atof(pp->value);
+		break;
+	    case CFG_STR:
+		(void) strncpy ((char *)(cep->valp), pp->value, cep->slen);
+		break;
+	    default:
+		fprintf (stderr, "%s: bad type: %d\n", bn, cep->type);
+		exit(1);
 	    }
+	    cep->found = 1;
+	    nfound++;
 	}
 
-	/* done with file */
-	fclose (fp);
-
 	/* print the final list if desired */
 	if (trace) {
 	    daemonLog ("Reading %s:", bn);
@@ -115,6 +142,111 @@ read1CfgEntry (int trace, char *fn, char *name, CfgType t, void *vp, int slen)
 	return (readCfgFile (trace, fn, &e, 1) == 1 ? 0 : -1);
 }
 
+/* return the value of name in config file fn, else NULL if no such file or
+ * name. N.B. it is only good until the file is next read or forgotten.
+ */
+char *
+cfgValue (char *fn, char *name)
+{
+	CfgFile *cfp = cfgCache (fn);
+	CfgPair *pp;
+
+	if (!cfp)
+	    return (NULL);
+	pp = cfgPair (cfp, name);
+	return (pp ? pp->value : NULL);
+}
+
+/* return the int value of name in config file fn, else def */
+int
+cfgInt (char *fn, char *name, int def)
+{
+	char *vp = cfgValue (fn, name);
+
+	return (vp ? atoi(vp) : def);
+}
+
+/* return the double value of name in config file fn, else def */
+double
+cfgDbl (char *fn, char *name, double def)
+{
+	char *vp = cfgValue (fn, name);
+
+	return (vp ? atof(vp) : def);
+}
+
+/* forget what we know of config file fn, or of all files if fn is NULL,
+ * so it is read again next time whatever stat() says. since fn may have been
+ * found in $TELHOME, any file of the same base name is forgotten too.
+ */
+void
+cfgForget (char *fn)
+{
+	CfgFile **cfpp = &cfgfiles;
+
+	while (*cfpp) {
+	    CfgFile *cfp = *cfpp;
+	    if (!fn || !strcmp (cfp->path, fn) || !strcmp (basenm(cfp->path),
+								basenm(fn))) {
+		*cfpp = cfp->next;
+		cfgDrop (cfp);
+	    } else
+		cfpp = &cfp->next;
+	}
+}
+
+/* return a snapshot of the pairs in config file fn as they are now, else
+ * NULL with errno set if can not even open file. it stays the same whatever
+ * becomes of fn until given to cfgSnapFree().
+ */
+CfgSnap *
+cfgSnap (char *fn)
+{
+	CfgFile *cfp = cfgCache (fn);
+
+	if (cfp)
+	    cfp->nref++;
+	return (cfp);
+}
+
+/* done with a snapshot from cfgSnap(), which may be NULL */
+void
+cfgSnapFree (CfgSnap *sp)
+{
+	if (sp)
+	    cfgDrop (sp);
+}
+
+/* return the value of name in snapshot sp, else NULL */
+char *
+cfgSnapValue (CfgSnap *sp, char *name)
+{
+	CfgPair *pp = cfgPair (sp, name);
+
+	return (pp ? pp->value : NULL);
+}
+
+/* call (*fp)(name, value, arg) for each pair in snapshot sp, in no order,
+ * until it returns other than 0.
+ * return that, else 0.
+ */
+int
+cfgSnapEach (CfgSnap *sp, int (*fp)(char *name, char *value, void *arg),
+    void *arg)
+{
+	int i;
+
+	for (i = 0; i < CFGNHASH; i++) {
+	    CfgPair *pp;
+	    for (pp = sp->hash[i]; pp; pp = pp->next) {
+		int r = (*fp) (pp->name, pp->value, arg);
+		if (r)
+		    return (r);
+	    }
+	}
+	return (0);
+}
+
 /* handy utility to print an error message describing what went wrong with
  * a call to readCfgFile().
  * fn is the offending file name.
@@ -176,6 +308,7 @@ writeCfgFile (char *fn, char *name, char *value, char *cmt)
 	if (!fp)
 	    return (-1);
 
+	cfgForget (fn);
 	fprintf (fp, "%-15s %-15s ! ", name, value);
 	if (cmt) {
 	    fprintf (fp, "%s\n", cmt);
@@ -188,6 +321,141 @@ writeCfgFile (char *fn, char *name, char *value, char *cmt)
 	return (0);
 }
 
+/* find the CfgFile for fn, opened as telfopen() would, parsing it if it is
+ * new to us or has changed since we did.
+ * return it, else NULL with errno set if can not even open file.
+ */
+static CfgFile *
+cfgCache (char *fn)
+{
+	char path[1024], name[256], valu[1024];
+	CfgFile *cfp;
+	struct stat st;
+	FILE *fp;
+
+	/* find the file */
+	if (stat (fn, &st) == 0)
+	    (void) strcpy (path, fn);
+	else if (fn[0] != '/') {
+	    telfixpath (path, fn);
+	    if (stat (path, &st) < 0)
+		return (NULL);
+	} else
+	    return (NULL);
+
+	/* use what we have if it is still the same */
+	for (cfp = cfgfiles; cfp; cfp = cfp->next)
+	    if (!strcmp (cfp->path, path))
+		break;
+	if (cfp && cfp->dev == st.st_dev && cfp->ino == st.st_ino
+		&& cfp->size == st.st_size
+		&& cfp->mtime.tv_sec == st.st_mtim.tv_sec
+		&& cfp->mtime.tv_nsec == st.st_mtim.tv_nsec)
+	    return (cfp);
+
+	fp = fopen (path, "r");
+	if (!fp)
+	    return (NULL);
+
+	/* start over */
+	if (cfp) {
+	    CfgFile **cfpp;
+	    for (cfpp = &cfgfiles; *cfpp != cfp; cfpp = &(*cfpp)->next)
+		continue;
+	    *cfpp = cfp->next;
+	    cfgDrop (cfp);
+	}
+	cfp = (CfgFile *) calloc (1, sizeof(CfgFile) + strlen(path) + 1);
+	if (!cfp) {
+	    fclose (fp);
+	    errno = ENOMEM;
+	    return (NULL);
+	}
+	cfp->path = strcpy ((char *)(cfp+1), path);
+	cfp->dev = st.st_dev;
+	cfp->ino = st.st_ino;
+	cfp->size = st.st_size;
+	cfp->mtime = st.st_mtim;
+	cfp->nref = 1;
+
+	/* add each pair, replacing any with the same name */
+	while (!nextPair (fp, fn, name, sizeof(name), valu, sizeof(valu))) {
+	    int nl = strlen(name), vl = strlen(valu);
+	    unsigned h = cfgHash (name);
+	    CfgPair *pp, **ppp;
+
+	    if (!strcmp (name, "/"))
+		continue;
+	    for (ppp = &cfp->hash[h]; *ppp; ppp = &(*ppp)->next)
+		if (!strcasecmp ((*ppp)->name, name))
+		    break;
+	    pp = (CfgPair *) malloc (sizeof(CfgPair) + nl + 1 + vl + 1);
+	    if (!pp)
+		break;
+	    pp->name = strcpy ((char *)(pp+1), name);
+	    pp->value = strcpy (pp->name + nl + 1, valu);
+	    if (*ppp) {
+		pp->next = (*ppp)->next;
+		free ((void *)*ppp);
+	    } else
+		pp->next = NULL;
+	    *ppp = pp;
+	}
+	fclose (fp);
+
+	cfp->next = cfgfiles;
+	cfgfiles = cfp;
+	return (cfp);
+}
+
+/* return the pair in cfp for name, else NULL */
+static CfgPair *
+cfgPair (CfgFile *cfp, char *name)
+{
+	CfgPair *pp;
+
+	for (pp = cfp->hash[cfgHash(name)]; pp; pp = pp->next)
+	    if (!strcasecmp (pp->name, name))
+		return (pp);
+	return (NULL);
+}
+
+/* let go of cfp, and free it if no one else still holds it */
+static void
+cfgDrop (CfgFile *cfp)
+{
+	if (--cfp->nref <= 0)
+	    cfgFree (cfp);
+}
+
+/* free cfp and all its pairs */
+static void
+cfgFree (CfgFile *cfp)
+{
+	int i;
+
+	for (i = 0; i < CFGNHASH; i++) {
+	    CfgPair *pp = cfp->hash[i];
+	    while (pp) {
+		CfgPair *next = pp->next;
+		free ((void *)pp);
+		pp = next;
+	    }
+	}
+	free ((void *)cfp);
+}
+
+/* return the bucket for name, without regard to case */
+static unsigned
+cfgHash (char *name)
+{
+	unsigned h = 2166136261u;
+
+	while (*name)
+	    h = (h ^ tolower((unsigned char)*name++)) * 16777619u;
+	return (h & (CFGNHASH-1));
+}
+
 /* read the next pair of a name=value pair from a file.
  * the '=' is optional.
  * allow surrounding white space everywhere (which includes '\r' for DOS sake).
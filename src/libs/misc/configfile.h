@@ -14,11 +14,23 @@ typedef struct {
 
 typedef	void (*CfgPrFp)();
 
+/* the pairs of a file as they were, from cfgSnap() */
+typedef struct CfgFile CfgSnap;
+
 extern int readCfgFile (int trace, char *fn, CfgEntry cea[], int ncea);
 extern int read1CfgEntry (int trace, char *fn, char *name, CfgType t,
     void *vp, int slen);
 extern void cfgFileError (char *fn,int rv, CfgPrFp fp, CfgEntry ca[], int nca);
 extern int cfgFound (char *name, CfgEntry cea[], int ncea);
+extern char *cfgValue (char *fn, char *name);
+extern int cfgInt (char *fn, char *name, int def);
+extern double cfgDbl (char *fn, char *name, double def);
+extern void cfgForget (char *fn);
+extern CfgSnap *cfgSnap (char *fn);
+extern void cfgSnapFree (CfgSnap *sp);
+extern char *cfgSnapValue (CfgSnap *sp, char *name);
+extern int cfgSnapEach (CfgSnap *sp,
+    int (*fp)(char *name, char *value, void *arg), void *arg);
 extern int writeCfgFile (char *fn, char *name, char *value, char *cmt);
 
 extern int nextPair (FILE *fp, char fn[], char name[], int maxname,
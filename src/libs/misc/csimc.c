@@ -12,7 +12,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/time.h>
+#include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netdb.h>
 
@@ -20,6 +23,11 @@
 
 /*** low-level server connections, not for applications ***********************/
 
+static int nounix;		/* set to never use the local Unix socket */
+
+static int csimcd_uaddr (int port, struct sockaddr_un *sap);
+static int islocal (char *host);
+
 /* create the public csimcd server endpoint on this host with the given port.
  * return fd on which to accept() for new connections, else -1.
  */
@@ -52,15 +60,40 @@ csimcd_slisten (int port)
 	return (serv_fd);
 }
 
+/* create the local csimcd server endpoint for the given port, a Unix-domain
+ * socket in the abstract namespace so it vanishes when we do.
+ * clients on this host use it instead of TCP/IP loopback.
+ * return fd on which to accept() for new connections, else -1.
+ */
+int
+csimcd_ulisten (int port)
+{
+	struct sockaddr_un serv_socket;
+	int serv_fd, len;
+
+	if ((serv_fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return (-1);
+
+	len = csimcd_uaddr (port, &serv_socket);
+	if (bind(serv_fd, (struct sockaddr *)&serv_socket, len) < 0
+						|| listen (serv_fd, 5) < 0) {
+	    close (serv_fd);
+	    return (-1);
+	}
+
+	return (serv_fd);
+}
+
 /* server waits for a client connection to arrive.
- * serv_fd came from csimcd_slisten().
+ * serv_fd came from csimcd_slisten() or csimcd_ulisten().
  * return private 2-way fd, else -1.
  */
 int
 csimcd_saccept (int serv_fd)
 {
-	struct sockaddr_in cli_socket;
-	int cli_len, cli_fd;
+	struct sockaddr_storage cli_socket;
+	socklen_t cli_len;
+	int cli_fd;
 
 	/* get a private connection to new client */
 	cli_len = sizeof(cli_socket);
@@ -73,6 +106,7 @@ csimcd_saccept (int serv_fd)
 
 /* connect to the csimcd server running on the given host and port.
  * if !host assume this host, !port CSIMCPORT.
+ * if host is this host try its Unix socket first, then TCP/IP.
  * returns a private 2-way fd, else -1.
  */
 int
@@ -88,6 +122,18 @@ csimcd_clconn (char *host, int port)
 	if (!port)
 	    port = CSIMCPORT;
 
+	/* local csimcd listens on a Unix socket too, unless it is too old */
+	if (!nounix && islocal (host)) {
+	    struct sockaddr_un un_socket;
+
+	    if ((cli_fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return (-1);
+	    len = csimcd_uaddr (port, &un_socket);
+	    if (connect (cli_fd, (struct sockaddr *)&un_socket, len) == 0)
+		return (cli_fd);
+	    close (cli_fd);
+	}
+
 	/* get host name running server */
 	if (!(hp = gethostbyname(host)))
 	    return (-1);
@@ -112,6 +158,36 @@ csimcd_clconn (char *host, int port)
 	return (cli_fd);
 }
 
+/* set whether csimcd_clconn() may use the local Unix socket, default yes.
+ * handy to compare with TCP/IP.
+ */
+void
+csimcd_unix (int on)
+{
+	nounix = !on;
+}
+
+/* fill *sap with the address of the local csimcd for port.
+ * return the length to use with bind() or connect().
+ */
+static int
+csimcd_uaddr (int port, struct sockaddr_un *sap)
+{
+	int n;
+
+	memset (sap, 0, sizeof(*sap));
+	sap->sun_family = AF_UNIX;
+	n = sprintf (sap->sun_path+1, "csimcd.%d", port);	/* [0] is 0 */
+	return (offsetof (struct sockaddr_un, sun_path) + 1 + n);
+}
+
+/* return 1 if host names this host, else 0 */
+static int
+islocal (char *host)
+{
+	return (!strcmp (host, "127.0.0.1") || !strcmp (host, "localhost"));
+}
+
 /*** hi-level API connections *********************************************/
 
 /* table to look up host and network addresses from file descriptor.
@@ -173,6 +249,13 @@ fdisShell (int fd)
 	return (fp && fp->why == FOR_SHELL);
 }
 
+static int
+fdisVars (int fd)
+{
+	FDInfo *fp = fdiFind(fd);
+	return (fp && fp->why == FOR_VARS);
+}
+
 static int
 common_close (int fd)
 {
@@ -235,6 +318,17 @@ csi_sopen (char *host, int port, int addr, int baud)
 	return (common_open (host, port, addr, FOR_SERIAL, baud/300));
 }
 
+/* build a connection to csimcd for the given TCP/IP host and port for
+ * reading and writing node variables in binary with csi_getvars() and
+ * csi_setvars(). the node must support PT_GETVAR and PT_SETVAR.
+ * return fd or -1.
+ */
+int
+csi_vopen (char *host, int port, int addr)
+{
+	return (common_open (host, port, addr, FOR_VARS, 0));
+}
+
 /* build a connection to csimcd for the given host/port for booting.
  * return fd or -1.
  */
@@ -387,3 +481,177 @@ csi_rix (int fd, char *fmt, ...)
 
 	return (strtol (buf, NULL, 0));
 }
+
+/* read exactly n bytes from fd into buf, waiting at most ms for each part.
+ * return 0 if ok, else -1.
+ */
+static int
+readN (int fd, Byte *buf, int n, int ms)
+{
+	int s;
+
+	while (n > 0) {
+	    struct timeval tv;
+	    fd_set r;
+
+	    FD_ZERO (&r);
+	    FD_SET (fd, &r);
+	    tv.tv_sec = ms/1000;
+	    tv.tv_usec = (ms%1000)*1000;
+	    s = select (fd+1, &r, NULL, NULL, &tv);
+	    if (s < 0 && errno == EINTR)
+		continue;
+	    if (s <= 0)
+		return (-1);
+	    s = read (fd, buf, n);
+	    if (s < 0 && errno == EINTR)
+		continue;
+	    if (s <= 0)
+		return (-1);
+	    buf += s;
+	    n -= s;
+	}
+	return (0);
+}
+
+/* put b in bp[*ip], escaping PSYNC and PESC as in all packet Data, and
+ * update *ip.
+ */
+static void
+varEsc (Byte b, Byte *bp, int *ip)
+{
+	switch (b) {
+	case PSYNC:
+	    bp[(*ip)++] = PESC;
+	    bp[(*ip)++] = PESYNC;
+	    break;
+	case PESC:
+	    bp[(*ip)++] = PESC;
+	    bp[(*ip)++] = PEESC;
+	    break;
+	default:
+	    bp[(*ip)++] = b;
+	    break;
+	}
+}
+
+/* undo varEsc() on the n bytes of bp[], in place.
+ * return the bytes left, or -1 if bp[] is not escaped properly.
+ */
+static int
+varUnesc (Byte *bp, int n)
+{
+	int i, j;
+
+	for (i = j = 0; i < n; i++) {
+	    if (bp[i] == PSYNC)
+		return (-1);
+	    if (bp[i] != PESC)
+		bp[j++] = bp[i];
+	    else if (++i < n && bp[i] == PESYNC)
+		bp[j++] = PSYNC;
+	    else if (i < n && bp[i] == PEESC)
+		bp[j++] = PESC;
+	    else
+		return (-1);
+	}
+	return (j);
+}
+
+/* send one FOR_VARS request of type t with data[n], escaping it, and read
+ * the node's reply into data[], unescaped, expecting nr bytes.
+ * return 0 if ok, else -1, including if no reply within PV_WAIT ms.
+ * N.B. after -1 the connection is out of step and should be closed.
+ */
+static int
+varXfer (int fd, PktType t, Byte data[], int n, int nr)
+{
+	Byte req[2+2*PMXDAT];
+	Byte count;
+	int i, m;
+
+	if (!fdisVars(fd))
+	    return (-1);
+
+	for (i = m = 0; i < n; i++)
+	    varEsc (data[i], req+2, &m);
+	if (m > PMXDAT)
+	    return (-1);
+	req[0] = t;
+	req[1] = m;
+	if (write (fd, req, m+2) < 0)
+	    return (-1);
+
+	if (readN (fd, &count, 1, PV_WAIT) < 0 || count > PMXDAT
+				    || readN (fd, req, count, PV_WAIT) < 0)
+	    return (-1);
+	if (varUnesc (req, count) != nr)
+	    return (-1);
+	memcpy (data, req, nr);
+	return (0);
+}
+
+/* read the n node variables refs[] on fd, from csi_vopen(), into vals[],
+ * all in one packet.
+ * return 0 if ok, else -1.
+ */
+int
+csi_getvars (int fd, int n, int refs[], int vals[])
+{
+	Byte data[PMXDAT];
+	int i;
+
+	if (n < 1 || n > PV_MAXN)
+	    return (-1);
+	for (i = 0; i < n; i++)
+	    data[i] = refs[i];
+	if (varXfer (fd, PT_GETVAR, data, n, n*PV_VALSZ) < 0)
+	    return (-1);
+	for (i = 0; i < n; i++) {
+	    Byte *bp = &data[i*PV_VALSZ];
+	    vals[i] = (int)((unsigned)bp[0]<<24 | bp[1]<<16 | bp[2]<<8 | bp[3]);
+	}
+	return (0);
+}
+
+/* set the n node variables refs[] on fd, from csi_vopen(), to vals[], all in
+ * one packet.
+ * return 0 if ok, else -1.
+ */
+int
+csi_setvars (int fd, int n, int refs[], int vals[])
+{
+	Byte data[PMXDAT];
+	int i;
+
+	if (n < 1 || n > PV_MAXN)
+	    return (-1);
+	for (i = 0; i < n; i++) {
+	    Byte *bp = &data[i*(1+PV_VALSZ)];
+	    unsigned v = vals[i];
+	    bp[0] = refs[i];
+	    bp[1] = v >> 24;
+	    bp[2] = v >> 16;
+	    bp[3] = v >> 8;
+	    bp[4] = v;
+	}
+	return (varXfer (fd, PT_SETVAR, data, n*(1+PV_VALSZ), 0));
+}
+
+/* read one node variable ref on fd, from csi_vopen(), into *vp.
+ * return 0 if ok, else -1.
+ */
+int
+csi_getvar (int fd, int ref, int *vp)
+{
+	return (csi_getvars (fd, 1, &ref, vp));
+}
+
+/* set one node variable ref on fd, from csi_vopen(), to v.
+ * return 0 if ok, else -1.
+ */
+int
+csi_setvar (int fd, int ref, int v)
+{
+	return (csi_setvars (fd, 1, &ref, &v));
+}
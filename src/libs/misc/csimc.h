@@ -52,6 +52,37 @@ typedef enum {
     PT_SERSETUP,		/* Data is baud rate */
 } PktType;			/* type of packets */
 
+/* node variables, by the one-byte ref used in PT_GETVAR and PT_SETVAR.
+ *
+ * this is a wire contract with the node firmware: each ref below must name
+ * the same variable in the firmware's built-in table, so refs are never
+ * renumbered or reused, only added at the end. the layouts are:
+ *   PT_GETVAR Data	ref[0] ref[1] .. ref[n-1]
+ *   its ACK Data	val[0] val[1] .. val[n-1], in the order asked
+ *   PT_SETVAR Data	ref[0] val[0] ref[1] val[1] .. ref[n-1] val[n-1]
+ *   its ACK Data	empty
+ * each val is a 4-byte big-endian two's complement int. as in all Data, each
+ * PSYNC byte of a ref or val is sent as PESC PESYNC and each PESC as PESC
+ * PEESC, so Count is of the escaped bytes and varies with the values: up to
+ * twice the bytes above. a node that does not know PT_GETVAR or a ref may
+ * ACK with the wrong count, or not at all, so clients give up after PV_WAIT
+ * ms.
+ */
+typedef enum {
+    CV_CLOCK = 0,		/* ms clock */
+    CV_MPOS = 1,		/* motor position, steps */
+    CV_EPOS = 2,		/* encoder position, steps */
+    CV_MVEL = 3,		/* motor velocity, steps/sec */
+    CV_EVEL = 4,		/* encoder velocity, steps/sec */
+    CV_TIMEOUT = 5,		/* e/mtrack timeout, ms */
+    CV_TOFFSET = 6,		/* e/mtrack offset, steps */
+} CSIVar;
+
+#define	PV_VALSZ	4	/* bytes in one variable value */
+#define	PV_MAXN		(PMXDAT/(2*(1+PV_VALSZ))) /* max vars in one packet,
+						 * all escaped */
+#define	PV_WAIT		(2*ACKWT)	/* ms to wait for a GETVAR/SETVAR reply */
+
 #define	PT_MASK		0x0f	/* bits which hold PktType */
 #define	PSQ_MASK	0xf0	/* sequencing portion */
 #define	PSQ_SHIFT	4	/* amount to shift for sequencing portion */
@@ -84,9 +115,14 @@ typedef struct {
 
 /* codes used when opening a new connection to server */
 typedef enum {
-    FOR_SHELL, FOR_BOOT, FOR_REBOOT, FOR_SERIAL
+    FOR_SHELL, FOR_BOOT, FOR_REBOOT, FOR_SERIAL, FOR_VARS
 } OpenWhy;
 
+/* a FOR_VARS client sends a PT_GETVAR or PT_SETVAR type byte, a count byte
+ * then count bytes of packet Data, already escaped. it gets back a count byte
+ * then the Data of the node's ACK, still escaped.
+ */
+
 /* header for a boot image record */
 typedef struct {
     Byte type;			/* type of record .. see BT_ flags */
@@ -103,8 +139,10 @@ typedef struct {
 /* csimcd deamon API */
 #define	CSIMCPORT	7623	/* default csimcd TCP/IP port number */
 extern int csimcd_slisten (int port);
+extern int csimcd_ulisten (int port);
 extern int csimcd_saccept (int fd);
 extern int csimcd_clconn (char *host, int port);
+extern void csimcd_unix (int on);
 
 /* host client API */
 extern int csi_open (char *host, int port, int addr);
@@ -119,6 +157,11 @@ extern int csi_rix (int fd, char *fmt, ...);
 extern int csi_wr (int fd, char buf[], int buflen, char *fmt, ...);
 extern int csi_f2h (int fd);
 extern int csi_f2n (int fd);
+extern int csi_vopen (char *host, int port, int addr);
+extern int csi_getvars (int fd, int n, int refs[], int vals[]);
+extern int csi_setvars (int fd, int n, int refs[], int vals[]);
+extern int csi_getvar (int fd, int ref, int *vp);
+extern int csi_setvar (int fd, int ref, int v);
 
 #endif /* ! _HC12 */
 
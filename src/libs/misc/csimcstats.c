@@ -0,0 +1,45 @@
+/* attach to the csimcd statistics of csimcstats.h. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "csimcstats.h"
+
+/* attach to the stats of the csimcd on port.
+ * if create, make the segment fresh and zero it, as csimcd does at start.
+ * return pointer else NULL with errno set.
+ */
+CSIMCStats *
+cssOpen (int port, int create)
+{
+	int len = sizeof(CSIMCStats);
+	int shmid;
+	void *addr;
+
+	shmid = shmget (CSSKEY(port), len, create ? 0644 : 0);
+	if (shmid < 0 && create && errno == EINVAL) {
+	    /* one from a different version is in the way */
+	    shmid = shmget (CSSKEY(port), 0, 0);
+	    if (shmid >= 0)
+		(void) shmctl (shmid, IPC_RMID, NULL);
+	    shmid = -1;
+	    errno = ENOENT;
+	}
+	if (shmid < 0 && create && errno == ENOENT)
+	    shmid = shmget (CSSKEY(port), len, 0644|IPC_CREAT);
+	if (shmid < 0)
+	    return (NULL);
+
+	addr = shmat (shmid, NULL, create ? 0 : SHM_RDONLY);
+	if (addr == (void *)-1)
+	    return (NULL);
+
+	if (create)
+	    memset (addr, 0, len);
+	return ((CSIMCStats *)addr);
+}
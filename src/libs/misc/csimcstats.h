@@ -0,0 +1,60 @@
+/* counters and timings kept by csimcd, in shared memory for anyone to read.
+ *
+ * csimcd keeps these all the time, whatever its verbose level, in a SysV
+ * shared memory segment keyed by its port, so several csimcds each have
+ * their own. readers attach with cssOpen(port, 0) and just look; nothing is
+ * locked so a value may be caught part way through changing.
+ *
+ * times are gathered into the histograms of loghist.h.
+ */
+
+#ifndef CSIMCSTATS_H
+#define CSIMCSTATS_H
+
+#include "csimc.h"
+#include "loghist.h"
+
+#define	CSSKEY(port)	(0x43530000 | ((port) & 0xffff))  /* "CS" + port */
+#define	CSS_NOADDR	NNODES		/* node[] for broadcasts and unknown */
+
+/* what we know about one node and the LAN to it */
+typedef struct {
+    unsigned rxpkts;		/* good packets from node */
+    unsigned rxbytes;		/* bytes in them */
+    unsigned txpkts;		/* packets and tokens sent to node */
+    unsigned txbytes;		/* bytes in them */
+    unsigned resyncs;		/* packets abandoned part way */
+    unsigned hchkerrs;		/* bad header checksums */
+    unsigned dchkerrs;		/* bad data checksums */
+    unsigned retries;		/* packets sent again for want of an ACK */
+    unsigned reboots;		/* rebooted after MAXRTY retries */
+    unsigned toktimeouts;	/* token not back within TOKWT */
+    float rxpps, txpps;		/* packets per sec, over the last sec */
+    LogHist ack;		/* packet sent until its ACK */
+    LogHist tokhold;		/* token sent until it came back */
+} CSSNode;
+
+/* what we know about one host client */
+typedef struct {
+    int toaddr;			/* node it talks to, -1 if not connected */
+    int why;			/* OpenWhy */
+    unsigned pkts;		/* packets sent for it */
+    LogHist wait;		/* from when we last read clients until sent */
+} CSSHost;
+
+typedef struct {
+    int pid;			/* csimcd's process id */
+    unsigned lanreads;		/* read()s of the LAN */
+    unsigned lanwrites;		/* write()s to the LAN */
+    unsigned lanjunk;		/* bytes skipped looking for SYNC */
+    LogHist rotation;		/* from one turn of ours with the token to the
+				 * next
+				 */
+    CSSNode node[NNODES+1];	/* by node address, see CSS_NOADDR */
+    CSSHost host[NHOSTS];	/* by host address - NNODES */
+} CSIMCStats;
+
+/* csimcstats.c */
+extern CSIMCStats *cssOpen (int port, int create);
+
+#endif // CSIMCSTATS_H
@@ -0,0 +1,58 @@
+/* fill in and read the time histograms of loghist.h. */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "loghist.h"
+
+/* add secs to *hp */
+void
+lhAdd (LogHist *hp, double secs)
+{
+	int b;
+
+	hp->n++;
+	hp->sum += secs;
+	if (secs > hp->max)
+	    hp->max = secs;
+	(void) frexp (secs*1e6, &b);	/* secs is in [2^(b-1), 2^b) usecs */
+	if (b < 1)
+	    b = 1;
+	if (b > LH_NBUCKET)
+	    b = LH_NBUCKET;
+	hp->hist[b-1]++;
+}
+
+/* return the time by which q of the times in *hp were done, secs, or 0 if
+ * there are none. it's the top of the bucket so it errs long by up to a
+ * factor 2.
+ */
+double
+lhQuantile (LogHist *hp, double q)
+{
+	unsigned need = (unsigned) ceil (q*hp->n);
+	unsigned sum = 0;
+	int b;
+
+	if (!hp->n)
+	    return (0.0);
+	for (b = 0; b < LH_NBUCKET; b++) {
+	    sum += hp->hist[b];
+	    if (sum >= need)
+		break;
+	}
+	if (b == LH_NBUCKET)
+	    b = LH_NBUCKET - 1;
+	return (fmin (ldexp (1e-6, b+1), hp->max));
+}
+
+/* secs from some arbitrary but steady epoch */
+double
+lhNow (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec*1e-9);
+}
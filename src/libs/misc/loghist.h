@@ -0,0 +1,26 @@
+/* histograms of times in power-of-two buckets from 1 usec.
+ *
+ * adding a time is cheap enough to do all the time, and any quantile can
+ * then be had to within a factor 2. used by csimcd for its statistics and
+ * by telescoped to profile its control loop.
+ */
+
+#ifndef LOGHIST_H
+#define LOGHIST_H
+
+#define	LH_NBUCKET	32		/* buckets, [b] is < 2^(b+1) usecs */
+
+/* a histogram of times */
+typedef struct {
+    unsigned n;			/* times seen */
+    double sum;			/* total secs */
+    double max;			/* longest secs */
+    unsigned hist[LH_NBUCKET];	/* n times in each bucket */
+} LogHist;
+
+/* loghist.c */
+extern void lhAdd (LogHist *hp, double secs);
+extern double lhQuantile (LogHist *hp, double q);
+extern double lhNow (void);
+
+#endif // LOGHIST_H
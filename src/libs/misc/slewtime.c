@@ -0,0 +1,179 @@
+/* estimate how long the mount takes to slew between two places.
+ *
+ * each axis is taken to follow a trapezoidal (or, for short moves,
+ * triangular) velocity profile using its MotorInfo maxvel and maxacc, and
+ * both axes move at once so a slew takes as long as the slower axis.
+ * positions are found just as telescoped does it: tel_hadec2xy() then
+ * tel_ideal2realxy(), which picks the German equatorial flip side, then
+ * wrapped into the axis limits like chkLimits(). since an axis only ever
+ * moves directly between two places within its limits, the move distance in
+ * those encoder coords already accounts for flips and for going the long way
+ * round to stay clear of a limit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "configfile.h"
+#include "misc.h"
+#include "telstatshm.h"
+
+static char tdcfn[] = "archive/config/telescoped.cfg";
+static char hcfn[] = "archive/config/home.cfg";
+
+static int wrapLimits (MotorInfo *mip, double *vp);
+
+/* fill in *tap and the kinematics and limits of minfo[TEL_HM] and
+ * minfo[TEL_DM] from telescoped.cfg and home.cfg, as telescoped does.
+ * only the model and limits in home.cfg must be there: GERMEQ and ZENFLIP
+ * default to 0, and any of HMAXVEL, HMAXACC, DMAXVEL or DMAXACC missing is
+ * left 0 so callers who time slews must check for it.
+ * other fields are left zero.
+ * return 0 if ok, else -1 if any of home.cfg are missing.
+ */
+int
+tel_readmount (int trace, TelAxes *tap, MotorInfo minfo[])
+{
+#define NHCFG  (sizeof(hcfg)/sizeof(hcfg[0]))
+	double HMAXVEL = 0, HMAXACC = 0, DMAXVEL = 0, DMAXACC = 0;
+	int GERMEQ = 0, ZENFLIP = 0;
+	static double HT, DT, XP, YC, NP;
+	static double HPOSLIM, HNEGLIM, DPOSLIM, DNEGLIM;
+	static CfgEntry hcfg[] = {
+	    {"HT",	CFG_DBL, &HT},
+	    {"DT",	CFG_DBL, &DT},
+	    {"XP",	CFG_DBL, &XP},
+	    {"YC",	CFG_DBL, &YC},
+	    {"NP",	CFG_DBL, &NP},
+	    {"HPOSLIM",	CFG_DBL, &HPOSLIM},
+	    {"HNEGLIM",	CFG_DBL, &HNEGLIM},
+	    {"DPOSLIM",	CFG_DBL, &DPOSLIM},
+	    {"DNEGLIM",	CFG_DBL, &DNEGLIM},
+	};
+	MotorInfo *mip;
+	int LARGEXP = 0;
+
+	if (readCfgFile (trace, hcfn, hcfg, NHCFG) != NHCFG)
+	    return (-1);
+	(void) read1CfgEntry (trace, tdcfn, "HMAXVEL", CFG_DBL, &HMAXVEL, 0);
+	(void) read1CfgEntry (trace, tdcfn, "HMAXACC", CFG_DBL, &HMAXACC, 0);
+	(void) read1CfgEntry (trace, tdcfn, "DMAXVEL", CFG_DBL, &DMAXVEL, 0);
+	(void) read1CfgEntry (trace, tdcfn, "DMAXACC", CFG_DBL, &DMAXACC, 0);
+	(void) read1CfgEntry (trace, tdcfn, "GERMEQ", CFG_INT, &GERMEQ, 0);
+	(void) read1CfgEntry (trace, tdcfn, "ZENFLIP", CFG_INT, &ZENFLIP, 0);
+
+	/* same fix as telescoped for RA home switch > 180 degrees from north */
+	(void) read1CfgEntry (trace, hcfn, "LARGEXP", CFG_INT, &LARGEXP, 0);
+	if (LARGEXP) {
+	    HT -= (PI / 2);
+	    XP += (PI / 2);
+	}
+
+	memset ((void *)tap, 0, sizeof(*tap));
+	tap->GERMEQ = GERMEQ;
+	tap->ZENFLIP = ZENFLIP;
+	tap->HT = HT;
+	tap->DT = DT;
+	tap->XP = XP;
+	tap->YC = YC;
+	tap->NP = NP;
+	tap->hneglim = HNEGLIM;
+	tap->hposlim = HPOSLIM;
+
+	mip = &minfo[TEL_HM];
+	memset ((void *)mip, 0, sizeof(*mip));
+	mip->have = 1;
+	mip->maxvel = HMAXVEL;
+	mip->maxacc = HMAXACC;
+	mip->poslim = HPOSLIM;
+	mip->neglim = HNEGLIM;
+
+	mip = &minfo[TEL_DM];
+	memset ((void *)mip, 0, sizeof(*mip));
+	mip->have = 1;
+	mip->maxvel = DMAXVEL;
+	mip->maxacc = DMAXACC;
+	mip->poslim = DPOSLIM;
+	mip->neglim = DNEGLIM;
+
+	return (0);
+#undef NHCFG
+}
+
+/* find the axis positions the mount would use to point at apparent ha/dec.
+ * tap is not changed.
+ * return 0 if ok, else -1 if the place lies outside the axis limits.
+ */
+int
+tel_slewxy (TelAxes *tap, MotorInfo minfo[], double ha, double dec,
+double *xp, double *yp)
+{
+	TelAxes ta = *tap;	/* tel_ideal2realxy() sets GERMEQ_FLIP */
+	double x, y;
+
+	hdRange (&ha, &dec);
+	tel_hadec2xy (ha, dec, &ta, &x, &y);
+	tel_ideal2realxy (&ta, &x, &y);
+	if (wrapLimits (&minfo[TEL_HM], &x) < 0)
+	    return (-1);
+	if (wrapLimits (&minfo[TEL_DM], &y) < 0)
+	    return (-1);
+	*xp = x;
+	*yp = y;
+	return (0);
+}
+
+/* return secs for the axis described by mip to move from position from to
+ * position to, both rads, starting and ending at rest.
+ */
+double
+tel_axistime (MotorInfo *mip, double from, double to)
+{
+	double d = fabs (to - from);
+	double v = mip->maxvel, a = mip->maxacc;
+
+	if (d == 0 || v <= 0 || a <= 0)
+	    return (0.0);
+
+	/* reach full speed only if the ramps up and down fit */
+	if (d >= v*v/a)
+	    return (d/v + v/a);
+	return (2*sqrt(d/a));
+}
+
+/* return secs to slew from axis positions x0/y0 to x1/y1, as from
+ * tel_slewxy().
+ */
+double
+tel_slewtime (MotorInfo minfo[], double x0, double y0, double x1, double y1)
+{
+	double th = tel_axistime (&minfo[TEL_HM], x0, x1);
+	double td = tel_axistime (&minfo[TEL_DM], y0, y1);
+
+	return (th > td ? th : td);
+}
+
+/* wrap *vp by whole turns to lie within mip's limits, as chkLimits().
+ * return 0 if ok, else -1 if it falls in the gap between them.
+ */
+static int
+wrapLimits (MotorInfo *mip, double *vp)
+{
+	double v = *vp;
+
+	if (!mip->have)
+	    return (0);
+	while (v <= mip->neglim)
+	    v += 2*PI;
+	while (v >= mip->poslim)
+	    v -= 2*PI;
+	if (v <= mip->neglim || v >= mip->poslim)
+	    return (-1);
+	*vp = v;
+	return (0);
+}
@@ -21,6 +21,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
 
@@ -47,52 +48,244 @@ fYCn (double yc)
 	return (-fYC(yc));
 }
 
-/* global for access by chisqr */
-static int g_nstars;
-static TelAxes *g_tap;
-static double *g_H;
-static double *g_D;
-static double *g_X;
-static double *g_Y;
-static double *g_fitp;
-
+#define	NSP		5		/* n params solved for */
+#define	SOLVE_MAXIT	100		/* most steps */
+#define	SOLVE_DV	1e-7		/* step for derivatives, rads */
+#define	SOLVE_MAXLAM	1e10		/* give up when damping gets this big */
+
+/* what resid() needs, passed along so several solves can run at once */
+typedef struct {
+    int nstars;
+    TelAxes *tap;
+    double *H, *D;
+    double *X, *Y;
+    int *flip;
+    double *fitp;
+} SolveData;
+
+static double resid (SolveData *sdp, double v[NSP], double r[]);
+static int solveNormal (double a[NSP][NSP], double b[NSP], double x[NSP]);
+
+/* with the axes of sdp->tap but HT, DT, XP, YC and NP from v[], fill
+ * r[2*nstars] with the errors in HA, on sky, and Dec of each star, and
+ * sdp->fitp[] with how far each is off, all in rads. *sdp->tap itself is
+ * left alone.
+ * return sum of squares of r[].
+ */
 static double
-chisqr (double v[5])
+resid (SolveData *sdp, double v[NSP], double r[])
 {
-	TelAxes *tap = g_tap;
-	double err = 0.0;
+	TelAxes tax = *sdp->tap;
+	double ss = 0.0;
 	int i;
 
-	tap->HT = v[0];
-	tap->DT = v[1];
-	tap->XP = v[2];
-	tap->YC = v[3];
-	tap->NP = v[4];
+	tax.HT = v[0];
+	tax.DT = v[1];
+	tax.XP = v[2];
+	tax.YC = v[3];
+	tax.NP = v[4];
 
 	/* don't let Dec solution wander over the pole */
-	if (fabs(tap->DT) > degrad(90.0))
-	    return (100.0);
-
-	for (i = 0; i < g_nstars; i++) {
-	    double x = g_X[i];
-	    double y = g_Y[i];
-	    double h, d, ca;
-
-	    tel_realxy2ideal (tap, &x, &y);
-	    tel_xy2hadec (x, y, tap, &h, &d);
-	    solve_sphere (h-g_H[i], PI/2-g_D[i], sin(d), cos(d), &ca, NULL);
-	    err += g_fitp[i] = acos(ca);
+	if (fabs(tax.DT) > degrad(90.0))
+	    return (HUGE_VAL);
+
+	for (i = 0; i < sdp->nstars; i++) {
+	    double x = sdp->X[i];
+	    double y = sdp->Y[i];
+	    double h, d, dh;
+
+	    /* each star stays on the side of the pier it was seen on */
+	    if (sdp->flip)
+		tax.GERMEQ_FLIP = sdp->flip[i] ? 1 : 0;
+
+	    tel_realxy2ideal (&tax, &x, &y);
+	    tel_xy2hadec (x, y, &tax, &h, &d);
+	    dh = h - sdp->H[i];
+	    haRange (&dh);
+	    if (dh > PI)
+		dh -= 2*PI;
+	    r[2*i] = dh*cos(sdp->D[i]);
+	    r[2*i+1] = d - sdp->D[i];
+	    sdp->fitp[i] = sqrt(r[2*i]*r[2*i] + r[2*i+1]*r[2*i+1]);
+	    ss += r[2*i]*r[2*i] + r[2*i+1]*r[2*i+1];
 	}
 
 #ifdef CHISQR_TRACE
-	fprintf (stderr, "HDXYN: %6.3f %6.3f %6.3f %6.3f %6.3f -> %10.7f\n",
-			    tap->HT, tap->DT, tap->XP, tap->YC, tap->NP, err);
+	fprintf (stderr, "HDXYN: %6.3f %6.3f %6.3f %6.3f %6.3f -> %10.7g\n",
+			    tax.HT, tax.DT, tax.XP, tax.YC, tax.NP, ss);
 #endif /* CHISQR_TRACE */
 
-	/* solver seems to work better if not driving towards 0 */
-	err += 1;
+	return (ss);
+}
+
+/* find the axes of the scope from nstars stars each seen at real encoder
+ * values X[] and Y[] when it was really at H[] and D[], all in rads.
+ * flip[] is the GERMEQ_FLIP each was seen with, as tel_ideal2realxy() set
+ * it, or NULL if all were seen as *tap is now.
+ * *tap is the first guess, including GERMEQ and ZENFLIP; on return HT, DT,
+ * XP, YC and NP are those which make the sum of the squares of the errors
+ * least, the rest is unchanged, and fitp[] is the error of each star with
+ * them, in rads. it is done when a step makes that sum smaller by less than
+ * ftol of itself.
+ * safe to use from several threads at once, each with its own *tap.
+ * return 0 if ok, else -1 if it did not settle or no memory.
+ */
+int
+tel_solve_axes (
+double H[], double D[],		/* where each star really was */
+double X[], double Y[],		/* encoders when it was seen there */
+int flip[],			/* GERMEQ_FLIP of each, or NULL */
+int nstars,			/* n of each */
+double ftol,			/* fractional tolerance */
+TelAxes *tap,			/* guess in, solution out */
+double fitp[])			/* error of each star */
+{
+	double v[NSP], ss, lam = 1e-3;
+	double *r, *rt, *jac;
+	SolveData sd;
+	int nr = 2*nstars;
+	int it, ret = -1;
+	int i, j, k;
+
+	if (nstars < NSP)
+	    return (-1);
+	r = (double *) malloc ((NSP+2)*nr*sizeof(double));
+	if (!r)
+	    return (-1);
+	rt = r + nr;
+	jac = rt + nr;
+
+	sd.nstars = nstars;
+	sd.tap = tap;
+	sd.H = H;
+	sd.D = D;
+	sd.X = X;
+	sd.Y = Y;
+	sd.flip = flip;
+	sd.fitp = fitp;
+
+	v[0] = tap->HT;
+	v[1] = tap->DT;
+	v[2] = tap->XP;
+	v[3] = tap->YC;
+	v[4] = tap->NP;
+	ss = resid (&sd, v, r);
+
+	/* Levenberg-Marquardt, with derivatives by differences */
+	for (it = 0; it < SOLVE_MAXIT && ret < 0; it++) {
+	    double a[NSP][NSP], b[NSP];
+
+	    for (j = 0; j < NSP; j++) {
+		double *jp = &jac[j*nr];
+		double vj = v[j];
+
+		v[j] += SOLVE_DV;
+		(void) resid (&sd, v, jp);
+		v[j] = vj;
+		for (k = 0; k < nr; k++)
+		    jp[k] = (jp[k] - r[k])/SOLVE_DV;
+	    }
+	    for (j = 0; j < NSP; j++) {
+		b[j] = 0;
+		for (k = 0; k < nr; k++)
+		    b[j] -= jac[j*nr+k]*r[k];
+		for (i = 0; i <= j; i++) {
+		    a[i][j] = 0;
+		    for (k = 0; k < nr; k++)
+			a[i][j] += jac[i*nr+k]*jac[j*nr+k];
+		    a[j][i] = a[i][j];
+		}
+	    }
+
+	    /* damp more until a step helps */
+	    while (1) {
+		double ad[NSP][NSP], dv[NSP], vt[NSP], sst;
+
+		memcpy (ad, a, sizeof(ad));
+		for (j = 0; j < NSP; j++) {
+		    ad[j][j] *= 1 + lam;
+		    vt[j] = v[j];
+		}
+		if (solveNormal (ad, b, dv) == 0) {
+		    for (j = 0; j < NSP; j++)
+			vt[j] += dv[j];
+		    sst = resid (&sd, vt, rt);
+		    if (sst <= ss) {
+			if (ss - sst <= ftol*ss)
+			    ret = 0;
+			memcpy (v, vt, sizeof(v));
+			memcpy (r, rt, nr*sizeof(double));
+			ss = sst;
+			lam /= 10;
+			break;
+		    }
+		}
+		lam *= 10;
+		if (lam > SOLVE_MAXLAM) {
+		    /* no step helps, so we are as close as we can get */
+		    ret = 0;
+		    break;
+		}
+	    }
+
+#ifdef SOLVE_TRACE
+	    fprintf (stderr, "solve %d: %.10g lam %g\n", it, ss, lam);
+#endif /* SOLVE_TRACE */
+	}
 
-	return (err);
+	/* leave *tap and fitp[] as of the best */
+	(void) resid (&sd, v, r);
+	tap->HT = v[0];
+	tap->DT = v[1];
+	tap->XP = v[2];
+	tap->YC = v[3];
+	tap->NP = v[4];
+	free ((void *)r);
+	return (ret);
+}
+
+/* solve a[][] x[] = b[] by gaussian elimination with partial pivoting.
+ * a[][] is destroyed.
+ * return 0 if ok, else -1 if singular.
+ */
+static int
+solveNormal (double a[NSP][NSP], double b[NSP], double x[NSP])
+{
+	double bb[NSP];
+	int i, j, k;
+
+	memcpy (bb, b, sizeof(bb));
+	for (i = 0; i < NSP; i++) {
+	    int p = i;
+
+	    for (j = i+1; j < NSP; j++)
+		if (fabs(a[j][i]) > fabs(a[p][i]))
+		    p = j;
+	    if (a[p][i] == 0)
+		return (-1);
+	    if (p != i) {
+		double t[NSP], tb;
+		memcpy (t, a[i], sizeof(t));
+		memcpy (a[i], a[p], sizeof(t));
+		memcpy (a[p], t, sizeof(t));
+		tb = bb[i];
+		bb[i] = bb[p];
+		bb[p] = tb;
+	    }
+	    for (j = i+1; j < NSP; j++) {
+		double f = a[j][i]/a[i][i];
+		for (k = i; k < NSP; k++)
+		    a[j][k] -= f*a[i][k];
+		bb[j] -= f*bb[i];
+	    }
+	}
+	for (i = NSP-1; i >= 0; i--) {
+	    double s = bb[i];
+	    for (k = i+1; k < NSP; k++)
+		s -= a[i][k]*x[k];
+	    x[i] = s/a[i][i];
+	}
+	return (0);
 }
 
 /* given an HA/Dec location and the telescope orientation parameters,
@@ -0,0 +1,466 @@
+/* read, build, write and search the pointing mesh of telmesh.h. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "strops.h"
+#include "telenv.h"
+#include "telmesh.h"
+
+#define	COMMENT	'#'		/* ignore lines beginning with this */
+
+static void setPtrs (TMesh *mp);
+static int cellOf (TMHdr *hp, double ha, double dec);
+static int bandOf (TMHdr *hp, double dec);
+static int haCell (TMHdr *hp, double ha);
+static int cmpDec (const void *p1, const void *p2);
+
+/* read the text mesh file fn into a new malloced *ptp, in rads.
+ * bad lines are skipped after a word to pf, which may be NULL.
+ * return count, else -1 with errno set if can not open fn or no memory.
+ */
+int
+tmReadText (char *fn, TMPoint **ptp, TMPrFp pf)
+{
+	TMPoint *pt = NULL;
+	char line[1024];
+	int n = 0, max = 0;
+	int lineno = 0;
+	FILE *fp;
+
+	*ptp = NULL;
+	fp = telfopen (fn, "r");
+	if (!fp)
+	    return (-1);
+
+	while (fgets (line, sizeof(line), fp)) {
+	    double ha, dec, dha, ddec;
+
+	    lineno++;
+	    if (line[0] == COMMENT)
+		continue;
+	    if (sscanf (line, "%lf %lf %lf %lf", &ha, &dec, &dha, &ddec) != 4) {
+		if (pf)
+		    (*pf) ("%s: skipping bad entry, line %d", basenm(fn),
+									lineno);
+		continue;
+	    }
+	    if (n == max) {
+		TMPoint *newpt;
+		max = max ? 2*max : 256;
+		newpt = (TMPoint *) realloc ((void *)pt, max*sizeof(TMPoint));
+		if (!newpt) {
+		    free ((void *)pt);
+		    fclose (fp);
+		    errno = ENOMEM;
+		    return (-1);
+		}
+		pt = newpt;
+	    }
+	    pt[n].ha = hrrad(ha);
+	    pt[n].dec = degrad(dec);
+	    pt[n].dha = degrad(dha/60.0);
+	    pt[n].ddec = degrad(ddec/60.0);
+	    n++;
+	}
+
+	fclose (fp);
+	*ptp = pt;
+	return (n);
+}
+
+/* build a new malloced mesh in *mp of the n points pt[], with generation gen.
+ * return 0 if ok, else -1 with errno set.
+ */
+int
+tmBuild (TMPoint *pt, int n, unsigned gen, TMesh *mp)
+{
+	int ndec, nha, ncell;
+	int *fill;
+	TMHdr *hp;
+	size_t len;
+	int i;
+
+	/* about TM_PERCELL per cell, cells twice as wide as tall */
+	ndec = (int) sqrt ((double)n/TM_PERCELL/2);
+	if (ndec < 1)
+	    ndec = 1;
+	if (ndec > TM_MAXNDEC)
+	    ndec = TM_MAXNDEC;
+	nha = 2*ndec;
+	ncell = ndec*nha;
+
+	len = sizeof(TMHdr) + n*sizeof(TMPoint) + (ncell+1)*sizeof(int);
+	hp = (TMHdr *) calloc (1, len);
+	fill = (int *) calloc (ncell, sizeof(int));
+	if (!hp || !fill) {
+	    free ((void *)hp);
+	    free ((void *)fill);
+	    errno = ENOMEM;
+	    return (-1);
+	}
+	hp->magic = TM_MAGIC;
+	hp->version = TM_VERSION;
+	hp->hdrsize = sizeof(TMHdr);
+	hp->gen = gen;
+	hp->npoints = n;
+	hp->ndec = ndec;
+	hp->nha = nha;
+	mp->hp = hp;
+	mp->len = len;
+	mp->mapped = 0;
+	setPtrs (mp);
+
+	/* count each cell, then where each starts, then place each point */
+	for (i = 0; i < n; i++)
+	    mp->cell[cellOf (hp, pt[i].ha, pt[i].dec) + 1]++;
+	for (i = 0; i < ncell; i++)
+	    mp->cell[i+1] += mp->cell[i];
+	for (i = 0; i < n; i++) {
+	    int c = cellOf (hp, pt[i].ha, pt[i].dec);
+	    mp->pt[mp->cell[c] + fill[c]++] = pt[i];
+	}
+	free ((void *)fill);
+
+	/* by dec within each cell */
+	for (i = 0; i < ncell; i++)
+	    qsort ((void *)&mp->pt[mp->cell[i]], mp->cell[i+1] - mp->cell[i],
+						    sizeof(TMPoint), cmpDec);
+
+	return (0);
+}
+
+/* map the binary mesh file fn into *mp and check it is sound.
+ * return 0 if ok, else -1 with errno set.
+ */
+int
+tmOpen (char *fn, TMesh *mp)
+{
+	struct stat st;
+	TMHdr *hp;
+	void *addr;
+	size_t len;
+	int ncell;
+	int fd, i;
+
+	fd = telopen (fn, O_RDONLY);
+	if (fd < 0)
+	    return (-1);
+	if (fstat (fd, &st) < 0) {
+	    close (fd);
+	    return (-1);
+	}
+	if (st.st_size < sizeof(TMHdr)) {
+	    close (fd);
+	    errno = EINVAL;
+	    return (-1);
+	}
+	addr = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);
+	if (addr == MAP_FAILED)
+	    return (-1);
+
+	hp = (TMHdr *) addr;
+	mp->hp = hp;
+	mp->len = st.st_size;
+	mp->mapped = 1;
+
+	/* the header must agree with itself and the file */
+	if (hp->magic != TM_MAGIC || hp->version != TM_VERSION
+		|| hp->hdrsize != sizeof(TMHdr) || hp->npoints < 0
+		|| hp->ndec < 1 || hp->ndec > TM_MAXNDEC
+		|| hp->nha != 2*hp->ndec)
+	    goto bad;
+	ncell = hp->ndec*hp->nha;
+	len = sizeof(TMHdr) + hp->npoints*sizeof(TMPoint)
+						    + (ncell+1)*sizeof(int);
+	if (len != mp->len)
+	    goto bad;
+	setPtrs (mp);
+
+	/* and so must the cells, so no search can stray */
+	if (mp->cell[0] != 0 || mp->cell[ncell] != hp->npoints)
+	    goto bad;
+	for (i = 0; i < ncell; i++)
+	    if (mp->cell[i+1] < mp->cell[i])
+		goto bad;
+
+	return (0);
+
+    bad:
+	munmap (addr, st.st_size);
+	mp->hp = NULL;
+	errno = EINVAL;
+	return (-1);
+}
+
+/* write *mp to the binary mesh file fn.
+ * it is written to fn.tmp then renamed, see telmesh.h.
+ * return 0 if ok, else -1 with errno set.
+ */
+int
+tmWrite (char *fn, TMesh *mp)
+{
+	char tmp[1024];
+	int fd;
+
+	sprintf (tmp, "%s.tmp", fn);
+	fd = open (tmp, O_WRONLY|O_CREAT|O_TRUNC, 0664);
+	if (fd < 0)
+	    return (-1);
+	if (write (fd, (void *)mp->hp, mp->len) != mp->len || fsync (fd) < 0) {
+	    int e = errno;
+	    close (fd);
+	    (void) unlink (tmp);
+	    errno = e ? e : EIO;
+	    return (-1);
+	}
+	if (close (fd) < 0 || rename (tmp, fn) < 0) {
+	    int e = errno;
+	    (void) unlink (tmp);
+	    errno = e;
+	    return (-1);
+	}
+	return (0);
+}
+
+/* release *mp */
+void
+tmClose (TMesh *mp)
+{
+	if (!mp->hp)
+	    return;
+	if (mp->mapped)
+	    munmap ((void *)mp->hp, mp->len);
+	else
+	    free ((void *)mp->hp);
+	mp->hp = NULL;
+	mp->pt = NULL;
+	mp->cell = NULL;
+}
+
+/* find the runs of mp->pt[] in cells which may hold points within r rads of
+ * ha and dec. fill runs[i] with the first index and one past the last of
+ * each, at most TM_MAXRANGES. return count.
+ */
+int
+tmRanges (TMesh *mp, double ha, double dec, double r, int runs[][2])
+{
+	TMHdr *hp = mp->hp;
+	int nha = hp->nha;
+	int h0 = 0, h1 = nha-1;		/* HA cells, all until narrowed */
+	int b, b0, b1;
+	int whole;
+	int nr = 0;
+
+	if (!hp->npoints)
+	    return (0);
+
+	/* all HA if the circle reaches a pole, else its widest HA from ha */
+	whole = fabs(dec) + r >= PI/2;
+	if (!whole) {
+	    double dh = asin (sin(r)/cos(dec));
+	    double hw = 2*PI/nha;
+
+	    h0 = (int) floor ((ha - dh)/hw);
+	    h1 = (int) floor ((ha + dh)/hw);
+	    whole = h1 - h0 + 1 >= nha;
+	    h0 = ((h0 % nha) + nha) % nha;
+	    h1 = ((h1 % nha) + nha) % nha;
+	}
+
+	b0 = bandOf (hp, dec - r);
+	b1 = bandOf (hp, dec + r);
+	for (b = b0; b <= b1; b++) {
+	    int *cp = &mp->cell[b*nha];
+
+	    if (whole) {
+		runs[nr][0] = cp[0];
+		runs[nr][1] = cp[nha];
+		nr++;
+	    } else if (h0 <= h1) {
+		runs[nr][0] = cp[h0];
+		runs[nr][1] = cp[h1+1];
+		nr++;
+	    } else {
+		runs[nr][0] = cp[h0];
+		runs[nr][1] = cp[nha];
+		nr++;
+		runs[nr][0] = cp[0];
+		runs[nr][1] = cp[h1+1];
+		nr++;
+	    }
+	}
+
+	return (nr);
+}
+
+/* find the error of mp at ha and dec, as telescoped does.
+ * use a weighted average based on distance if find two or more mesh points
+ *   within r rads. the weight is the inverse of the distance away from the
+ *   target, scaled 1 to 0 out to r. If don't find at least two then just
+ *   use the closest directly, or 0 if mp has no points.
+ */
+void
+tmInterp (TMesh *mp, double r, double ha, double dec, double *ehap,
+    double *edecp)
+{
+	tmInterpN (mp, 1, &r, ha, dec, ehap, edecp);
+}
+
+/* same as tmInterp() at each of the nr radii r[], at most TM_MAXRADII, into
+ * ehap[] and edecp[], for about the cost of the largest alone.
+ * N.B. only the cells of mp near the target are searched for the averages.
+ */
+void
+tmInterpN (TMesh *mp, int nr, double r[], double ha, double dec,
+    double ehap[], double edecp[])
+{
+	double cdec = cos(dec), sdec = sin(dec);
+	double swh[TM_MAXRADII], swd[TM_MAXRADII], sw[TM_MAXRADII];
+	int nfound[TM_MAXRADII];
+	int runs[TM_MAXRANGES][2];
+	TMPoint *closestrp = NULL;
+	double closestcosr = -1;
+	double rmax, crmax;
+	int nrun, k, j;
+	int i;
+
+	if (nr > TM_MAXRADII)
+	    nr = TM_MAXRADII;
+	rmax = 0;
+	for (j = 0; j < nr; j++) {
+	    ehap[j] = edecp[j] = 0.0;
+	    swh[j] = swd[j] = sw[j] = 0.0;
+	    nfound[j] = 0;
+	    if (r[j] > rmax)
+		rmax = r[j];
+	}
+	if (!mp->hp || !mp->hp->npoints)
+	    return;
+	crmax = cos(rmax);
+
+	nrun = tmRanges (mp, ha, dec, rmax, runs);
+	for (k = 0; k < nrun; k++) {
+	    for (i = runs[k][0]; i < runs[k][1]; i++) {
+		TMPoint *rp = &mp->pt[i];
+		double cosr, d;	/* cos dist, dist */
+
+		/* distance to this mesh point -- reject at once if > r */
+		cosr = sdec*sin(rp->dec) + cdec*cos(rp->dec)*cos(ha - rp->ha);
+		if (cosr < crmax)
+		    continue;
+		if (cosr > closestcosr) {
+		    closestrp = rp;
+		    closestcosr = cosr;
+		}
+		d = acos(cosr > 1 ? 1 : cosr);
+
+		/* weight varies linearly from 1 if right on a mesh point to 0
+		 * at r.
+		 */
+		for (j = 0; j < nr; j++) {
+		    double w;
+
+		    if (d > r[j])
+			continue;
+		    w = (r[j] - d)/r[j];
+		    swh[j] += w*rp->dha;
+		    swd[j] += w*rp->ddec;
+		    sw[j] += w;
+		    nfound[j]++;
+		}
+	    }
+	}
+
+	/* if found at least two, use average.
+	 * else find closest and use it.
+	 */
+	for (j = 0; j < nr; j++) {
+	    if (nfound[j] >= 2 && sw[j] > 0) {
+		ehap[j] = swh[j]/sw[j];
+		edecp[j] = swd[j]/sw[j];
+		continue;
+	    }
+	    if (!closestrp) {
+		/* none near at all, look everywhere, just once */
+		for (i = 0; i < mp->hp->npoints; i++) {
+		    TMPoint *rp = &mp->pt[i];
+		    double cosr;
+
+		    cosr = sdec*sin(rp->dec)
+					+ cdec*cos(rp->dec)*cos(ha - rp->ha);
+		    if (cosr > closestcosr) {
+			closestrp = rp;
+			closestcosr = cosr;
+		    }
+		}
+	    }
+	    ehap[j] = closestrp->dha;
+	    edecp[j] = closestrp->ddec;
+	}
+}
+
+/* set mp->pt and mp->cell from mp->hp */
+static void
+setPtrs (TMesh *mp)
+{
+	mp->pt = (TMPoint *)(mp->hp + 1);
+	mp->cell = (int *)(mp->pt + mp->hp->npoints);
+}
+
+/* return the cell of ha and dec */
+static int
+cellOf (TMHdr *hp, double ha, double dec)
+{
+	return (bandOf (hp, dec)*hp->nha + haCell (hp, ha));
+}
+
+/* return the band of dec */
+static int
+bandOf (TMHdr *hp, double dec)
+{
+	int b = (int) floor ((dec + PI/2)/(PI/hp->ndec));
+
+	if (b < 0)
+	    b = 0;
+	if (b >= hp->ndec)
+	    b = hp->ndec - 1;
+	return (b);
+}
+
+/* return the HA cell of ha, any turn */
+static int
+haCell (TMHdr *hp, double ha)
+{
+	int h;
+
+	ha = fmod (ha, 2*PI);
+	if (ha < 0)
+	    ha += 2*PI;
+	h = (int) floor (ha/(2*PI/hp->nha));
+	return (h < hp->nha ? h : hp->nha - 1);
+}
+
+/* qsort-style function to compare 2 TMPoints by increasing dec */
+static int
+cmpDec (const void *p1, const void *p2)
+{
+	double ddec = ((TMPoint *)p1)->dec - ((TMPoint *)p2)->dec;
+
+	if (ddec < 0)
+	    return (-1);
+	if (ddec > 0)
+	    return (1);
+	return (0);
+}
@@ -0,0 +1,77 @@
+/* the pointing mesh, in a form telescoped can map and use as it is.
+ *
+ * a mesh is a list of sky locations and the pointing error at each. the
+ * text form, archive/config/telescoped.mesh, has a line per point of HA in
+ * hours, Dec in degrees, then the errors in HA (as a polar angle) and Dec in
+ * arc mins; lines starting with # are ignored. meshbin turns it into the
+ * binary form, telescoped.mbin, which is laid out as:
+ *
+ *   TMHdr
+ *   TMPoint pt[npoints]	all in rads, sorted by cell then by dec
+ *   int cell[ndec*nha+1]	pt[] index of the first point of each cell
+ *
+ * the cells divide the sky into ndec bands of dec from -90 degrees, each
+ * split into nha cells of HA from 0, so cell b*nha + h holds
+ * pt[cell[b*nha+h] .. cell[b*nha+h+1]-1]. the points of neighbouring HA cells
+ * in a band are next to each other, so tmRanges() can name everything near a
+ * location as a few runs of pt[].
+ *
+ * words are in the byte order of the host that wrote it; a file from the
+ * other order fails the magic check. a new file gets the gen of the one it
+ * replaces plus one, and is renamed into place so a reader never sees it
+ * part written and anyone still mapping the old one keeps it intact.
+ */
+
+#ifndef TELMESH_H
+#define TELMESH_H
+
+#include <stddef.h>
+
+#define	TM_MAGIC	0x48534d54	/* "TMSH" */
+#define	TM_VERSION	1
+#define	TM_PERCELL	4		/* aim for about this many pts per cell */
+#define	TM_MAXNDEC	256		/* most dec bands */
+#define	TM_MAXRANGES	(2*TM_MAXNDEC)	/* most runs tmRanges() can find */
+#define	TM_MAXRADII	16		/* most radii for tmInterpN() */
+
+typedef struct {
+    unsigned magic;		/* TM_MAGIC */
+    unsigned version;		/* TM_VERSION */
+    unsigned hdrsize;		/* sizeof(TMHdr) */
+    unsigned gen;		/* generation, see above */
+    int npoints;		/* n pt[] */
+    int ndec;			/* n dec bands */
+    int nha;			/* n HA cells in each band */
+    int pad;
+} TMHdr;
+
+typedef struct {
+    double ha, dec;		/* sky loc of error node */
+    double dha, ddec;		/* error (target - wcs), dha is polar angle */
+} TMPoint;
+
+/* a mesh in memory, malloced or mapped */
+typedef struct {
+    TMHdr *hp;			/* header, and start of whole image */
+    TMPoint *pt;		/* hp->npoints points */
+    int *cell;			/* hp->ndec*hp->nha + 1 first indices */
+    size_t len;			/* bytes in whole image */
+    int mapped;			/* set if mmap()ed, else malloced */
+} TMesh;
+
+typedef void (*TMPrFp)();
+
+/* telmesh.c */
+extern int tmReadText (char *fn, TMPoint **ptp, TMPrFp pf);
+extern int tmBuild (TMPoint *pt, int n, unsigned gen, TMesh *mp);
+extern int tmOpen (char *fn, TMesh *mp);
+extern int tmWrite (char *fn, TMesh *mp);
+extern void tmClose (TMesh *mp);
+extern int tmRanges (TMesh *mp, double ha, double dec, double r,
+    int runs[][2]);
+extern void tmInterp (TMesh *mp, double r, double ha, double dec,
+    double *ehap, double *edecp);
+extern void tmInterpN (TMesh *mp, int nr, double r[], double ha, double dec,
+    double ehap[], double edecp[]);
+
+#endif // TELMESH_H
@@ -0,0 +1,232 @@
+/* build and read the compact binary status frames of telstatframe.h.
+ * telescoped uses tsfFill() and tsfKey()/tsfDelta() to send, clients use
+ * tsfApply() to keep their own copy of the words up to date.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <arpa/inet.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "telstatshm.h"
+#include "telstatframe.h"
+
+#define	MASPERRAD	(180.*3600.*1000./PI)
+#define	MAXWORD		2147483647.
+
+static int mas (double a);
+static int clampw (double v);
+static void put (char **bpp, unsigned v);
+static unsigned get (char **bpp);
+
+/* fill w[] with the frame words for *tsp */
+void
+tsfFill (TelStatShm *tsp, int w[TSF_NW])
+{
+    MotorInfo *mip = tsp->minfo;
+    double day = floor (tsp->now.n_mjd);
+    int flags, m;
+
+    flags = tsp->jogging_ison ? TSF_JOGGING : 0;
+    for (m = 0; m < TEL_NM; m++) {
+        if (mip[m].have)
+            flags |= TSF_MHAVE(m);
+        if (mip[m].ishomed)
+            flags |= TSF_MHOMED(m);
+        if (mip[m].homing)
+            flags |= TSF_MHOMING(m);
+        if (mip[m].limiting)
+            flags |= TSF_MLIMITING(m);
+    }
+
+    w[TSF_STATE] = tsp->telstate;
+    w[TSF_STATEIDX] = tsp->telstateidx;
+    w[TSF_FLAGS] = flags;
+    w[TSF_MJDDAY] = (int) day;
+    w[TSF_MJDMS] = clampw ((tsp->now.n_mjd - day)*SPD*1000);
+
+    w[TSF_CRA] = mas (tsp->CJ2kRA);
+    w[TSF_CDEC] = mas (tsp->CJ2kDec);
+    w[TSF_CHA] = mas (tsp->CAHA);
+    w[TSF_CALT] = mas (tsp->Calt);
+    w[TSF_CAZ] = mas (tsp->Caz);
+    w[TSF_CPA] = mas (tsp->CPA);
+    w[TSF_LST] = mas (tsp->Clst);
+
+    w[TSF_DRA] = mas (tsp->DJ2kRA);
+    w[TSF_DDEC] = mas (tsp->DJ2kDec);
+    w[TSF_DHA] = mas (tsp->DAHA);
+    w[TSF_DALT] = mas (tsp->Dalt);
+    w[TSF_DAZ] = mas (tsp->Daz);
+    w[TSF_DPA] = mas (tsp->DPA);
+
+    w[TSF_JDHA] = mas (tsp->jdha);
+    w[TSF_JDDEC] = mas (tsp->jddec);
+    w[TSF_MDHA] = mas (tsp->mdha);
+    w[TSF_MDDEC] = mas (tsp->mddec);
+
+    w[TSF_HCPOS] = mas (mip[TEL_HM].cpos);
+    w[TSF_HDPOS] = mas (mip[TEL_HM].dpos);
+    w[TSF_DCPOS] = mas (mip[TEL_DM].cpos);
+    w[TSF_DDPOS] = mas (mip[TEL_DM].dpos);
+    w[TSF_RCPOS] = mas (mip[TEL_RM].cpos);
+    w[TSF_RDPOS] = mas (mip[TEL_RM].dpos);
+    w[TSF_HRAW] = mip[TEL_HM].raw;
+    w[TSF_DRAW] = mip[TEL_DM].raw;
+    w[TSF_RRAW] = mip[TEL_RM].raw;
+
+    w[TSF_RERR] = mas (tsp->Rerr);
+    w[TSF_XTQ] = tsp->xtqdepth;
+    w[TSF_XTUNDER] = tsp->xtunderrun;
+
+    w[TSF_TEMP] = clampw (tsp->now.n_temp*1000);
+    w[TSF_PRESSURE] = clampw (tsp->now.n_pressure*1000);
+}
+
+/* put a key frame of w[] into buf[].
+ * return its length in bytes.
+ */
+int
+tsfKey (int w[TSF_NW], unsigned seq, char buf[TSF_MAXBYTES])
+{
+    char *bp = buf;
+    int i;
+
+    put (&bp, TSF_MAGIC << 16 | TSF_VERSION << 8 | TSF_KEY);
+    put (&bp, seq);
+    for (i = 0; i < TSF_NW; i++)
+        put (&bp, (unsigned)w[i]);
+    return (bp - buf);
+}
+
+/* put a delta frame of the words in w[] that differ from prev[] into buf[].
+ * return its length in bytes.
+ */
+int
+tsfDelta (int prev[TSF_NW], int w[TSF_NW], unsigned seq,
+char buf[TSF_MAXBYTES])
+{
+    unsigned mask[TSF_NMASK];
+    char *bp = buf;
+    int i;
+
+    memset ((void *)mask, 0, sizeof(mask));
+    for (i = 0; i < TSF_NW; i++)
+        if (w[i] != prev[i])
+            mask[i/32] |= 1u << (i%32);
+
+    put (&bp, TSF_MAGIC << 16 | TSF_VERSION << 8 | TSF_DELTA);
+    put (&bp, seq);
+    for (i = 0; i < TSF_NMASK; i++)
+        put (&bp, mask[i]);
+    for (i = 0; i < TSF_NW; i++)
+        if (mask[i/32] & 1u << (i%32))
+            put (&bp, (unsigned)w[i]);
+    return (bp - buf);
+}
+
+/* apply the frame at the front of buf[n] to w[] and set *seqp to its
+ * sequence number. a delta applies only to the frame numbered *seqp.
+ * return the bytes used, 0 if buf does not yet hold a whole frame, or -1 if
+ * it is not a frame we know or a delta is out of sequence.
+ */
+int
+tsfApply (char *buf, int n, int w[TSF_NW], unsigned *seqp)
+{
+    unsigned mask[TSF_NMASK];
+    unsigned hdr, seq;
+    char *bp = buf;
+    int i, nw;
+
+    if (n < 8)
+        return (0);
+    hdr = get (&bp);
+    seq = get (&bp);
+    if (hdr >> 8 != (TSF_MAGIC << 8 | TSF_VERSION))
+        return (-1);
+
+    switch (hdr & 0xff) {
+    case TSF_KEY:
+        if (n < 4*(2 + TSF_NW))
+            return (0);
+        for (i = 0; i < TSF_NW; i++)
+            w[i] = (int) get (&bp);
+        break;
+
+    case TSF_DELTA:
+        if (n < 4*(2 + TSF_NMASK))
+            return (0);
+        if (seq != *seqp + 1)
+            return (-1);
+        nw = 0;
+        for (i = 0; i < TSF_NMASK; i++) {
+            unsigned m;
+            mask[i] = get (&bp);
+            for (m = mask[i]; m; m &= m - 1)
+                nw++;
+        }
+        if (n < 4*(2 + TSF_NMASK + nw))
+            return (0);
+        for (i = 0; i < TSF_NW; i++)
+            if (mask[i/32] & 1u << (i%32))
+                w[i] = (int) get (&bp);
+        break;
+
+    default:
+        return (-1);
+    }
+
+    *seqp = seq;
+    return (bp - buf);
+}
+
+/* return the mjd held in w[] */
+double
+tsfMJD (int w[TSF_NW])
+{
+    return (w[TSF_MJDDAY] + w[TSF_MJDMS]/(SPD*1000));
+}
+
+/* return angle a, rads, as a word of milliarcsecs */
+static int
+mas (double a)
+{
+    return (clampw (a*MASPERRAD));
+}
+
+/* round v to the nearest int that fits in a word */
+static int
+clampw (double v)
+{
+    v = floor (v + .5);
+    if (v > MAXWORD)
+        v = MAXWORD;
+    if (v < -MAXWORD)
+        v = -MAXWORD;
+    return ((int) v);
+}
+
+/* put v at *bpp in network order and advance */
+static void
+put (char **bpp, unsigned v)
+{
+    unsigned nv = htonl (v);
+
+    memcpy (*bpp, (void *)&nv, 4);
+    *bpp += 4;
+}
+
+/* return the network-order word at *bpp and advance */
+static unsigned
+get (char **bpp)
+{
+    unsigned nv;
+
+    memcpy ((void *)&nv, *bpp, 4);
+    *bpp += 4;
+    return (ntohl (nv));
+}
@@ -0,0 +1,88 @@
+/* compact binary frames of telescope status for remote telemetry clients.
+ *
+ * a frame is a fixed list of TSF_NW 32-bit signed words taken from
+ * TelStatShm, in the order of TSFWord below. angles are milliarcsecs, so
+ * every field fits and small changes leave most words alone. telescoped
+ * sends a key frame with every word, then delta frames with just those that
+ * changed since the frame before, so a client must apply them in order.
+ *
+ * on the wire everything is 32-bit words in network byte order:
+ *   word 0	TSF_MAGIC << 16 | TSF_VERSION << 8 | TSF_KEY or TSF_DELTA
+ *   word 1	frame sequence number, one more than the frame before
+ *   key:	TSF_NW words
+ *   delta:	TSF_NMASK words of bits, lsb first, set for each word that
+ *		changed, followed by just those words in order
+ * new words are only ever added at the end, with a new TSF_VERSION.
+ *
+ * while tracking, the time, the current and desired HA, alt, az and
+ * parallactic angle, LST, and the H axis positions and raw count change
+ * every frame, as do any axis' words whose encoder dithers. that is about
+ * 17 words, so a delta is about 84 bytes, some 840 bytes/sec at 10 Hz.
+ * src/tests/tsfcheck.c checks this.
+ */
+
+#ifndef TELSTATFRAME_H
+#define TELSTATFRAME_H
+
+#include "telstatshm.h"
+
+#define	TSF_MAGIC	0x5453		/* "TS" */
+#define	TSF_VERSION	1
+#define	TSF_KEY		1		/* frame holds every word */
+#define	TSF_DELTA	2		/* frame holds only changed words */
+
+/* index of each word in a frame */
+typedef enum {
+    TSF_STATE,			/* TelState */
+    TSF_STATEIDX,		/* telstateidx */
+    TSF_FLAGS,			/* TSF_JOGGING and TSF_M* bits, below */
+    TSF_MJDDAY,			/* whole days of now.n_mjd */
+    TSF_MJDMS,			/* ms into the day of now.n_mjd */
+
+    TSF_CRA, TSF_CDEC,		/* current J2000 RA/Dec */
+    TSF_CHA, TSF_CALT, TSF_CAZ,	/* current EOD HA, alt, az */
+    TSF_CPA, TSF_LST,		/* current parallactic angle, LST */
+
+    TSF_DRA, TSF_DDEC,		/* desired J2000 RA/Dec */
+    TSF_DHA, TSF_DALT, TSF_DAZ,	/* desired EOD HA, alt, az */
+    TSF_DPA,			/* desired parallactic angle */
+
+    TSF_JDHA, TSF_JDDEC,	/* jogging offsets */
+    TSF_MDHA, TSF_MDDEC,	/* mesh corrections */
+
+    TSF_HCPOS, TSF_HDPOS,	/* H axis current and desired position */
+    TSF_DCPOS, TSF_DDPOS,	/* D axis */
+    TSF_RCPOS, TSF_RDPOS,	/* rotator */
+    TSF_HRAW, TSF_DRAW, TSF_RRAW, /* raw counts from home */
+
+    TSF_RERR,			/* rotator less field angle */
+    TSF_XTQ, TSF_XTUNDER,	/* xtrack queue depth and underruns */
+
+    TSF_TEMP,			/* air temperature, millidegrees C */
+    TSF_PRESSURE,		/* air pressure, microbars */
+
+    TSF_NW			/* words in a frame */
+} TSFWord;
+
+#define	TSF_NMASK	((TSF_NW + 31)/32)	/* words of delta bits */
+#define	TSF_MAXBYTES	(4*(2 + TSF_NMASK + TSF_NW))	/* largest frame */
+
+/* TSF_FLAGS bits */
+#define	TSF_JOGGING	0x1		/* jogging_ison */
+#define	TSF_MHAVE(m)	(0x10 << 4*(m))	/* motor m is present */
+#define	TSF_MHOMED(m)	(0x20 << 4*(m))	/* motor m has been homed */
+#define	TSF_MHOMING(m)	(0x40 << 4*(m))	/* motor m is homing */
+#define	TSF_MLIMITING(m) (0x80 << 4*(m)) /* motor m is finding limits */
+
+/* convert an angle word to rads */
+#define	TSF_RAD(w)	((w)*(PI/(180.*3600.*1000.)))
+
+/* telstatframe.c */
+extern void tsfFill (TelStatShm *tsp, int w[TSF_NW]);
+extern int tsfKey (int w[TSF_NW], unsigned seq, char buf[TSF_MAXBYTES]);
+extern int tsfDelta (int prev[TSF_NW], int w[TSF_NW], unsigned seq,
+    char buf[TSF_MAXBYTES]);
+extern int tsfApply (char *buf, int n, int w[TSF_NW], unsigned *seqp);
+extern double tsfMJD (int w[TSF_NW]);
+
+#endif // TELSTATFRAME_H
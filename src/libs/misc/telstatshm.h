@@ -91,6 +91,17 @@ typedef enum {
     TS_LIMITING			/* finding limit positions */
 } TelState;
 
+/* summary of one stage of the telescoped control loop, see prof.c.
+ * N.B. prof[] is in the order of ProfStage in teled.h
+ */
+#define	TEL_NPROF	8
+typedef struct {
+    int n;			/* times seen since reset */
+    double mean;		/* mean, secs */
+    double p99;			/* 99th percentile, secs, to within 2x */
+    double max;			/* longest, secs */
+} ProfInfo;
+
 /* current state of everything.
  * H refers to the telescope axis of "longitude", be it HA or Az.
  * D refers to the telescope axis of "latitude", be it Dec or Alt.
@@ -128,6 +139,19 @@ typedef struct {
     TelState telstate;		/* telescope state */
     int telstateidx;
     int jogging_ison;	/* currently jogged/jogging from target */
+
+    /* xtrack streaming */
+    int xtqdepth;		/* xpos points queued past controller clock */
+    int xtunderrun;		/* times the queue ran dry this track */
+    double xtlatency;		/* smoothed csimcd round trip, secs */
+    double xthorizon;		/* secs of xpos being kept queued */
+
+    /* field derotation */
+    double Rerr;		/* rotator less field angle, rads */
+    double Rdt;			/* secs between rotator profile points */
+
+    /* control loop timing */
+    ProfInfo prof[TEL_NPROF];
 } TelStatShm;
 
 /* handy shortcuts that check things for being ready for normal observing */
@@ -157,6 +181,14 @@ extern void tel_hadec2PA (double H, double D, TelAxes *tap, double latitude,
 extern void tel_realxy2ideal (TelAxes *tap, double *Xp, double *Yp);
 extern void tel_ideal2realxy (TelAxes *tap, double *Xp, double *Yp);
 extern int tel_solve_axes (double H[], double D[], double X[], double Y[],
-    int nstars, double ftol, TelAxes *tap, double fitp[]);
+    int flip[], int nstars, double ftol, TelAxes *tap, double fitp[]);
+
+/* slewtime.c */
+extern int tel_readmount (int trace, TelAxes *tap, MotorInfo minfo[]);
+extern int tel_slewxy (TelAxes *tap, MotorInfo minfo[], double ha,
+    double dec, double *xp, double *yp);
+extern double tel_axistime (MotorInfo *mip, double from, double to);
+extern double tel_slewtime (MotorInfo minfo[], double x0, double y0,
+    double x1, double y1);
 
 #endif // TELSTATSHM_H
@@ -0,0 +1,190 @@
+/* a small work-stealing thread pool to spread a loop over several cpus.
+ *
+ * ws_run() splits [0,n) evenly among nthr workers. each works through its
+ * own range from the bottom in chunks of grain. when it runs dry it steals
+ * the top half of whichever other range has the most left, so a worker that
+ * drew cheap items helps out the ones that did not.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "wspool.h"
+
+typedef struct {
+    pthread_mutex_t lock;
+    int lo, hi;			/* what is left: [lo,hi) */
+} WSRange;
+
+typedef struct {
+    WSRange *r;			/* one range per worker */
+    int nthr;			/* n workers */
+    int grain;			/* items per call to fp */
+    WSFunc fp;			/* work function */
+    void *arg;			/* passed to fp */
+} WSPool;
+
+typedef struct {
+    WSPool *pp;
+    int me;			/* index into pp->r */
+    pthread_t tid;
+} WSWorker;
+
+static void *ws_worker (void *vp);
+static int ws_take (WSRange *rp, int grain, int *lop, int *hip);
+static int ws_steal (WSPool *pp, int me);
+
+/* call fp(arg, lo, hi) over all of [0,n) using nthr threads.
+ * fp must be safe to run from several threads at once.
+ * return 0 if ok, else -1 if threads could not be started, in which case
+ * all the work was done in the calling thread.
+ */
+int
+ws_run (int nthr, int n, int grain, WSFunc fp, void *arg)
+{
+	WSWorker *wp;
+	WSPool pool;
+	int i, ret = 0;
+
+	if (n <= 0)
+	    return (0);
+	if (grain < 1)
+	    grain = 1;
+	if (nthr < 1)
+	    nthr = 1;
+	if (nthr > (n+grain-1)/grain)
+	    nthr = (n+grain-1)/grain;
+	if (nthr == 1) {
+	    (*fp) (arg, 0, n);
+	    return (0);
+	}
+
+	pool.r = (WSRange *) calloc (nthr, sizeof(WSRange));
+	wp = (WSWorker *) calloc (nthr, sizeof(WSWorker));
+	if (!pool.r || !wp) {
+	    if (pool.r) free ((char *)pool.r);
+	    if (wp) free ((char *)wp);
+	    (*fp) (arg, 0, n);
+	    return (-1);
+	}
+	pool.nthr = nthr;
+	pool.grain = grain;
+	pool.fp = fp;
+	pool.arg = arg;
+	for (i = 0; i < nthr; i++) {
+	    pthread_mutex_init (&pool.r[i].lock, NULL);
+	    pool.r[i].lo = (int)((double)n*i/nthr);
+	    pool.r[i].hi = (int)((double)n*(i+1)/nthr);
+	}
+
+	/* worker 0 is us */
+	for (i = 1; i < nthr; i++) {
+	    wp[i].pp = &pool;
+	    wp[i].me = i;
+	    if (pthread_create (&wp[i].tid, NULL, ws_worker, &wp[i]) != 0) {
+		wp[i].pp = NULL;	/* others will steal its share */
+		ret = -1;
+	    }
+	}
+	wp[0].pp = &pool;
+	wp[0].me = 0;
+	(void) ws_worker (&wp[0]);
+
+	for (i = 1; i < nthr; i++)
+	    if (wp[i].pp)
+		pthread_join (wp[i].tid, NULL);
+
+	for (i = 0; i < nthr; i++)
+	    pthread_mutex_destroy (&pool.r[i].lock);
+	free ((char *)pool.r);
+	free ((char *)wp);
+	return (ret);
+}
+
+/* thread body: drain our own range, then keep stealing until all are dry */
+static void *
+ws_worker (void *vp)
+{
+	WSWorker *wp = (WSWorker *) vp;
+	WSPool *pp = wp->pp;
+	WSRange *rp = &pp->r[wp->me];
+	int lo, hi;
+
+	do {
+	    while (ws_take (rp, pp->grain, &lo, &hi) == 0)
+		(*pp->fp) (pp->arg, lo, hi);
+	} while (ws_steal (pp, wp->me) == 0);
+
+	return (NULL);
+}
+
+/* take the next chunk of at most grain off the bottom of *rp.
+ * return 0 if got some, else -1 if *rp is empty.
+ */
+static int
+ws_take (WSRange *rp, int grain, int *lop, int *hip)
+{
+	int ret = -1;
+
+	pthread_mutex_lock (&rp->lock);
+	if (rp->lo < rp->hi) {
+	    *lop = rp->lo;
+	    rp->lo += grain;
+	    if (rp->lo > rp->hi)
+		rp->lo = rp->hi;
+	    *hip = rp->lo;
+	    ret = 0;
+	}
+	pthread_mutex_unlock (&rp->lock);
+	return (ret);
+}
+
+/* move the top half of the fullest other range into ours.
+ * return 0 if found something, else -1 if there is nothing left anywhere.
+ */
+static int
+ws_steal (WSPool *pp, int me)
+{
+	WSRange *mrp = &pp->r[me];
+
+	while (1) {
+	    WSRange *vrp = NULL;
+	    int i, most = 0;
+
+	    /* find the fullest; it may change before we get back to it */
+	    for (i = 0; i < pp->nthr; i++) {
+		WSRange *rp = &pp->r[i];
+		int left;
+
+		if (i == me)
+		    continue;
+		pthread_mutex_lock (&rp->lock);
+		left = rp->hi - rp->lo;
+		pthread_mutex_unlock (&rp->lock);
+		if (left > most) {
+		    most = left;
+		    vrp = rp;
+		}
+	    }
+	    if (!vrp)
+		return (-1);
+
+	    pthread_mutex_lock (&vrp->lock);
+	    if (vrp->hi > vrp->lo) {
+		int mid = vrp->hi - (vrp->hi - vrp->lo + 1)/2;
+		int hi = vrp->hi;
+
+		vrp->hi = mid;
+		pthread_mutex_unlock (&vrp->lock);
+
+		pthread_mutex_lock (&mrp->lock);
+		mrp->lo = mid;
+		mrp->hi = hi;
+		pthread_mutex_unlock (&mrp->lock);
+		return (0);
+	    }
+	    pthread_mutex_unlock (&vrp->lock);
+	}
+}
@@ -0,0 +1,5 @@
+/* include file for the work-stealing thread pool */
+
+typedef void (*WSFunc)(void *arg, int lo, int hi);
+
+extern int ws_run (int nthr, int n, int grain, WSFunc fp, void *arg);
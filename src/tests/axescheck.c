@@ -0,0 +1,133 @@
+/* check tel_solve_axes() of telaxes.c.
+ *
+ * stars all over the sky, on both sides of the pier, are put at the encoder
+ * values a scope with known axes would read for them, as ptmodel does, then
+ * placed exactly where tel_xy2hadec() says those are. none are near the
+ * pole, where non-perpendicular axes are only undone roughly. solving from
+ * a guess that is off must find those axes again, fit every star, and leave
+ * all of the guess but the axes as it was.
+ * done for a german equatorial, given the side each star was seen on, and
+ * for a fork.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "telstatshm.h"
+
+#define	MAXSTARS	200		/* room for this many */
+#define	FTOL		1e-12		/* solver tolerance */
+#define	AXTOL		1e-7		/* most error in each axis, rads */
+#define	FITTOL		1e-7		/* most error of each star, rads */
+
+static int nbad;
+
+static void solve1 (char *name, int germeq);
+static void check (int ok, char *what, double got, double want);
+
+int
+main (int ac, char *av[])
+{
+	solve1 ("german eq", 1);
+	solve1 ("fork", 0);
+	return (nbad ? 1 : 0);
+}
+
+/* make up stars for a scope, solve its axes, and check them */
+static void
+solve1 (char *name, int germeq)
+{
+	static double H[MAXSTARS], D[MAXSTARS], X[MAXSTARS], Y[MAXSTARS];
+	static double fitp[MAXSTARS];
+	static int F[MAXSTARS];
+	TelAxes truth, guess, tax;
+	char what[128];
+	double worst = 0;
+	int i, n = 0, nflip = 0;
+	double h, d;
+
+	memset (&truth, 0, sizeof(truth));
+	truth.GERMEQ = germeq;
+	truth.HT = degrad(0.05);
+	truth.DT = degrad(89.9);
+	truth.XP = degrad(10.0);
+	truth.YC = degrad(20.0);
+	truth.NP = degrad(0.03);
+	truth.R0 = 1.25;
+	truth.hneglim = -PI;
+	truth.hposlim = 0;
+
+	/* stars across the sky */
+	for (h = -5.5; h <= 5.5; h += 1.0)
+	    for (d = -30; d <= 80; d += 22)
+		if (n < MAXSTARS) {
+		    H[n] = hrrad(h);
+		    D[n++] = degrad(d);
+		}
+	for (i = 0; i < n; i++) {
+	    tax = truth;
+	    tel_hadec2xy (H[i], D[i], &tax, &X[i], &Y[i]);
+	    tel_xy2hadec (X[i], Y[i], &tax, &H[i], &D[i]);
+	    tel_ideal2realxy (&tax, &X[i], &Y[i]);
+	    F[i] = tax.GERMEQ_FLIP;
+	    if (F[i])
+		nflip++;
+	}
+	if (germeq) {
+	    sprintf (what, "%s stars on each side", name);
+	    check (nflip > 0 && nflip < n, what, nflip, n/2);
+	}
+
+	/* a guess off in every axis, flipped as no star need be */
+	guess = truth;
+	guess.HT += degrad(0.1);
+	guess.DT -= degrad(0.1);
+	guess.XP -= degrad(0.5);
+	guess.YC += degrad(0.5);
+	guess.NP = 0;
+	guess.GERMEQ_FLIP = germeq;
+	tax = guess;
+
+	sprintf (what, "%s solves", name);
+	check (tel_solve_axes (H, D, X, Y, germeq ? F : NULL, n, FTOL, &tax,
+							    fitp) == 0, what, 0, 0);
+	sprintf (what, "%s HT", name);
+	check (fabs(tax.HT - truth.HT) < AXTOL, what, tax.HT, truth.HT);
+	sprintf (what, "%s DT", name);
+	check (fabs(tax.DT - truth.DT) < AXTOL, what, tax.DT, truth.DT);
+	sprintf (what, "%s XP", name);
+	check (fabs(tax.XP - truth.XP) < AXTOL, what, tax.XP, truth.XP);
+	sprintf (what, "%s YC", name);
+	check (fabs(tax.YC - truth.YC) < AXTOL, what, tax.YC, truth.YC);
+	sprintf (what, "%s NP", name);
+	check (fabs(tax.NP - truth.NP) < AXTOL, what, tax.NP, truth.NP);
+
+	for (i = 0; i < n; i++)
+	    if (fitp[i] > worst)
+		worst = fitp[i];
+	sprintf (what, "%s worst star, rads", name);
+	check (worst < FITTOL, what, worst, 0);
+
+	/* all but the axes as they were */
+	sprintf (what, "%s rest of guess left alone", name);
+	check (tax.GERMEQ == guess.GERMEQ && tax.ZENFLIP == guess.ZENFLIP
+		&& tax.GERMEQ_FLIP == guess.GERMEQ_FLIP && tax.R0 == guess.R0
+		&& tax.hneglim == guess.hneglim && tax.hposlim == guess.hposlim,
+								what, 0, 0);
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.10g (want %.10g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
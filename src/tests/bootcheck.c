@@ -0,0 +1,286 @@
+/* check how csimc -l loads the scripts of each node, as in boot.c.
+ *
+ * the csimc program, named by the only arg, is run four times against a
+ * fake csimcd and two nodes on a private local socket. the nodes keep their
+ * cfgst<i> stamps between runs as real ones do until rebooted, and count
+ * each script as it runs. node 0 never changes. node 1 is loaded, left
+ * alone when nothing changed, sent a changed second script over a link that
+ * drops part way, then sent its first version again. that must be loaded
+ * again along with every script after it, not taken to be there already.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "csimc.h"
+
+#define	PORT		(CSIMCPORT+1001)	/* private port, Unix socket */
+#define	HADDR		40			/* host addr we hand out */
+#define	NSCR		3			/* scripts on each node */
+#define	MAXCONN		8			/* most connections at once */
+#define	RUNWT		20			/* most secs for one run */
+
+/* one connection from csimc */
+typedef struct {
+    int fd;			/* connection, or -1 */
+    int addr;			/* node, once the preamble is in */
+    char buf[4096];		/* statements not yet done */
+    int n;			/* bytes in buf */
+} Conn;
+
+static unsigned stamp[2][NSCR];	/* each node's cfgst<i> */
+static int ran[2][NSCR];	/* times each node ran each script */
+static char dir[] = "/tmp/bootcheckXXXXXX";
+static int nbad;
+
+static void writeFile (char *fn, char *text);
+static void run (char *csimc, int lfd, char *cfg);
+static int serve (Conn *cp);
+static int statement (Conn *cp, char *s);
+static void check (int ok, char *what, double got, double want);
+
+int
+main (int ac, char *av[])
+{
+	char cfg[64], text[256];
+	int lfd, i;
+
+	if (ac != 2) {
+	    fprintf (stderr, "Usage: %s path-to-csimc\n", av[0]);
+	    return (1);
+	}
+	signal (SIGPIPE, SIG_IGN);
+	lfd = csimcd_ulisten (PORT);
+	if (lfd < 0 || !mkdtemp (dir)) {
+	    perror ("bootcheck");
+	    return (1);
+	}
+
+	sprintf (cfg, "%s/csimc.cfg", dir);
+	sprintf (text, "INIT0 = \"%s/a.cmc\"\nINIT1 = \"%s/a.cmc %s/b.cmc "
+					"%s/c.cmc\"\n", dir, dir, dir, dir);
+	writeFile (cfg, text);
+	writeFile ("a.cmc", "s0;\n");
+	writeFile ("b.cmc", "s1;\n");
+	writeFile ("c.cmc", "s2;\n");
+
+	/* first load sends all */
+	run (av[1], lfd, cfg);
+	check (ran[0][0] == 1, "node 0 first load", ran[0][0], 1);
+	for (i = 0; i < NSCR; i++)
+	    check (ran[1][i] == 1 && stamp[1][i] != 0, "node 1 first load",
+								ran[1][i], 1);
+
+	/* nothing changed, nothing sent */
+	run (av[1], lfd, cfg);
+	check (ran[0][0] == 1 && ran[1][0] == 1 && ran[1][1] == 1
+		&& ran[1][2] == 1, "nothing sent when unchanged", ran[1][1], 1);
+
+	/* b changes, and the link drops while it loads */
+	writeFile ("b.cmc", "s1;fail;\n");
+	run (av[1], lfd, cfg);
+	check (ran[1][0] == 1, "script before the change left", ran[1][0], 1);
+	check (ran[1][1] == 2, "changed script sent", ran[1][1], 2);
+	check (stamp[1][0] != 0, "stamp before the change kept", 0, 0);
+	check (stamp[1][1] == 0, "stamp of changed script cleared",
+							    stamp[1][1], 0);
+	check (stamp[1][2] == 0, "stamp of script after cleared",
+							    stamp[1][2], 0);
+
+	/* b back as it was: it and c must be sent again */
+	writeFile ("b.cmc", "s1;\n");
+	run (av[1], lfd, cfg);
+	check (ran[1][0] == 1, "first script still left", ran[1][0], 1);
+	check (ran[1][1] == 3, "old script sent again", ran[1][1], 3);
+	check (ran[1][2] == 2, "script after it sent again", ran[1][2], 2);
+	check (stamp[1][1] != 0 && stamp[1][2] != 0, "stamps set again", 0, 0);
+	check (ran[0][0] == 1, "node 0 left alone throughout", ran[0][0], 1);
+
+	sprintf (text, "rm -rf %s", dir);
+	if (system (text) != 0)
+	    fprintf (stderr, "%s: could not remove\n", dir);
+	return (nbad ? 1 : 0);
+}
+
+/* write text to fn in dir, or exit */
+static void
+writeFile (char *fn, char *text)
+{
+	char path[128];
+	FILE *fp;
+
+	if (fn[0] != '/')
+	    sprintf (path, "%s/%s", dir, fn);
+	else
+	    strcpy (path, fn);
+	fp = fopen (path, "w");
+	if (!fp || fputs (text, fp) < 0 || fclose (fp) != 0) {
+	    perror (path);
+	    exit (1);
+	}
+}
+
+/* run csimc -l with config file cfg, being csimcd and the nodes on lfd until
+ * it exits and all it sent has been seen.
+ */
+static void
+run (char *csimc, int lfd, char *cfg)
+{
+	Conn conn[MAXCONN];
+	char port[16];
+	double t0 = time (NULL);
+	int done = 0, nconn = 0;
+	int i;
+	pid_t pid;
+
+	for (i = 0; i < MAXCONN; i++)
+	    conn[i].fd = -1;
+
+	sprintf (port, "%d", PORT);
+	pid = fork();
+	if (pid == 0) {
+	    int nfd = open ("/dev/null", O_RDWR);
+	    dup2 (nfd, 0);
+	    dup2 (nfd, 1);
+	    close (lfd);
+	    execl (csimc, csimc, "-i", "127.0.0.1", port, "-c", cfg, "-l",
+								(char *)NULL);
+	    perror (csimc);
+	    _exit (1);
+	}
+
+	while (!done || nconn > 0) {
+	    struct timeval tv;
+	    fd_set rs;
+	    int maxfd = lfd;
+
+	    if (time (NULL) - t0 > RUNWT) {
+		check (0, "csimc finished, secs", time (NULL) - t0, RUNWT);
+		kill (pid, SIGKILL);
+		exit (1);
+	    }
+	    if (!done && waitpid (pid, NULL, WNOHANG) == pid)
+		done = 1;
+
+	    FD_ZERO (&rs);
+	    FD_SET (lfd, &rs);
+	    for (i = 0; i < MAXCONN; i++)
+		if (conn[i].fd >= 0) {
+		    FD_SET (conn[i].fd, &rs);
+		    if (conn[i].fd > maxfd)
+			maxfd = conn[i].fd;
+		}
+	    tv.tv_sec = 0;
+	    tv.tv_usec = 100000;
+	    if (select (maxfd+1, &rs, NULL, NULL, &tv) <= 0)
+		continue;
+
+	    if (FD_ISSET (lfd, &rs)) {
+		for (i = 0; i < MAXCONN && conn[i].fd >= 0; i++)
+		    continue;
+		if (i == MAXCONN) {
+		    check (0, "connections at once", MAXCONN+1, MAXCONN);
+		    exit (1);
+		}
+		conn[i].fd = csimcd_saccept (lfd);
+		conn[i].addr = -1;
+		conn[i].n = 0;
+		nconn++;
+	    }
+	    for (i = 0; i < MAXCONN; i++)
+		if (conn[i].fd >= 0 && FD_ISSET (conn[i].fd, &rs)
+						    && serve (&conn[i]) < 0) {
+		    close (conn[i].fd);
+		    conn[i].fd = -1;
+		    nconn--;
+		}
+	}
+}
+
+/* read more from cp and do each whole statement.
+ * return 0 to keep going, -1 to close.
+ */
+static int
+serve (Conn *cp)
+{
+	char *s, *semi;
+	int n;
+
+	n = read (cp->fd, cp->buf + cp->n, sizeof(cp->buf) - 1 - cp->n);
+	if (n <= 0)
+	    return (-1);
+	cp->n += n;
+
+	/* the preamble, then reply with the host addr */
+	if (cp->addr < 0) {
+	    Byte h = HADDR;
+
+	    if (cp->n < 3)
+		return (0);
+	    if (cp->buf[0] < 0 || cp->buf[0] > 1 || cp->buf[1] != FOR_SHELL
+						    || write (cp->fd, &h, 1) != 1)
+		return (-1);
+	    cp->addr = cp->buf[0];
+	    cp->n -= 3;
+	    memmove (cp->buf, cp->buf + 3, cp->n);
+	}
+
+	cp->buf[cp->n] = '\0';
+	for (s = cp->buf; (semi = strchr (s, ';')) != NULL; s = semi + 1) {
+	    *semi = '\0';
+	    if (statement (cp, s) < 0)
+		return (-1);
+	}
+	cp->n -= s - cp->buf;
+	memmove (cp->buf, s, cp->n);
+	return (0);
+}
+
+/* do statement s from cp as its node would.
+ * return 0 if ok, -1 if the link drops.
+ */
+static int
+statement (Conn *cp, char *s)
+{
+	unsigned *st = stamp[cp->addr];
+	char reply[32];
+	unsigned v;
+	int i;
+
+	while (*s == ' ' || *s == '\n' || *s == '\t')
+	    s++;
+	if (!strcmp (s, "fail"))
+	    return (-1);
+	if (sscanf (s, "=cfgst%d", &i) == 1 && i >= 0 && i < NSCR)
+	    sprintf (reply, "%u\n", st[i]);
+	else if (!strcmp (s, "=version"))
+	    strcpy (reply, "1\n");
+	else {
+	    if (sscanf (s, "cfgst%d=%u", &i, &v) == 2 && i >= 0 && i < NSCR)
+		st[i] = v;
+	    else if (sscanf (s, "s%d", &i) == 1 && i >= 0 && i < NSCR)
+		ran[cp->addr][i]++;
+	    return (0);
+	}
+	if (write (cp->fd, reply, strlen(reply)) < 0)
+	    return (-1);
+	return (0);
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.10g (want %.10g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
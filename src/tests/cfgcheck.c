@@ -0,0 +1,152 @@
+/* check the config file cache of configfile.c and the snapshots taken of it,
+ * as reload.c compares them.
+ *
+ * a file is written, read and snapped, then written again with one entry
+ * changed, one gone and one new, and snapped again. the first snapshot must
+ * still hold the old pairs after the file is parsed again and after it is
+ * forgotten, and comparing the two both ways must find just the three names.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "configfile.h"
+
+static char fn[] = "/tmp/cfgcheckXXXXXX";
+static int nbad;
+
+static void writeFile (char *text);
+static int count1 (char *name, char *value, void *arg);
+static int diff1 (char *name, char *value, void *arg);
+static void check (int ok, char *what, double got, double want);
+
+/* compare with, as diff1() is given it */
+typedef struct {
+    CfgSnap *other;		/* snapshot to look each name up in */
+    int gone;			/* set if only names not in other count */
+    char names[256];		/* " name" of each that counts */
+} Diff;
+
+int
+main (int ac, char *av[])
+{
+	CfgSnap *was, *now;
+	Diff d;
+	int fd, n, ival;
+	double dval;
+
+	fd = mkstemp (fn);
+	if (fd < 0) {
+	    perror (fn);
+	    return (1);
+	}
+	close (fd);
+
+	/* the first version, read one way then another */
+	writeFile ("! a comment\nTRACKINT 5\nPTGRAD = 1.5  # another\n"
+		    "LATITUDE -0.43\nSITE \"two words\"\ntrackint 6\n");
+	ival = 0;
+	(void) read1CfgEntry (0, fn, "TRACKINT", CFG_INT, &ival, 0);
+	check (ival == 6, "last of a name, any case", ival, 6);
+	check (cfgDbl (fn, "PTGRAD", 0) == 1.5, "cfgDbl", cfgDbl (fn, "PTGRAD",
+								    0), 1.5);
+	check (cfgInt (fn, "NOSUCH", -9) == -9, "missing name", -9, -9);
+	was = cfgSnap (fn);
+	check (was != NULL, "snapshot", 0, 0);
+	if (!was)
+	    return (1);
+	n = 0;
+	(void) cfgSnapEach (was, count1, &n);
+	check (n == 4, "pairs in snapshot", n, 4);
+	check (!strcmp (cfgSnapValue (was, "Site"), "two words"),
+					    "quoted value", 0, 0);
+
+	/* the second, one changed, one gone and one new */
+	writeFile ("TRACKINT 6\nPTGRAD = 2.25\nSITE \"two words\"\n"
+							"XTRACKJIT 1\n");
+	check (cfgDbl (fn, "PTGRAD", 0) == 2.25, "file read again",
+					cfgDbl (fn, "PTGRAD", 0), 2.25);
+	now = cfgSnap (fn);
+	check (now != NULL && now != was, "second snapshot", 0, 0);
+	if (!now)
+	    return (1);
+	check (atof (cfgSnapValue (was, "PTGRAD")) == 1.5,
+			"old snapshot kept after reading again",
+			atof (cfgSnapValue (was, "PTGRAD")), 1.5);
+	cfgForget (fn);
+	check (cfgSnapValue (was, "LATITUDE") != NULL
+				&& cfgSnapValue (now, "LATITUDE") == NULL,
+				"snapshots kept after forgetting", 0, 0);
+
+	/* both ways, as reload.c does */
+	memset (&d, 0, sizeof(d));
+	d.other = was;
+	(void) cfgSnapEach (now, diff1, &d);
+	d.other = now;
+	d.gone = 1;
+	(void) cfgSnapEach (was, diff1, &d);
+	n = 0;
+	n += strstr (d.names, " PTGRAD") != NULL;
+	n += strstr (d.names, " LATITUDE") != NULL;
+	n += strstr (d.names, " XTRACKJIT") != NULL;
+	check (n == 3 && strlen (d.names) == strlen (" PTGRAD LATITUDE "
+		    "XTRACKJIT"), "names that differ", n, 3);
+	printf ("     differ:%s\n", d.names);
+
+	cfgSnapFree (was);
+	cfgSnapFree (now);
+	cfgSnapFree (NULL);
+	dval = cfgDbl (fn, "PTGRAD", 0);
+	check (dval == 2.25, "read after freeing", dval, 2.25);
+	unlink (fn);
+	check (cfgSnap (fn) == NULL, "no snapshot of missing file", 0, 0);
+
+	return (nbad ? 1 : 0);
+}
+
+/* write text as all of fn, or exit */
+static void
+writeFile (char *text)
+{
+	FILE *fp = fopen (fn, "w");
+
+	if (!fp || fputs (text, fp) < 0 || fclose (fp) != 0) {
+	    perror (fn);
+	    exit (1);
+	}
+}
+
+/* cfgSnapEach() function to count pairs in *(int *)arg */
+static int
+count1 (char *name, char *value, void *arg)
+{
+	(*(int *)arg)++;
+	return (0);
+}
+
+/* cfgSnapEach() function to note name if it differs in the other snapshot,
+ * or if only gone ones count and it is not there at all.
+ */
+static int
+diff1 (char *name, char *value, void *arg)
+{
+	Diff *dp = (Diff *)arg;
+	char *other = cfgSnapValue (dp->other, name);
+
+	if (dp->gone ? other == NULL : !other || strcmp (other, value))
+	    sprintf (dp->names + strlen(dp->names), " %s", name);
+	return (0);
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.10g (want %.10g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
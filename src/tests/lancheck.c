@@ -0,0 +1,187 @@
+/* check how csimcd finds packets in the bytes it reads from the CSIMC LAN,
+ * using lanring.c.
+ *
+ * packets and tokens are fed into the ring in pieces of every size, with
+ * junk, node tokens, damaged packets and packets cut short mixed in, for
+ * long enough that the ring wraps many times. every good packet must come
+ * out whole and in order, everything else must be skipped and counted, and
+ * BROKTOK must be reported. what csimcd would log about the damage is
+ * thrown away.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "csimc.h"
+#include "csimcstats.h"
+#include "lanring.h"
+
+#define	NROUNDS		2000		/* rounds of the mix to send */
+
+static LanRing lan;
+static CSIMCStats stats;
+static Byte sent[4*NROUNDS][PMXLEN];	/* good packets, in order */
+static int sentlen[4*NROUNDS];		/* length of each */
+static int nsent, ngot, nwrong;		/* n sent, found, found wrong */
+static int nbrok;			/* BROKTOKs sent less those found */
+static int nbad;
+
+static int mkPkt (Byte pkt[PMXLEN], int to, int fr, int count, int seed);
+static void sendGood (Byte *p, int n, int piece);
+static void feed (Byte *p, int n, int piece);
+static void drain (void);
+static void check (int ok, char *what, double got, double want);
+
+int
+main (int ac, char *av[])
+{
+	Byte pkt[PMXLEN], junk[3] = {0x01, 0x55, 0xfe};
+	Byte tok[2];
+	int r, len, out;
+
+	lan.css = &stats;
+	fflush (stdout);
+	out = dup (1);
+	dup2 (open ("/dev/null", O_WRONLY), 1);
+
+	for (r = 0; r < NROUNDS; r++) {
+	    int piece = 1 + r % (PMXLEN + 3);
+
+	    /* a good packet with data and one without */
+	    len = mkPkt (pkt, 40 + r%20, r%32, 1 + r%PMXDAT, r);
+	    sendGood (pkt, len, piece);
+	    len = mkPkt (pkt, 40, r%32, 0, r);
+	    sendGood (pkt, len, piece);
+
+	    /* junk, a node token, and sometimes BROKTOK */
+	    feed (junk, 1 + r%3, piece);
+	    tok[0] = PSYNC;
+	    tok[1] = addr2tok(r%32);
+	    feed (tok, 2, piece);
+	    if (r % 7 == 0) {
+		tok[1] = BROKTOK;
+		feed (tok, 2, piece);
+		nbrok++;
+	    }
+
+	    /* a packet with a bad header, one with bad data, one cut short */
+	    len = mkPkt (pkt, 40, 3, 10, r);
+	    pkt[PB_HCHK] = pkt[PB_HCHK] == 1 ? 2 : 1;
+	    feed (pkt, len, piece);
+	    len = mkPkt (pkt, 40, 3, 10, r);
+	    pkt[PB_DATA+4] ^= 0x01;
+	    feed (pkt, len, piece);
+	    len = mkPkt (pkt, 40, 3, 10, r);
+	    feed (pkt, len - 4, piece);
+	}
+	fflush (stdout);
+	dup2 (out, 1);
+
+	check (ngot == nsent, "good packets found", ngot, nsent);
+	check (nwrong == 0, "packets found whole and in order", nwrong, 0);
+	check (nbrok == 0, "BROKTOKs reported missing", nbrok, 0);
+	check (lan.head > 8*LANBUFSZ, "ring wrapped, times", lan.head/LANBUFSZ,
+									8);
+	check (LANN(&lan) < PB_NZHSZ + 10, "bytes left in ring", LANN(&lan), 0);
+	check (stats.node[CSS_NOADDR].hchkerrs == NROUNDS, "bad headers",
+			stats.node[CSS_NOADDR].hchkerrs, NROUNDS);
+	check (stats.node[3].dchkerrs == NROUNDS, "bad data",
+					stats.node[3].dchkerrs, NROUNDS);
+	check (stats.node[3].resyncs == NROUNDS - 1, "packets cut short",
+				    stats.node[3].resyncs, NROUNDS - 1);
+	check (stats.lanjunk >= NROUNDS, "junk bytes skipped", stats.lanjunk,
+									NROUNDS);
+
+	return (nbad ? 1 : 0);
+}
+
+/* build a packet in pkt[] with count bytes of data from seed.
+ * return its length.
+ */
+static int
+mkPkt (Byte pkt[PMXLEN], int to, int fr, int count, int seed)
+{
+	int i;
+
+	pkt[PB_SYNC] = PSYNC;
+	pkt[PB_TO] = to;
+	pkt[PB_FR] = fr;
+	pkt[PB_INFO] = PT_SHELL | (seed & 0xf) << PSQ_SHIFT;
+	pkt[PB_COUNT] = count;
+	pkt[PB_HCHK] = chkSum (pkt, PB_NHCHK);
+	if (!count)
+	    return (PB_HSZ);
+	for (i = 0; i < count; i++) {
+	    pkt[PB_DATA+i] = (seed*7 + i*13) & 0xff;
+	    if ((pkt[PB_DATA+i] & ~1) == PSYNC)	/* not even if damaged */
+		pkt[PB_DATA+i] = PESC;
+	}
+	pkt[PB_DCHK] = chkSum (&pkt[PB_DATA], count);
+	return (PB_NZHSZ + count);
+}
+
+/* feed good packet p[n] and note it should come out again */
+static void
+sendGood (Byte *p, int n, int piece)
+{
+	memcpy (sent[nsent], p, n);
+	sentlen[nsent++] = n;
+	feed (p, n, piece);
+}
+
+/* put p[n] in the ring as if read piece bytes at a time, decoding all we
+ * can after each, just as csimcd does.
+ */
+static void
+feed (Byte *p, int n, int piece)
+{
+	while (n > 0) {
+	    int room, m = n < piece ? n : piece;
+	    Byte *bp = lanSpace (&lan, &room);
+
+	    if (room == 0) {
+		check (0, "ring full", LANN(&lan), LANBUFSZ);
+		exit (1);
+	    }
+	    if (m > room)
+		m = room;
+	    memcpy (bp, p, m);
+	    lan.tail += m;
+	    p += m;
+	    n -= m;
+	    drain();
+	}
+}
+
+/* take all we can out of the ring, checking it against what was sent */
+static void
+drain()
+{
+	Byte got[PMXLEN];
+	int d, n;
+
+	while ((d = lanDecode (&lan, got, &n)) != LD_MORE) {
+	    if (d == LD_BROKTOK) {
+		nbrok--;
+		continue;
+	    }
+	    if (ngot >= nsent || n != sentlen[ngot]
+					    || memcmp (got, sent[ngot], n))
+		nwrong++;
+	    ngot++;
+	}
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.10g (want %.10g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
@@ -0,0 +1,75 @@
+/* check the nutation series of nutation.c.
+ *
+ * nutation() is checked against the worked example in Meeus, Astronomical
+ * Algorithms, 22.a, then nutation_n() is checked to give just what
+ * nutation() does, and with fast set to stay within NUT_TOL of that over
+ * a day of epochs, for many days.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+
+#define	NUT_TOL		5e-4		/* fast mode tolerance, arcsec */
+#define	NEPOCH		49		/* epochs in each day */
+#define	NDAYS		5000		/* days to try */
+
+static int nbad;
+
+static void check (int ok, char *what, double got, double want);
+
+int
+main (int ac, char *av[])
+{
+	double deps, dpsi, worst = 0;
+	int d, i;
+
+	/* 1987 Apr 10 0h TD: dpsi -3.788", deps 9.443" */
+	nutation (2446895.5 - MJD0, &deps, &dpsi);
+	check (fabs(raddeg(dpsi)*3600 + 3.788) < 0.001, "Meeus dpsi",
+						raddeg(dpsi)*3600, -3.788);
+	check (fabs(raddeg(deps)*3600 - 9.443) < 0.001, "Meeus deps",
+						raddeg(deps)*3600, 9.443);
+
+	for (d = 0; d < NDAYS; d++) {
+	    double m[NEPOCH], e[NEPOCH], p[NEPOCH], ef[NEPOCH], pf[NEPOCH];
+	    double m0 = 40000 + d*2.37;
+
+	    for (i = 0; i < NEPOCH; i++)
+		m[i] = m0 + (double)i/(NEPOCH-1);
+	    nutation_n (NEPOCH, m, e, p, 0);
+	    nutation_n (NEPOCH, m, ef, pf, 1);
+	    for (i = 0; i < NEPOCH; i++) {
+		double e1, p1, err;
+
+		nutation (m[i], &e1, &p1);
+		if (e1 != e[i] || p1 != p[i]) {
+		    check (0, "nutation_n() same as nutation()", p[i], p1);
+		    return (1);
+		}
+		err = fabs(ef[i] - e[i]);
+		if (fabs(pf[i] - p[i]) > err)
+		    err = fabs(pf[i] - p[i]);
+		if (err > worst)
+		    worst = err;
+	    }
+	}
+	check (raddeg(worst)*3600 <= NUT_TOL, "fast worst error, arcsec",
+					    raddeg(worst)*3600, NUT_TOL);
+
+	return (nbad ? 1 : 0);
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.6g (want %.6g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
@@ -0,0 +1,249 @@
+/* check the tables made by nightplan, named by the only arg.
+ *
+ * a few stars are planned for one night at a made up site with no mount
+ * model, once on one thread and once on several, in a private directory
+ * standing in for TELHOME. the two tables must be the same byte for byte.
+ * every sample of every star is then checked against obj_cir() for that
+ * star at that time: altitude clear of the horizon, airmass, separation
+ * from the moon, the flags, and the first and last samples each may be
+ * observed.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+
+#include "np.h"
+
+#define	MJDAY		"60000"		/* evening to plan, MJD */
+#define	MINALT		25.0		/* lowest altitude, degs */
+#define	MINALTS		"25"		/* same, as an arg */
+#define	ALTTOL		0.02		/* most altitude error, degs */
+#define	SEPTOL		0.02		/* most moon separation error, degs */
+#define	AMTOL		0.005		/* most fractional airmass error */
+
+static char *stars[] = {
+    "Sirius,f|S,6:45:08.9,-16:42:58,-1.4,2000",
+    "Vega,f|S,18:36:56.3,38:47:01,0.0,2000",
+    "Betelgeuse,f|S,5:55:10.3,7:24:25,0.5,2000",
+    "Polaris,f|S,2:31:49.1,89:15:51,2.0,2000",
+    "Canopus,f|S,6:23:57.1,-52:41:45,-0.7,2000",
+    "Regulus,f|S,10:08:22.3,11:58:02,1.4,2000",
+};
+#define	NSTARS	(sizeof(stars)/sizeof(stars[0]))
+
+static char dir[] = "/tmp/plancheckXXXXXX";
+static int nbad;
+
+static void writeFile (char *fn, char *text);
+static char *plan1 (char *nightplan, char *out, char *nthr);
+static long readPlan (char *fn, char **bufp);
+static void checkPlan (char *buf);
+static void check (int ok, char *what, double got, double want);
+
+int
+main (int ac, char *av[])
+{
+	char text[1024], *buf1, *buf4;
+	long n1, n4;
+	int i;
+
+	if (ac != 2) {
+	    fprintf (stderr, "Usage: %s path-to-nightplan\n", av[0]);
+	    return (1);
+	}
+	if (!mkdtemp (dir) || chdir (dir) < 0 || mkdir ("archive", 0777) < 0
+				    || mkdir ("archive/config", 0777) < 0) {
+	    perror (dir);
+	    return (1);
+	}
+	setenv ("TELHOME", dir, 1);
+
+	/* a site on La Palma, and the stars */
+	writeFile ("archive/config/telsched.cfg", "LONGITUDE 0.31206\n"
+		"LATITUDE 0.50195\nTEMPERATURE 10\nPRESSURE 780\n"
+		"ELEVATION 2350\n");
+	text[0] = '\0';
+	for (i = 0; i < NSTARS; i++)
+	    sprintf (text + strlen(text), "%s\n", stars[i]);
+	writeFile ("stars.edb", text);
+
+	n1 = readPlan (plan1 (av[1], "one.np", "1"), &buf1);
+	n4 = readPlan (plan1 (av[1], "four.np", "4"), &buf4);
+	check (n1 == n4 && !memcmp (buf1, buf4, n1), "same on 1 and 4 threads",
+									n4, n1);
+	checkPlan (buf1);
+
+	sprintf (text, "rm -rf %s", dir);
+	if (chdir ("/") < 0 || system (text) != 0)
+	    fprintf (stderr, "%s: could not remove\n", dir);
+	return (nbad ? 1 : 0);
+}
+
+/* write text as all of fn, or exit */
+static void
+writeFile (char *fn, char *text)
+{
+	FILE *fp = fopen (fn, "w");
+
+	if (!fp || fputs (text, fp) < 0 || fclose (fp) != 0) {
+	    perror (fn);
+	    exit (1);
+	}
+}
+
+/* run nightplan on the stars with nthr threads into out, or exit.
+ * return out.
+ */
+static char *
+plan1 (char *nightplan, char *out, char *nthr)
+{
+	int status;
+	pid_t pid;
+
+	pid = fork();
+	if (pid == 0) {
+	    execl (nightplan, nightplan, "-d", MJDAY, "-a", MINALTS, "-j", nthr,
+				    "-o", out, "stars.edb", (char *)NULL);
+	    perror (nightplan);
+	    _exit (1);
+	}
+	if (pid < 0 || waitpid (pid, &status, 0) != pid || !WIFEXITED(status)
+						|| WEXITSTATUS(status) != 0) {
+	    check (0, "nightplan ran", -1, 0);
+	    exit (1);
+	}
+	return (out);
+}
+
+/* read all of fn into a new malloced *bufp, or exit.
+ * return its size.
+ */
+static long
+readPlan (char *fn, char **bufp)
+{
+	FILE *fp = fopen (fn, "r");
+	long n;
+
+	if (!fp || fseek (fp, 0L, SEEK_END) < 0 || (n = ftell (fp)) <= 0) {
+	    perror (fn);
+	    exit (1);
+	}
+	rewind (fp);
+	*bufp = malloc (n);
+	if (!*bufp || fread (*bufp, 1, n, fp) != n) {
+	    perror (fn);
+	    exit (1);
+	}
+	fclose (fp);
+	return (n);
+}
+
+/* check each record of the plan in buf against obj_cir() */
+static void
+checkPlan (char *buf)
+{
+	NPHeader *hp = (NPHeader *)buf;
+	NPSample *sp = (NPSample *)(hp + 1);
+	NPTarget *tp = (NPTarget *)(sp + hp->nsamples);
+	NPRec *rp = (NPRec *)(tp + hp->ntargets);
+	double altworst = 0, sepworst = 0, amworst = 0;
+	int nflags = 0, nfirst = 0;
+	Now now, *np = &now;
+	Obj moon;
+	int t, i;
+
+	check (!strcmp (hp->magic, NP_MAGIC) && hp->version == NP_VERSION,
+					"header", hp->version, NP_VERSION);
+	check (hp->ntargets == NSTARS, "targets", hp->ntargets, NSTARS);
+	check (hp->nsamples > 20, "samples", hp->nsamples, 20);
+	if (hp->ntargets != NSTARS)
+	    return;
+
+	memset (np, 0, sizeof(now));
+	lng = -0.31206;
+	lat = 0.50195;
+	temp = 10;
+	pressure = 780;
+	elev = 2350/ERAD;
+	epoch = EOD;
+	memset (&moon, 0, sizeof(moon));
+	moon.o_type = PLANET;
+	moon.pl.pl_code = MOON;
+
+	for (t = 0; t < NSTARS; t++) {
+	    char line[128], whynot[128];
+	    int first = -1, last = -1;
+	    Obj o;
+
+	    strcpy (line, stars[t]);
+	    memset (&o, 0, sizeof(o));
+	    if (db_crack_line (line, &o, whynot) < 0) {
+		check (0, whynot, t, 0);
+		continue;
+	    }
+	    for (i = 0; i < hp->nsamples; i++) {
+		NPRec *r = &rp[t*hp->nsamples + i];
+		double alt, am, sep, d;
+		int flags;
+
+		mjd = sp[i].smjd;
+		(void) obj_cir (np, &moon);
+		(void) obj_cir (np, &o);
+		alt = o.s_alt;
+		airmass (alt, &am);
+		sep = acos (sin(o.s_dec)*sin(moon.s_dec)
+			    + cos(o.s_dec)*cos(moon.s_dec)*cos(o.s_ra-moon.s_ra));
+
+		d = fabs (r->alt/100. - raddeg(alt));
+		if (alt > degrad(2) && d > altworst)	/* off the horizon */
+		    altworst = d;
+		d = fabs (r->msep/100. - raddeg(sep));
+		if (d > sepworst)
+		    sepworst = d;
+		if (am < 10) {
+		    d = fabs (r->airm/1000. - am)/am;
+		    if (d > amworst)
+			amworst = d;
+		}
+
+		/* flags, away from the edge where rounding may decide */
+		flags = raddeg(alt) >= MINALT ? NP_OK : 0;
+		if (fabs (raddeg(alt) - MINALT) > ALTTOL && r->flags != flags)
+		    nflags++;
+		if (r->flags == NP_OK) {
+		    if (first < 0)
+			first = i;
+		    last = i;
+		}
+	    }
+	    if (tp[t].first != first || tp[t].last != last)
+		nfirst++;
+	}
+
+	check (altworst < ALTTOL, "worst altitude error, degs", altworst, 0);
+	check (amworst < AMTOL, "worst airmass error", amworst, 0);
+	check (sepworst < SEPTOL, "worst moon separation error, degs",
+								sepworst, 0);
+	check (nflags == 0, "samples with wrong flags", nflags, 0);
+	check (nfirst == 0, "targets with wrong first or last", nfirst, 0);
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.10g (want %.10g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
@@ -0,0 +1,116 @@
+/* check the time scale tables of tscale.c.
+ *
+ * GMST and GAST are checked against the worked example in Meeus,
+ * Astronomical Algorithms, 12.a, then each ts_ lookup is checked against
+ * the full computation it stands in for, at many times within the table,
+ * and to fall back to just that outside it.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+
+#define	MJD0TAB		(2460000.5 - MJD0)	/* start of table */
+#define	NDAYS		32			/* days in table */
+#define	NTRY		100000			/* times to try */
+#define	DT_TOL		1e-8			/* DeltaT, secs */
+#define	GMST_TOL	1e-8			/* GMST, secs */
+#define	GAST_TOL	1e-4			/* GAST, secs */
+
+static int nbad;
+
+static void check (int ok, char *what, double got, double want);
+static double full_gast (double mjd);
+static double hrdiff (double a, double b);
+
+int
+main (int ac, char *av[])
+{
+	double m87 = 2446895.5 - MJD0;
+	double edt = 0, egm = 0, ega = 0;
+	double gst, m;
+	int i;
+
+	/* 1987 Apr 10 0h UT: GMST 13h10m46.3668s, GAST 13h10m46.1351s */
+	utc_gst (m87, 0.0, &gst);
+	check (fabs(hrdiff (gst, 13+10/60.+46.3668/3600))*3600 < 0.001,
+				"Meeus GMST, hrs", gst, 13+10/60.+46.3668/3600);
+	gst = full_gast (m87);
+	check (fabs(hrdiff (gst, 13+10/60.+46.1351/3600))*3600 < 0.001,
+				"Meeus GAST, hrs", gst, 13+10/60.+46.1351/3600);
+
+	if (ts_init (MJD0TAB, NDAYS) < 0) {
+	    check (0, "ts_init()", -1, 0);
+	    return (1);
+	}
+
+	srand48 (1);
+	for (i = 0; i < NTRY; i++) {
+	    double e;
+
+	    m = MJD0TAB + drand48()*NDAYS;
+	    e = fabs(ts_deltat (m) - deltat (m));
+	    if (e > edt)
+		edt = e;
+	    utc_gst (mjd_day(m), mjd_hr(m), &gst);
+	    e = fabs(hrdiff (ts_gmst (m), gst))*3600;
+	    if (e > egm)
+		egm = e;
+	    e = fabs(hrdiff (ts_gast (m), full_gast (m)))*3600;
+	    if (e > ega)
+		ega = e;
+	}
+	check (edt <= DT_TOL, "DeltaT worst error, secs", edt, DT_TOL);
+	check (egm <= GMST_TOL, "GMST worst error, secs", egm, GMST_TOL);
+	check (ega <= GAST_TOL, "GAST worst error, secs", ega, GAST_TOL);
+
+	/* outside the table it must be the full computation */
+	m = MJD0TAB + NDAYS + 10.3;
+	check (ts_deltat (m) == deltat (m), "DeltaT outside table",
+						    ts_deltat (m), deltat (m));
+	check (ts_gast (m) == full_gast (m), "GAST outside table",
+						    ts_gast (m), full_gast (m));
+
+	return (nbad ? 1 : 0);
+}
+
+/* GAST at mjd, hours, the long way as now_lst() used to */
+static double
+full_gast (double mjd)
+{
+	double gst, eps, deps, dpsi;
+
+	utc_gst (mjd_day(mjd), mjd_hr(mjd), &gst);
+	obliquity (mjd, &eps);
+	nutation (mjd, &deps, &dpsi);
+	gst += radhr (dpsi*cos(eps+deps));
+	range (&gst, 24.0);
+	return (gst);
+}
+
+/* a - b, hours, allowing for wrap at 24 */
+static double
+hrdiff (double a, double b)
+{
+	double d = fmod (a - b, 24.0);
+
+	if (d > 12)
+	    d -= 24;
+	if (d < -12)
+	    d += 24;
+	return (d);
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.10g (want %.10g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
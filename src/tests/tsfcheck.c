@@ -0,0 +1,143 @@
+/* check the binary status frames of telstatframe.c.
+ *
+ * a minute of equatorial tracking at 10 frames a second is made up, sent as
+ * one key frame then deltas, and decoded again as a client would, byte by
+ * byte where it arrives in pieces. every decoded frame must match what was
+ * sent, and the mean delta must stay within TSF_DTRACK bytes, the figure
+ * given in telstatframe.h. damaged and out of order frames must be refused.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "telstatshm.h"
+#include "telstatframe.h"
+
+#define	RATE		10		/* frames per sec */
+#define	NFRAMES		(60*RATE)	/* frames to send */
+#define	ESTEP		(1<<24)		/* encoder steps per rev */
+#define	TSF_DTRACK	88		/* most mean tracking delta, bytes */
+
+static int nbad;
+
+static void track (TelStatShm *tsp, int i);
+static void check (int ok, char *what, double got, double want);
+
+int
+main (int ac, char *av[])
+{
+	static TelStatShm ts;
+	int sent[TSF_NW], prev[TSF_NW], got[TSF_NW];
+	char buf[TSF_MAXBYTES];
+	unsigned seq = 0;
+	double dsum = 0;
+	int i, n, nmiss = 0;
+
+	ts.now.n_lat = degrad(-24.6);
+	ts.now.n_temp = 12.5;
+	ts.now.n_pressure = 744;
+	ts.telstate = TS_TRACKING;
+	ts.minfo[TEL_HM].have = ts.minfo[TEL_DM].have = 1;
+	ts.minfo[TEL_HM].ishomed = ts.minfo[TEL_DM].ishomed = 1;
+
+	/* key frame, fed in two pieces */
+	track (&ts, 0);
+	tsfFill (&ts, sent);
+	n = tsfKey (sent, seq, buf);
+	check (n == 4*(2 + TSF_NW), "key frame bytes", n, 4*(2 + TSF_NW));
+	check (tsfApply (buf, n-1, got, &seq) == 0, "short key frame waits",
+									0, 0);
+	check (tsfApply (buf, n, got, &seq) == n, "key frame used", n, n);
+	check (!memcmp (got, sent, sizeof(got)), "key frame decodes", 0, 0);
+	check (fabs(tsfMJD(got) - ts.now.n_mjd)*SPD < .001, "key frame mjd",
+						tsfMJD(got), ts.now.n_mjd);
+
+	/* then a delta every frame */
+	for (i = 1; i < NFRAMES; i++) {
+	    int j;
+
+	    memcpy (prev, sent, sizeof(prev));
+	    track (&ts, i);
+	    tsfFill (&ts, sent);
+	    n = tsfDelta (prev, sent, seq + 1, buf);
+	    dsum += n;
+	    for (j = 0; j < n; j++)
+		if (tsfApply (buf, j, got, &seq) != 0)
+		    break;
+	    if (j < n || tsfApply (buf, n, got, &seq) != n
+				    || memcmp (got, sent, sizeof(got)))
+		nmiss++;
+	}
+	check (nmiss == 0, "deltas decode", nmiss, 0);
+	check (dsum/(NFRAMES-1) <= TSF_DTRACK, "mean tracking delta, bytes",
+						dsum/(NFRAMES-1), TSF_DTRACK);
+
+	/* a delta that skips one, and frames that are not ours */
+	n = tsfDelta (prev, sent, seq + 2, buf);
+	check (tsfApply (buf, n, got, &seq) == -1, "delta out of sequence",
+									-1, -1);
+	buf[0] ^= 0x40;
+	check (tsfApply (buf, n, got, &seq) == -1, "bad magic", -1, -1);
+	buf[0] ^= 0x40;
+	buf[3] = 7;
+	check (tsfApply (buf, n, got, &seq) == -1, "unknown frame kind", -1, -1);
+
+	return (nbad ? 1 : 0);
+}
+
+/* set *tsp as if tracking a star through the meridian, i frames on */
+static void
+track (TelStatShm *tsp, int i)
+{
+	MotorInfo *hp = &tsp->minfo[TEL_HM];
+	MotorInfo *dp = &tsp->minfo[TEL_DM];
+	double t = (double)i/RATE;
+	double ha = degrad(-1.0) + t*2*PI/(SPD*SIDRATE);
+	double dec = degrad(-40.0);
+	double phi = tsp->now.n_lat;
+	double alt, az;
+
+	tsp->now.n_mjd = 60000.1 + t/SPD;
+	tsp->Clst = degrad(15*(3.2 + t/(3600*SIDRATE)));
+	tsp->DJ2kRA = tsp->Clst - ha - degrad(.3);
+	tsp->DJ2kDec = dec + degrad(.1);
+
+	/* desired follows the star exactly */
+	tsp->DAHA = ha;
+	hadec_aa (phi, ha, dec, &alt, &az);
+	tsp->Dalt = alt;
+	tsp->Daz = az;
+	tsp->DPA = atan2 (sin(ha), tan(phi)*cos(dec) - sin(dec)*cos(ha));
+	hp->dpos = ha;
+	dp->dpos = dec;
+
+	/* current is what the encoders say, D dithering by a count */
+	hp->raw = (int) floor (ha/(2*PI)*ESTEP + .5);
+	dp->raw = (int) floor (dec/(2*PI)*ESTEP + .5) + (i & 1);
+	hp->cpos = hp->raw*2*PI/ESTEP;
+	dp->cpos = dp->raw*2*PI/ESTEP;
+	tsp->CAHA = hp->cpos;
+	tsp->CJ2kRA = tsp->Clst - hp->cpos - degrad(.3);
+	tsp->CJ2kDec = dp->cpos + degrad(.1);
+	hadec_aa (phi, hp->cpos, dp->cpos, &alt, &az);
+	tsp->Calt = alt;
+	tsp->Caz = az;
+	tsp->CPA = atan2 (sin(hp->cpos), tan(phi)*cos(dp->cpos)
+					    - sin(dp->cpos)*cos(hp->cpos));
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.6g (want %.6g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
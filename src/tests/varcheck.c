@@ -0,0 +1,241 @@
+/* check the binary node variable calls of csimc.c against the wire contract
+ * in csimc.h.
+ *
+ * a child process stands in for csimcd and a node on a private local
+ * socket. it keeps a table of variables and answers PT_GETVAR and PT_SETVAR
+ * requests, encoding and escaping values itself as the contract says, and
+ * drops the link on Data that is not escaped. values holding PSYNC and PESC
+ * bytes must come back as they were set. ref NOANSWER is never answered and
+ * ref BADCOUNT gets an empty reply, as from a node that does not know the
+ * ref.
+ * exit 0 if all ok, else 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "csimc.h"
+
+#define	PORT		(CSIMCPORT+1000)	/* private port, Unix socket */
+#define	HADDR		40			/* host addr we hand out */
+#define	NOANSWER	0x7f			/* ref the node ignores */
+#define	BADCOUNT	0x7e			/* ref the node answers empty */
+#define	ALLSYNC		((int)0x88888888)	/* value of all PSYNC bytes */
+#define	MIXED		((int)0xed0088ed)	/* value with PSYNC and PESC */
+
+static int nbad;
+
+static void node (int lfd);
+static void esc (Byte b, Byte *bp, int *ip);
+static int unesc (Byte *bp, int n);
+static int readAll (int fd, Byte *buf, int n);
+static double now (void);
+static void check (int ok, char *what, double got, double want);
+
+int
+main (int ac, char *av[])
+{
+	int refs[PMXDAT], vals[PMXDAT];
+	int lfd, fd, i, n, ok;
+	double t0;
+	pid_t pid;
+
+	lfd = csimcd_ulisten (PORT);
+	if (lfd < 0) {
+	    perror ("csimcd_ulisten");
+	    return (1);
+	}
+	pid = fork();
+	if (pid == 0)
+	    node (lfd);
+	close (lfd);
+
+	fd = csi_vopen ("127.0.0.1", PORT, 3);
+	check (fd >= 0, "csi_vopen", fd, 0);
+	if (fd < 0) {
+	    kill (pid, SIGKILL);
+	    return (1);
+	}
+	check (csi_f2h (fd) == HADDR, "host addr", csi_f2h (fd), HADDR);
+
+	/* set two, read them back among others in the order asked */
+	refs[0] = CV_TIMEOUT; vals[0] = 123456;
+	refs[1] = CV_TOFFSET; vals[1] = -7;
+	check (csi_setvars (fd, 2, refs, vals) == 0, "setvars", 0, 0);
+	refs[0] = CV_TOFFSET;
+	refs[1] = CV_CLOCK;
+	refs[2] = CV_TIMEOUT;
+	check (csi_getvars (fd, 3, refs, vals) == 0, "getvars", 0, 0);
+	check (vals[0] == -7, "negative value", vals[0], -7);
+	check (vals[1] == 1000*CV_CLOCK + 1, "untouched value", vals[1],
+							1000*CV_CLOCK + 1);
+	check (vals[2] == 123456, "value set", vals[2], 123456);
+	check (csi_setvar (fd, CV_EPOS, -2000000000) == 0, "setvar", 0, 0);
+	ok = csi_getvar (fd, CV_EPOS, &vals[0]) == 0;
+	check (ok && vals[0] == -2000000000, "getvar", vals[0], -2000000000);
+
+	/* values that must be escaped */
+	refs[0] = CV_MPOS; vals[0] = ALLSYNC;
+	refs[1] = CV_MVEL; vals[1] = MIXED;
+	check (csi_setvars (fd, 2, refs, vals) == 0, "setvars of PSYNC and PESC",
+									0, 0);
+	ok = csi_getvars (fd, 2, refs, vals) == 0;
+	check (ok && vals[0] == ALLSYNC, "all PSYNC value", vals[0], ALLSYNC);
+	check (ok && vals[1] == MIXED, "PSYNC and PESC value", vals[1], MIXED);
+
+	/* as many as a packet holds, all escaped */
+	n = PV_MAXN;
+	for (i = 0; i < n; i++) {
+	    refs[i] = 0x10 + i;
+	    vals[i] = ALLSYNC;
+	}
+	check (csi_setvars (fd, n, refs, vals) == 0, "full packet of setvars",
+									n, n);
+	ok = csi_getvars (fd, n, refs, vals) == 0;
+	for (i = 0; ok && i < n; i++)
+	    ok = vals[i] == ALLSYNC;
+	check (ok, "full packet of getvars", n, n);
+	check (csi_getvars (fd, n+1, refs, vals) < 0, "too many get refused",
+								n+1, n);
+	check (csi_setvars (fd, n+1, refs, vals) < 0, "too many set refused",
+								n+1, n);
+
+	/* nodes that do not know a ref */
+	check (csi_getvar (fd, BADCOUNT, &vals[0]) < 0, "wrong reply size",
+								-1, -1);
+	t0 = now();
+	ok = csi_getvar (fd, NOANSWER, &vals[0]) < 0;
+	t0 = now() - t0;
+	check (ok, "no reply", -1, -1);
+	check (t0 >= PV_WAIT/1000. && t0 < 2*PV_WAIT/1000., "gave up after, secs",
+							t0, PV_WAIT/1000.);
+
+	csi_close (fd);
+	kill (pid, SIGKILL);
+	waitpid (pid, NULL, 0);
+	return (nbad ? 1 : 0);
+}
+
+/* be csimcd and the node for one client on lfd, until killed */
+static void
+node (int lfd)
+{
+	int v[256];
+	Byte pre[3], hdr[2], d[PMXDAT], r[1+2*PV_VALSZ*PMXDAT];
+	int fd, i, n;
+
+	for (i = 0; i < 256; i++)
+	    v[i] = 1000*i + 1;
+
+	fd = csimcd_saccept (lfd);
+	if (fd < 0 || readAll (fd, pre, 3) < 0 || pre[1] != FOR_VARS)
+	    _exit (1);
+	r[0] = HADDR;
+	if (write (fd, r, 1) != 1)
+	    _exit (1);
+
+	while (readAll (fd, hdr, 2) == 0 && hdr[1] <= PMXDAT
+					    && readAll (fd, d, hdr[1]) == 0) {
+	    int nd = unesc (d, hdr[1]);
+
+	    if (nd < 0)
+		break;
+	    n = 0;
+	    if (hdr[0] == PT_SETVAR) {
+		for (i = 0; i + 1 + PV_VALSZ <= nd; i += 1 + PV_VALSZ)
+		    v[d[i]] = (int)((unsigned)d[i+1]<<24 | d[i+2]<<16
+						    | d[i+3]<<8 | d[i+4]);
+	    } else if (hdr[0] == PT_GETVAR) {
+		if (d[0] == NOANSWER)
+		    continue;
+		for (i = 0; i < nd; i++) {
+		    unsigned u = v[d[i]];
+		    esc (u >> 24, r+1, &n);
+		    esc (u >> 16, r+1, &n);
+		    esc (u >> 8, r+1, &n);
+		    esc (u, r+1, &n);
+		}
+		if (d[0] == BADCOUNT)
+		    n = 0;
+	    }
+	    if (n > PMXDAT)
+		break;
+	    r[0] = n;
+	    if (write (fd, r, 1+n) != 1+n)
+		break;
+	}
+	_exit (0);
+}
+
+/* put b in bp[*ip] as the node would send it, and update *ip */
+static void
+esc (Byte b, Byte *bp, int *ip)
+{
+	if (b == PSYNC || b == PESC) {
+	    bp[(*ip)++] = PESC;
+	    bp[(*ip)++] = b == PSYNC ? PESYNC : PEESC;
+	} else
+	    bp[(*ip)++] = b;
+}
+
+/* undo esc() on the n bytes of bp[] in place as the node would.
+ * return the bytes left, or -1 if there is a PSYNC or a bad escape.
+ */
+static int
+unesc (Byte *bp, int n)
+{
+	int i, j;
+
+	for (i = j = 0; i < n; i++) {
+	    if (bp[i] == PSYNC)
+		return (-1);
+	    if (bp[i] == PESC) {
+		if (++i == n || (bp[i] != PESYNC && bp[i] != PEESC))
+		    return (-1);
+		bp[j++] = bp[i] == PESYNC ? PSYNC : PESC;
+	    } else
+		bp[j++] = bp[i];
+	}
+	return (j);
+}
+
+/* read exactly n bytes from fd into buf.
+ * return 0 if ok, else -1.
+ */
+static int
+readAll (int fd, Byte *buf, int n)
+{
+	while (n > 0) {
+	    int s = read (fd, buf, n);
+	    if (s <= 0)
+		return (-1);
+	    buf += s;
+	    n -= s;
+	}
+	return (0);
+}
+
+/* return secs since some epoch */
+static double
+now()
+{
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+	return (tv.tv_sec + tv.tv_usec*1e-6);
+}
+
+/* report what, and count it if !ok */
+static void
+check (int ok, char *what, double got, double want)
+{
+	printf ("%-4s %s: %.10g (want %.10g)\n", ok ? "ok" : "BAD", what, got,
+									want);
+	if (!ok)
+	    nbad++;
+}
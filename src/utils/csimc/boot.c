@@ -15,7 +15,32 @@
 
 #include "mc.h"
 
+#define	MAXSCRIPTS	16	/* most scripts for one node */
+#define	LCHUNK		512	/* most bytes to write to a node at once */
+#define	LOADWT		30	/* secs to wait for any node to take more */
+#define	STAMPWT		5	/* secs to wait for a node to report its stamps */
+
+/* one node being loaded by loadAllCfg() */
+typedef struct {
+    int addr;			/* node address */
+    int fd;			/* connection to it */
+    char names[256];		/* its INITn entry, then split up by name[] */
+    char *name[MAXSCRIPTS];	/* each script */
+    int nscripts;		/* number of scripts */
+    int from;			/* first to send, all before are unchanged */
+    unsigned stamp[MAXSCRIPTS];	/* stampOf() each */
+    int off[MAXSCRIPTS+1];	/* where each starts in buf, then nbuf */
+    char *buf;			/* all its scripts, in order */
+    int nbuf;			/* bytes in buf */
+    int nsent;			/* bytes of buf sent so far */
+} LoadJob;
+
 static FILE *openACFile (char *fn);
+static int readScripts (LoadJob *jp, char *scripts);
+static unsigned stampOf (char *buf, int n);
+static int readStamps (LoadJob *jp);
+static char *nameList (LoadJob *jp, int from, int to, char buf[]);
+static void streamAll (LoadJob jobs[], int njobs);
 static int download (char *fn, FILE *fp, int fd);
 static void escData (Byte b, Byte *bp, int *ip);
 static int chkVersion (int vn, int addr);
@@ -56,47 +81,258 @@ loadOneCfg (int fd, char *fn)
 }
 
 /* open the config file cfn and load all scripts to all nodes.
+ * the file is read once, then every node is sent its scripts at the same
+ * time so csimcd passes a packet to each of them in every turn of the token,
+ * rather than one node after another.
+ * each script loaded leaves its stamp on the node in cfgst<i>, i its place in
+ * the INITn list. a node is only sent its scripts from the first whose stamp
+ * differs, so those after still see and override what it sets as usual; a
+ * node with all the same is left alone. a node that was just rebooted has no
+ * stamps so gets everything. the stamps of the scripts to be sent are
+ * cleared before any are, and each set again only once all have loaded.
  * exit(3) if trouble.
  */
 void
 loadAllCfg (char *cfn)
 {
+	static char names[NNODES][16], values[NNODES][256];
+	static LoadJob jobs[NNODES];
+	CfgEntry ce[NNODES];
+	LoadJob *jp;
+	int njobs = 0;
 	int addr;
 
-	/* scan through cfn for INITn entries */
+	/* find all the INITn entries in one pass */
 	for (addr = 0; addr <= MAXNA; addr++) {
-	    char name[32], value[256];
-	    sprintf (name, "INIT%d", addr);
-	    if (!read1CfgEntry (0, cfn, name, CFG_STR, value, sizeof(value))) {
-		/* scan for and load each .cmc file */
-		char *fn, *vp;
-		char buf[32];
-		int fd;
-
-		/* open node */
-		fd = csi_open (host, port, addr);
-		if (fd < 0) {
-		    printf ("Can not open Host %s Port %d address %d\n",
+	    sprintf (names[addr], "INIT%d", addr);
+	    ce[addr].name = names[addr];
+	    ce[addr].type = CFG_STR;
+	    ce[addr].valp = values[addr];
+	    ce[addr].slen = sizeof(values[addr]);
+	}
+	if (readCfgFile (0, cfn, ce, NNODES) < 0) {
+	    printf ("%s: %s\n", cfn, strerror(errno));
+	    exit (3);
+	}
+
+	/* gather each node's scripts, open it and see what it already has */
+	for (addr = 0; addr <= MAXNA; addr++) {
+	    char buf[256];
+	    int i;
+
+	    if (!ce[addr].found)
+		continue;
+	    jp = &jobs[njobs];
+	    jp->addr = addr;
+	    if (readScripts (jp, values[addr]) < 0)
+		exit (3);
+	    jp->fd = csi_open (host, port, addr);
+	    if (jp->fd < 0) {
+		printf ("Can not open Host %s Port %d address %d\n",
 							host, port, addr);
-		    exit(3);
-		}
+		exit(3);
+	    }
+	    jp->from = readStamps (jp);
+	    if (jp->from == jp->nscripts) {
+		printf ("Node %d already has %s\n", addr,
+				    nameList (jp, 0, jp->nscripts, buf));
+		csi_close (jp->fd);
+		free (jp->buf);
+		continue;
+	    }
+	    if (jp->from > 0)
+		printf ("Node %d already has %s\n", addr,
+					    nameList (jp, 0, jp->from, buf));
+
+	    /* forget the stamps we are about to replace, so if the load fails
+	     * part way the node is not later taken to have them.
+	     */
+	    for (i = jp->from; i < jp->nscripts; i++)
+		csi_w (jp->fd, "cfgst%d=0;", i);
+	    jp->nsent = jp->off[jp->from];
+	    njobs++;
+	}
 
-		/* load each script */
-		vp = value;
-		while ((fn = strtok (vp, " \t")) != NULL) {
-		    if (loadOneCfg (fd, fn) < 0)
-			exit (3);
-		    vp = NULL;
-		}
+	/* send to all at once */
+	streamAll (jobs, njobs);
 
-		/* sync */
-		if (csi_wr (fd, buf, sizeof(buf), "=version;") < 0) {
-		    printf ("Addr %d error: %s\n", csi_f2n(fd),strerror(errno));
-		    exit(3);
-		}
+	/* stamp, then sync with each in turn; they are all busy meanwhile */
+	for (jp = jobs; jp < &jobs[njobs]; jp++) {
+	    char buf[256];
+	    int i;
+
+	    for (i = jp->from; i < jp->nscripts; i++)
+		csi_w (jp->fd, "cfgst%d=%u;", i, jp->stamp[i]);
+	    if (csi_wr (jp->fd, buf, sizeof(buf), "=version;") < 0) {
+		printf ("Addr %d error: %s\n", jp->addr, strerror(errno));
+		exit(3);
+	    }
+	    printf ("Node %d loaded with %s\n", jp->addr,
+				    nameList (jp, jp->from, jp->nscripts, buf));
+	    csi_close (jp->fd);
+	    free (jp->buf);
+	}
+}
+
+/* read each script named in scripts into jp->buf and stamp each.
+ * return 0 if ok, else -1 after saying why.
+ */
+static int
+readScripts (LoadJob *jp, char *scripts)
+{
+	char *fn, *vp;
+
+	jp->buf = NULL;
+	jp->nbuf = jp->nsent = 0;
+	jp->nscripts = 0;
+
+	strcpy (jp->names, scripts);
+	for (vp = jp->names; (fn = strtok (vp, " \t")) != NULL; vp = NULL) {
+	    int i = jp->nscripts;
+	    FILE *fp;
+	    int n;
+
+	    if (i == MAXSCRIPTS) {
+		printf ("Node %d: more than %d scripts\n", jp->addr, MAXSCRIPTS);
+		return (-1);
+	    }
+	    fp = openACFile (fn);
+	    if (!fp)
+		return (-1);		/* already explained */
+	    jp->name[i] = fn;
+	    jp->off[i] = jp->nbuf;
+	    do {
+		jp->buf = realloc (jp->buf, jp->nbuf + LCHUNK);
+		n = fread (jp->buf + jp->nbuf, 1, LCHUNK, fp);
+		jp->nbuf += n;
+	    } while (n == LCHUNK);
+	    fclose (fp);
+	    jp->stamp[i] = stampOf (jp->buf + jp->off[i], jp->nbuf - jp->off[i]);
+	    jp->nscripts++;
+	}
+	jp->off[jp->nscripts] = jp->nbuf;
+
+	return (0);
+}
 
-		/* done */
-		csi_close (fd);
+/* return a stamp for the n bytes in buf, never 0.
+ * 32 bit FNV-1a, less the sign bit so it stays positive on the node.
+ */
+static unsigned
+stampOf (char *buf, int n)
+{
+	unsigned h = 2166136261u;
+
+	while (--n >= 0)
+	    h = (h ^ (Byte)*buf++) * 16777619u;
+	h &= 0x7fffffff;
+	return (h ? h : 1);
+}
+
+/* ask the node of jp for the stamps of the scripts it was last loaded with,
+ * all in one go. give up after STAMPWT secs in case it says nothing.
+ * return the index of the first script whose stamp differs, nscripts if none,
+ * or 0 if we can not tell.
+ */
+static int
+readStamps (LoadJob *jp)
+{
+	char buf[64], *end;
+	int from = -1;
+	int i;
+
+	for (i = 0; i < jp->nscripts; i++)
+	    csi_w (jp->fd, "=cfgst%d;", i);
+
+	/* read every reply so none turn up later */
+	for (i = 0; i < jp->nscripts; i++) {
+	    struct timeval tv;
+	    fd_set rs;
+	    long v;
+
+	    FD_ZERO (&rs);
+	    FD_SET (jp->fd, &rs);
+	    tv.tv_sec = STAMPWT;
+	    tv.tv_usec = 0;
+	    if (selectI (jp->fd+1, &rs, NULL, NULL, &tv) != 1
+				    || csi_r (jp->fd, buf, sizeof(buf)) <= 0)
+		return (0);
+	    v = strtol (buf, &end, 0);
+	    if (from < 0 && (end == buf || (unsigned)v != jp->stamp[i]))
+		from = i;
+	}
+
+	return (from < 0 ? jp->nscripts : from);
+}
+
+/* put the names of scripts [from,to) of jp in buf, and return buf */
+static char *
+nameList (LoadJob *jp, int from, int to, char buf[])
+{
+	int i, l = 0;
+
+	buf[0] = '\0';
+	for (i = from; i < to; i++)
+	    l += sprintf (buf+l, "%s%s", i > from ? " " : "", jp->name[i]);
+	return (buf);
+}
+
+/* send each of the njobs their buf all at once, showing anything they say.
+ * exit(3) if trouble.
+ */
+static void
+streamAll (LoadJob jobs[], int njobs)
+{
+	LoadJob *jp;
+	int left = 0;
+
+	for (jp = jobs; jp < &jobs[njobs]; jp++)
+	    if (jp->nsent < jp->nbuf)
+		left++;
+
+	while (left > 0) {
+	    struct timeval tv;
+	    fd_set rs, ws;
+	    int maxfd = 0;
+	    int n;
+
+	    FD_ZERO (&rs);
+	    FD_ZERO (&ws);
+	    for (jp = jobs; jp < &jobs[njobs]; jp++) {
+		FD_SET (jp->fd, &rs);
+		if (jp->nsent < jp->nbuf)
+		    FD_SET (jp->fd, &ws);
+		if (jp->fd > maxfd)
+		    maxfd = jp->fd;
+	    }
+	    tv.tv_sec = LOADWT;
+	    tv.tv_usec = 0;
+
+	    n = selectI (maxfd+1, &rs, &ws, NULL, &tv);
+	    if (n < 0) {
+		printf ("select(): %s\n", strerror(errno));
+		exit (3);
+	    }
+	    if (n == 0) {
+		printf ("Nodes stopped taking scripts for %d secs\n", LOADWT);
+		exit (3);
+	    }
+
+	    for (jp = jobs; jp < &jobs[njobs]; jp++) {
+		if (FD_ISSET (jp->fd, &rs))
+		    pollBack (jp->fd);
+		if (FD_ISSET (jp->fd, &ws)) {
+		    int w = jp->nbuf - jp->nsent;
+		    if (w > LCHUNK)
+			w = LCHUNK;
+		    if (writeI (jp->fd, jp->buf + jp->nsent, w) < 0) {
+			printf ("Node %d: %s\n", jp->addr, strerror(errno));
+			exit (3);
+		    }
+		    jp->nsent += w;
+		    if (jp->nsent == jp->nbuf)
+			left--;
+		}
 	    }
 	}
 }
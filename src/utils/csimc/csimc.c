@@ -15,6 +15,7 @@
 #include "strops.h"
 #include "telenv.h"
 #include "csimc.h"
+#include "csimcstats.h"
 #include "configfile.h"
 
 #include "el.h"
@@ -50,10 +51,18 @@ static void cmdTrace (char cmd[]);
 static void cmdLoad (char cmd[]);
 static void cmdHistory (char cmd[]);
 static void cmdSerial (char cmd[]);
+static void doBench (int addr, int n);
+static void bench1 (int addr, int n, char *how);
+static int dblcmp (const void *p1, const void *p2);
+static void doStats (void);
+static void prHist (char *what, LogHist *hp);
 
 static char *me;			/* our name, for usage */
 static int nflag;			/* initial connection to addr */
 static int addr;			/* if nflag address to connect */
+static int bflag;			/* time round trips to addr then exit */
+static int nbench;			/* if bflag number of round trips */
+static int sflag;			/* print csimcd stats then exit */
 static int tflag;			/* initial connection to tty */
 static int lflag;			/* preload scripts on all nodes */
 static int rflag;			/* reboot all nodes on network */
@@ -82,6 +91,13 @@ main (int ac, char *av[])
 	    char *s;
 	    for (s = av[0]+1; *s != '\0'; s++)
 		switch (*s) {
+		case 'b':
+		    if (ac < 2)
+			usage();
+		    nbench = atoi (*++av);
+		    --ac;
+		    bflag++;
+		    break;
 		case 'c':
 		    if (ac < 2)
 			usage();
@@ -108,6 +124,9 @@ main (int ac, char *av[])
 		case 'r':
 		    rflag++;
 		    break;
+		case 's':
+		    sflag++;
+		    break;
 		case 't':
 		    if (ac < 3)
 			usage();
@@ -134,7 +153,17 @@ main (int ac, char *av[])
 	signal (SIGINT, onInt);
 	signal (SIGCONT, onCont);
 	setbuf (stdout, NULL);
+	if (sflag) {
+	    doStats();
+	    exit (0);
+	}
 	daemonCheck();
+	if (bflag) {
+	    if (!nflag || nbench < 1)
+		usage();
+	    doBench (addr, nbench);
+	    exit (0);
+	}
 	if (elSetup() == 0) {
 	    atexit (elReset);
 	    verbose++;
@@ -200,6 +229,8 @@ usage()
 	fprintf(stderr, "Purpose: command line interface to CSIMC network\n");
 	fprintf(stderr, "$Revision: 1.1.1.1 $\n");
 	fprintf(stderr, "Options:\n");
+	fprintf(stderr, " -b n    time <n> round trips to the node of -n over each way\n");
+	fprintf(stderr, "         of reaching a local %s, then exit\n", dname);
 	fprintf(stderr, " -c f    set alternate config <f>; default is %s\n",
 								    cfg_def);
 	fprintf(stderr, " -i h p  connect to host <h> with port <p>;\n");
@@ -207,6 +238,8 @@ usage()
 	fprintf(stderr, " -l      load all nodes as per config file\n");
 	fprintf(stderr, " -n a    make initial connection to node <a>\n");
 	fprintf(stderr, " -r      reboot all nodes on network\n");
+	fprintf(stderr, " -s      print the LAN stats of the local %s, then exit\n",
+									dname);
 	fprintf(stderr, " -t n b  make initial connection to serial port on node <n> at baud rate <b>.\n");
 	fprintf(stderr, " -v      verbose\n");
 
@@ -840,3 +873,115 @@ cmdSerial (char cmd[])
 	csi_close (sfd);
 	kickPrompt();
 }
+
+/* time n round trips to node addr, first through the local Unix socket then
+ * TCP/IP, and report each. a round trip is one "=clock;" and its reply so it
+ * includes the node, the network and csimcd's token passing.
+ */
+static void
+doBench (int addr, int n)
+{
+	csimcd_unix (1);
+	bench1 (addr, n, "unix");
+	csimcd_unix (0);
+	bench1 (addr, n, "tcp");
+	csimcd_unix (1);
+}
+
+/* time n round trips to addr using the current transport and report as how */
+static void
+bench1 (int addr, int n, char *how)
+{
+	struct timeval t0, t1;
+	double *dt, sum = 0;
+	int fd, i;
+
+	fd = csi_open (host, port, addr);
+	if (fd < 0) {
+	    printf ("%-4s: can not contact node %d: %s\n", how, addr,
+							    strerror(errno));
+	    return;
+	}
+
+	dt = (double *) malloc (n * sizeof(double));
+	for (i = 0; i < n; i++) {
+	    gettimeofday (&t0, NULL);
+	    (void) csi_rix (fd, "=clock;");
+	    gettimeofday (&t1, NULL);
+	    dt[i] = (t1.tv_sec - t0.tv_sec)*1e3 + (t1.tv_usec - t0.tv_usec)*1e-3;
+	    sum += dt[i];
+	}
+	csi_close (fd);
+
+	qsort ((void *)dt, n, sizeof(double), dblcmp);
+	printf ("%-4s: %d round trips to node %d: mean %.3f min %.3f p50 %.3f p99 %.3f max %.3f ms\n",
+		    how, n, addr, sum/n, dt[0], dt[n/2], dt[(int)(.99*(n-1))],
+		    dt[n-1]);
+	free ((void *)dt);
+}
+
+/* compare two doubles for qsort */
+static int
+dblcmp (const void *p1, const void *p2)
+{
+	double d = *(double *)p1 - *(double *)p2;
+
+	return (d < 0 ? -1 : d > 0 ? 1 : 0);
+}
+
+/* print the stats kept by the csimcd on port on this host */
+static void
+doStats (void)
+{
+	CSIMCStats *css = cssOpen (port, 0);
+	int a;
+
+	if (!css) {
+	    fprintf (stderr, "No stats from %s on port %d: %s\n", dname, port,
+							    strerror(errno));
+	    exit (1);
+	}
+
+	printf ("%s pid %d: %u reads %u writes %u junk bytes\n", dname,
+		    css->pid, css->lanreads, css->lanwrites, css->lanjunk);
+	prHist ("token rotation", &css->rotation);
+
+	for (a = 0; a <= CSS_NOADDR; a++) {
+	    CSSNode *np = &css->node[a];
+
+	    if (!np->rxpkts && !np->txpkts && !np->resyncs && !np->hchkerrs)
+		continue;
+	    if (a < CSS_NOADDR)
+		printf ("Node %2d:", a);
+	    else
+		printf ("Other  :");
+	    printf (" rx %u pkts %.1f/s, tx %u pkts %.1f/s, %u resyncs %u hchk %u dchk, %u retries %u reboots %u token timeouts\n",
+		    np->rxpkts, np->rxpps, np->txpkts, np->txpps, np->resyncs,
+		    np->hchkerrs, np->dchkerrs, np->retries, np->reboots,
+		    np->toktimeouts);
+	    prHist ("ack", &np->ack);
+	    prHist ("token held", &np->tokhold);
+	}
+
+	for (a = 0; a < NHOSTS; a++) {
+	    CSSHost *hp = &css->host[a];
+	    char what[64];
+
+	    if (hp->toaddr < 0)
+		continue;
+	    sprintf (what, "host %d to node %d, %u pkts, wait", a + NNODES,
+							hp->toaddr, hp->pkts);
+	    prHist (what, &hp->wait);
+	}
+}
+
+/* print a summary of *hp, if any */
+static void
+prHist (char *what, LogHist *hp)
+{
+	if (!hp->n)
+	    return;
+	printf ("  %s: n=%u mean=%.2fms p50=%.2fms p99=%.2fms max=%.2fms\n",
+		    what, hp->n, 1e3*hp->sum/hp->n, 1e3*lhQuantile (hp, .5),
+		    1e3*lhQuantile (hp, .99), 1e3*hp->max);
+}
@@ -0,0 +1,131 @@
+/* turn the text pointing mesh into the binary form telescoped maps.
+ *
+ * see telmesh.h for both forms. the new file gets the generation of the one
+ * it replaces plus one, and is renamed into place so telescoped, which
+ * reloads it when it appears, never sees it part written.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <math.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "strops.h"
+#include "telenv.h"
+#include "telmesh.h"
+
+static void usage (void);
+static void warn (char *fmt, ...);
+
+static char meshfn[] = "archive/config/telescoped.mesh";
+static char mbinfn[] = "archive/config/telescoped.mbin";
+
+static char *me;			/* our name, for usage */
+
+int
+main (int ac, char *av[])
+{
+	char inpath[1024], outpath[1024];
+	char *in = NULL, *out = NULL;
+	unsigned gen = 1;
+	int verbose = 0;
+	TMPoint *pt;
+	TMesh mesh;
+	char *str;
+	int n;
+
+	me = basenm(av[0]);
+
+	/* crack arguments */
+	for (av++; --ac > 0 && *(str = *av) == '-'; av++) {
+	    char c;
+	    while ((c = *++str) != '\0')
+		switch (c) {
+		case 'i':	/* text mesh */
+		    if (ac < 2)
+			usage();
+		    in = *++av;
+		    ac--;
+		    break;
+		case 'o':	/* binary mesh */
+		    if (ac < 2)
+			usage();
+		    out = *++av;
+		    ac--;
+		    break;
+		case 'v':
+		    verbose++;
+		    break;
+		default:
+		    usage();
+		}
+	}
+
+	/* now there are ac remaining args starting at av[0] */
+	if (ac != 0)
+	    usage();
+	if (!in) {
+	    telfixpath (inpath, meshfn);
+	    in = inpath;
+	}
+	if (!out) {
+	    telfixpath (outpath, mbinfn);
+	    out = outpath;
+	}
+
+	/* one on from any we replace */
+	if (tmOpen (out, &mesh) == 0) {
+	    gen = mesh.hp->gen + 1;
+	    tmClose (&mesh);
+	}
+
+	n = tmReadText (in, &pt, (TMPrFp) warn);
+	if (n < 0) {
+	    fprintf (stderr, "%s: %s\n", in, strerror(errno));
+	    exit (1);
+	}
+	if (tmBuild (pt, n, gen, &mesh) < 0) {
+	    fprintf (stderr, "%s: %s\n", me, strerror(errno));
+	    exit (1);
+	}
+	if (tmWrite (out, &mesh) < 0) {
+	    fprintf (stderr, "%s: %s\n", out, strerror(errno));
+	    exit (1);
+	}
+
+	if (verbose)
+	    printf ("%s: %d points, generation %u, %d x %d cells\n", out, n,
+				    gen, mesh.hp->ndec, mesh.hp->nha);
+
+	tmClose (&mesh);
+	free ((void *)pt);
+	return (0);
+}
+
+static void
+usage()
+{
+	fprintf(stderr,"Usage: %s [options]\n", me);
+	fprintf(stderr,"Purpose: convert the text pointing mesh to binary\n");
+	fprintf(stderr,"Options:\n");
+	fprintf(stderr," -i file: text mesh; default $TELHOME/%s\n", meshfn);
+	fprintf(stderr," -o file: binary mesh; default $TELHOME/%s\n", mbinfn);
+	fprintf(stderr," -v:      verbose\n");
+	exit (1);
+}
+
+/* report a bad line in the text mesh */
+static void
+warn (char *fmt, ...)
+{
+	va_list ap;
+
+	va_start (ap, fmt);
+	vfprintf (stderr, fmt, ap);
+	va_end (ap);
+	fprintf (stderr, "\n");
+}
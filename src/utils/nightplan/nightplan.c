@@ -0,0 +1,566 @@
+/* plan a night: for each target find its altitude, airmass, separation from
+ * the moon and whether the mount can reach it, at regular times through the
+ * dark part of the night. results go to a compact binary table; see np.h.
+ *
+ * everything that depends only on time (sun, moon, sidereal time) is found
+ * once per sample and the targets are reduced to apparent place all at once
+ * with ap_reduce(). the per-target work after that is plain spherical trig
+ * and the mount model from telaxes.c, which is spread over all cpus with a
+ * work-stealing pool. libastro keeps static caches so it is only ever called
+ * from the main thread, except for the reentrant ap_reduce(), refract() and
+ * airmass().
+ *
+ * -b n replaces the target list with n random stars and reports the time
+ * taken by each phase, as a benchmark.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "configfile.h"
+#include "misc.h"
+#include "strops.h"
+#include "telenv.h"
+#include "telstatshm.h"
+#include "wspool.h"
+
+#include "np.h"
+
+#define	DEFSTEP		10.0		/* default sample step, mins */
+#define	DEFMINALT	20.0		/* default lowest altitude, degs */
+#define	DEFSUNDIP	12.0		/* default sun dip for dark, degs */
+#define	TGRAIN		64		/* targets per work chunk */
+#define	MAXLINE		1024		/* longest .edb line */
+
+/* all that the workers need, read-only except for their own slices */
+typedef struct {
+    int nt, ns;			/* n targets, n samples */
+    double *ra, *dec;		/* target places, then apparent */
+    double *pmra, *pmdec, *px;	/* proper motions and parallax */
+    APTerms apt;		/* for ap_reduce() */
+    NPSample *sp;		/* [ns] */
+    double *mx, *my, *mz;	/* [ns] moon unit vectors */
+    NPTarget *tp;		/* [nt] */
+    NPRec *rp;			/* [nt][ns] */
+} Plan;
+
+static void usage (void);
+static void readSite (Now *np);
+static void readAxes (void);
+static int loadTargets (char *fn);
+static void randomTargets (int n);
+static void addTarget (char *name, double ra, double dec, double pmra,
+    double pmdec, double px);
+static int mkSamples (Now *np, double mjd0);
+static void apWork (void *arg, int lo, int hi);
+static void tgWork (void *arg, int lo, int hi);
+static int reachable (double ha, double dec);
+static int writePlan (char *fn, Now *np);
+static double secs (void);
+
+static char tscfn[] = "archive/config/telsched.cfg";
+static char hcfn[] = "archive/config/home.cfg";
+
+static char *me;			/* our name, for usage */
+static int verbose;			/* more chatter */
+static double step = DEFSTEP;		/* sample step, mins */
+static double minalt;			/* lowest alt, rads */
+static double sundip;			/* sun dip, rads */
+static TelAxes tax;			/* mount model */
+static MotorInfo minfo[TEL_NM];		/* axis limits */
+static int havelim;			/* set if we found the mount model */
+static double sitelat, sitetemp, sitepres;	/* site copies, for workers */
+
+static Plan plan;
+static int maxt;			/* n allocated in plan target arrays */
+
+int
+main (int ac, char *av[])
+{
+	char *outfn = NULL;
+	double mjd0 = 0;
+	int nthr = (int) sysconf (_SC_NPROCESSORS_ONLN);
+	int bench = 0;
+	double t0, t1, t2, t3, t4;
+	Now now, *np = &now;
+	char *str;
+
+	me = basenm(av[0]);
+	minalt = degrad(DEFMINALT);
+	sundip = degrad(DEFSUNDIP);
+
+	/* crack arguments */
+	for (av++; --ac > 0 && *(str = *av) == '-'; av++) {
+	    char c;
+	    while ((c = *++str) != '\0')
+		switch (c) {
+		case 'a':	/* min altitude */
+		    if (ac < 2)
+			usage();
+		    minalt = degrad(atof(*++av));
+		    ac--;
+		    break;
+		case 'b':	/* benchmark */
+		    if (ac < 2)
+			usage();
+		    bench = atoi(*++av);
+		    ac--;
+		    break;
+		case 'd':	/* MJD of the evening */
+		    if (ac < 2)
+			usage();
+		    mjd0 = atof(*++av) + 2400000.5 - MJD0;
+		    ac--;
+		    break;
+		case 'j':	/* n threads */
+		    if (ac < 2)
+			usage();
+		    nthr = atoi(*++av);
+		    ac--;
+		    break;
+		case 'o':	/* output file */
+		    if (ac < 2)
+			usage();
+		    outfn = *++av;
+		    ac--;
+		    break;
+		case 's':	/* sample step */
+		    if (ac < 2)
+			usage();
+		    step = atof(*++av);
+		    ac--;
+		    break;
+		case 't':	/* twilight */
+		    if (ac < 2)
+			usage();
+		    sundip = degrad(atof(*++av));
+		    ac--;
+		    break;
+		case 'v':
+		    verbose++;
+		    break;
+		default:
+		    usage();
+		}
+	}
+
+	/* now there are ac remaining args starting at av[0] */
+	if ((bench > 0) == (ac == 1) || ac > 1 || !outfn || step <= 0)
+	    usage();
+	if (nthr < 1)
+	    nthr = 1;
+	if (mjd0 == 0)
+	    mjd0 = mjd_day (mjd_now());
+
+	readSite (np);
+	readAxes ();
+
+	t0 = secs();
+	if (bench > 0)
+	    randomTargets (bench);
+	else if (loadTargets (av[0]) < 0)
+	    exit (1);
+	if (plan.nt == 0) {
+	    fprintf (stderr, "%s: no fixed targets\n", me);
+	    exit (1);
+	}
+
+	t1 = secs();
+	if (mkSamples (np, mjd0) < 0)
+	    exit (1);
+
+	t2 = secs();
+	ap_terms (J2000, plan.sp[plan.ns/2].smjd, &plan.apt);
+	(void) ws_run (nthr, plan.nt, 1024, apWork, &plan);
+
+	t3 = secs();
+	plan.tp = (NPTarget *) realloc ((char *)plan.tp,
+					plan.nt*sizeof(NPTarget));
+	plan.rp = (NPRec *) malloc ((size_t)plan.nt*plan.ns*sizeof(NPRec));
+	if (!plan.tp || !plan.rp) {
+	    fprintf (stderr, "%s: no memory for %d x %d table\n", me, plan.nt,
+								    plan.ns);
+	    exit (1);
+	}
+	(void) ws_run (nthr, plan.nt, TGRAIN, tgWork, &plan);
+
+	t4 = secs();
+	if (writePlan (outfn, np) < 0)
+	    exit (1);
+
+	if (bench > 0 || verbose) {
+	    fprintf (stderr, "%d targets x %d samples, %d threads\n", plan.nt,
+								plan.ns, nthr);
+	    fprintf (stderr, "  targets   %8.3f s\n", t1 - t0);
+	    fprintf (stderr, "  samples   %8.3f s\n", t2 - t1);
+	    fprintf (stderr, "  apparent  %8.3f s\n", t3 - t2);
+	    fprintf (stderr, "  visible   %8.3f s\n", t4 - t3);
+	    fprintf (stderr, "  write     %8.3f s\n", secs() - t4);
+	}
+
+	return (0);
+}
+
+static void
+usage()
+{
+	fprintf(stderr,"Usage: %s [options] -o out {targets.edb | -b n}\n", me);
+	fprintf(stderr,"Purpose: find target visibility through one night\n");
+	fprintf(stderr,"Options:\n");
+	fprintf(stderr," -a alt:  lowest altitude, degs; default %g\n",
+								DEFMINALT);
+	fprintf(stderr," -b n:    benchmark with n random targets\n");
+	fprintf(stderr," -d mjd:  MJD of the evening; default today\n");
+	fprintf(stderr," -j n:    threads; default one per cpu\n");
+	fprintf(stderr," -o file: binary output file\n");
+	fprintf(stderr," -s mins: sample step; default %g\n", DEFSTEP);
+	fprintf(stderr," -t dip:  sun below horizon for dark, degs; default %g\n",
+								DEFSUNDIP);
+	fprintf(stderr," -v:      verbose\n");
+	exit (1);
+}
+
+/* fill in the site from telsched.cfg, just as telescoped does */
+static void
+readSite (Now *np)
+{
+#define NTSCFG  (sizeof(tscfg)/sizeof(tscfg[0]))
+	static double LONGITUDE, LATITUDE, TEMPERATURE, PRESSURE, ELEVATION;
+	static CfgEntry tscfg[] = {
+	    {"LONGITUDE",	CFG_DBL, &LONGITUDE},
+	    {"LATITUDE",	CFG_DBL, &LATITUDE},
+	    {"TEMPERATURE",	CFG_DBL, &TEMPERATURE},
+	    {"PRESSURE",	CFG_DBL, &PRESSURE},
+	    {"ELEVATION",	CFG_DBL, &ELEVATION},
+	};
+	int n;
+
+	n = readCfgFile (verbose, tscfn, tscfg, NTSCFG);
+	if (n != NTSCFG) {
+	    cfgFileError (tscfn, n, NULL, tscfg, NTSCFG);
+	    exit (1);
+	}
+
+	memset ((void *)np, 0, sizeof(*np));
+	lng = -LONGITUDE;		/* we want rads +E */
+	lat = LATITUDE;			/* we want rads +N */
+	temp = TEMPERATURE;		/* we want degrees C */
+	pressure = PRESSURE;		/* we want mB */
+	elev = ELEVATION/ERAD;		/* we want earth radii*/
+	epoch = EOD;
+
+	sitelat = lat;
+	sitetemp = temp;
+	sitepres = pressure;
+#undef NTSCFG
+}
+
+/* fill in the mount model and limits from home.cfg and telescoped.cfg.
+ * if not available, every target is taken to be reachable.
+ */
+static void
+readAxes()
+{
+	if (tel_readmount (verbose, &tax, minfo) < 0) {
+	    fprintf (stderr, "%s: no mount model in %s; ignoring limits\n", me,
+									hcfn);
+	    return;
+	}
+	havelim = 1;
+}
+
+/* read the fixed objects in the .edb file fn into plan.
+ * return 0 if ok else -1.
+ */
+static int
+loadTargets (char *fn)
+{
+	char line[MAXLINE], whynot[MAXLINE];
+	FILE *fp;
+	Obj o;
+
+	fp = fopen (fn, "r");
+	if (!fp) {
+	    perror (fn);
+	    return (-1);
+	}
+
+	while (fgets (line, sizeof(line), fp)) {
+	    double ra, dec;
+
+	    memset ((void *)&o, 0, sizeof(o));
+	    if (db_crack_line (line, &o, whynot) < 0) {
+		if (whynot[0] && verbose)
+		    fprintf (stderr, "%s: %s\n", fn, whynot);
+		continue;
+	    }
+	    if (o.o_type != FIXED) {
+		if (verbose)
+		    fprintf (stderr, "%s: %s is not fixed\n", fn, o.o_name);
+		continue;
+	    }
+
+	    ra = o.f_RA;
+	    dec = o.f_dec;
+	    if (o.f_epoch != J2000)
+		precess (o.f_epoch, J2000, &ra, &dec);
+	    addTarget (o.o_name, ra, dec, o.f_pmRA, o.f_pmdec, o.f_px);
+	}
+
+	fclose (fp);
+	return (0);
+}
+
+/* fill plan with n stars spread evenly over the sky */
+static void
+randomTargets (int n)
+{
+	char name[MAXNM];
+	int i;
+
+	srand48 (1);
+	for (i = 0; i < n; i++) {
+	    double ra = 2*PI*drand48();
+	    double dec = asin(2*drand48() - 1);
+
+	    sprintf (name, "B%d", i);
+	    addTarget (name, ra, dec, 0.0, 0.0, 0.0);
+	}
+}
+
+/* add one target to plan, growing as needed */
+static void
+addTarget (char *name, double ra, double dec, double pmra, double pmdec,
+double px)
+{
+	NPTarget *tp;
+	int i = plan.nt;
+
+	if (i == maxt) {
+	    maxt = maxt ? 2*maxt : 1024;
+	    plan.ra = (double *) realloc ((char *)plan.ra, maxt*sizeof(double));
+	    plan.dec = (double *) realloc ((char *)plan.dec, maxt*sizeof(double));
+	    plan.pmra = (double *)realloc((char *)plan.pmra,maxt*sizeof(double));
+	    plan.pmdec=(double *)realloc((char *)plan.pmdec,maxt*sizeof(double));
+	    plan.px = (double *) realloc ((char *)plan.px, maxt*sizeof(double));
+	    plan.tp = (NPTarget *) realloc ((char *)plan.tp,
+						    maxt*sizeof(NPTarget));
+	    if (!plan.ra || !plan.dec || !plan.pmra || !plan.pmdec || !plan.px
+								|| !plan.tp) {
+		fprintf (stderr, "%s: no memory for %d targets\n", me, maxt);
+		exit (1);
+	    }
+	}
+
+	plan.ra[i] = ra;
+	plan.dec[i] = dec;
+	plan.pmra[i] = pmra;
+	plan.pmdec[i] = pmdec;
+	plan.px[i] = px;
+	tp = &plan.tp[i];
+	memset ((void *)tp, 0, sizeof(*tp));
+	strncpy (tp->name, name, MAXNM-1);
+	plan.nt++;
+}
+
+/* find the samples from the first to the last dark one in the 24 hours
+ * starting at local noon of the UTC day beginning at mjd0.
+ * return 0 if ok, else -1 if there is no dark time.
+ */
+static int
+mkSamples (Now *np, double mjd0)
+{
+	double noon = mjd0 + 0.5 - lng/(2*PI);
+	int n = (int)(24*60/step) + 1;
+	int i, first = -1, last = -1;
+	Obj sun, moon;
+
+	(void) ts_init (noon, 2);
+
+	memset ((void *)&sun, 0, sizeof(sun));
+	sun.o_type = PLANET;
+	sun.pl.pl_code = SUN;
+	memset ((void *)&moon, 0, sizeof(moon));
+	moon.o_type = PLANET;
+	moon.pl.pl_code = MOON;
+
+	/* find the dark ones */
+	for (i = 0; i < n; i++) {
+	    mjd = noon + i*step/(24*60);
+	    (void) obj_cir (np, &sun);
+	    if (sun.s_alt < -sundip) {
+		if (first < 0)
+		    first = i;
+		last = i;
+	    }
+	}
+	if (first < 0) {
+	    fprintf (stderr, "%s: no dark time\n", me);
+	    return (-1);
+	}
+
+	plan.ns = last - first + 1;
+	plan.sp = (NPSample *) calloc (plan.ns, sizeof(NPSample));
+	plan.mx = (double *) calloc (plan.ns, sizeof(double));
+	plan.my = (double *) calloc (plan.ns, sizeof(double));
+	plan.mz = (double *) calloc (plan.ns, sizeof(double));
+	if (!plan.sp || !plan.mx || !plan.my || !plan.mz) {
+	    fprintf (stderr, "%s: no memory for %d samples\n", me, plan.ns);
+	    return (-1);
+	}
+
+	for (i = 0; i < plan.ns; i++) {
+	    NPSample *sp = &plan.sp[i];
+	    double lst;
+
+	    mjd = noon + (first+i)*step/(24*60);
+	    sp->smjd = mjd;
+	    now_lst (np, &lst);
+	    sp->lst = (float)hrrad(lst);
+	    (void) obj_cir (np, &sun);
+	    sp->sunalt = (float)sun.s_alt;
+	    (void) obj_cir (np, &moon);
+	    sp->moonra = moon.s_ra;
+	    sp->moondec = moon.s_dec;
+	    sp->moonalt = (float)moon.s_alt;
+	    sphcart (moon.s_ra, moon.s_dec, 1.0, &plan.mx[i], &plan.my[i],
+								&plan.mz[i]);
+	}
+
+	return (0);
+}
+
+/* ws_run() function to reduce targets [lo,hi) to apparent place */
+static void
+apWork (void *arg, int lo, int hi)
+{
+	Plan *pp = (Plan *) arg;
+
+	ap_reduce (&pp->apt, hi-lo, pp->ra+lo, pp->dec+lo, pp->pmra+lo,
+							pp->pmdec+lo, pp->px+lo);
+}
+
+/* ws_run() function to fill in the NPTargets and NPRecs for targets
+ * [lo,hi).
+ */
+static void
+tgWork (void *arg, int lo, int hi)
+{
+	Plan *pp = (Plan *) arg;
+	double slat = sin(sitelat), clat = cos(sitelat);
+	int t, i;
+
+	for (t = lo; t < hi; t++) {
+	    NPTarget *tp = &pp->tp[t];
+	    NPRec *rp = &pp->rp[(size_t)t*pp->ns];
+	    double ra = pp->ra[t], dec = pp->dec[t];
+	    double sdec = sin(dec), cdec = cos(dec);
+	    double x = cdec*cos(ra), y = cdec*sin(ra), z = sdec;
+	    double maxalt = -PI/2;
+
+	    tp->ra = (float)ra;
+	    tp->dec = (float)dec;
+	    tp->first = tp->last = -1;
+
+	    for (i = 0; i < pp->ns; i++, rp++) {
+		double ha = pp->sp[i].lst - ra;
+		double alt, am, sep;
+
+		alt = asin (slat*sdec + clat*cdec*cos(ha));
+		if (alt > 0)
+		    refract (sitepres, sitetemp, alt, &alt);
+		if (alt > maxalt)
+		    maxalt = alt;
+		airmass (alt, &am);
+		sep = acos (x*pp->mx[i] + y*pp->my[i] + z*pp->mz[i]);
+
+		rp->alt = (short)floor(raddeg(alt)*100 + 0.5);
+		rp->airm = am < 65.535 ? (unsigned short)(am*1000) : 65535;
+		rp->msep = (unsigned short)floor(raddeg(sep)*100 + 0.5);
+		rp->flags = 0;
+		if (alt >= minalt) {
+		    rp->flags |= NP_UP;
+		    if (reachable (ha, dec))
+			rp->flags |= NP_REACH;
+		}
+		if ((rp->flags & NP_OK) == NP_OK) {
+		    if (tp->first < 0)
+			tp->first = i;
+		    tp->last = i;
+		}
+	    }
+
+	    tp->maxalt = (float)maxalt;
+	}
+}
+
+/* return 1 if the mount can point at ha/dec within its limits, else 0.
+ * this is chkLimits() from telescoped with wrapping allowed, but without
+ * the mesh or refraction corrections.
+ */
+static int
+reachable (double ha, double dec)
+{
+	double x, y;
+
+	if (!havelim)
+	    return (1);
+	return (tel_slewxy (&tax, minfo, ha, dec, &x, &y) == 0);
+}
+
+/* write plan to fn as described in np.h.
+ * return 0 if ok, else -1.
+ */
+static int
+writePlan (char *fn, Now *np)
+{
+	NPHeader h;
+	FILE *fp;
+
+	memset ((void *)&h, 0, sizeof(h));
+	strcpy (h.magic, NP_MAGIC);
+	h.version = NP_VERSION;
+	h.ntargets = plan.nt;
+	h.nsamples = plan.ns;
+	h.slat = lat;
+	h.slng = lng;
+	h.minalt = minalt;
+	h.sundip = sundip;
+
+	fp = fopen (fn, "w");
+	if (!fp) {
+	    perror (fn);
+	    return (-1);
+	}
+	if (fwrite (&h, sizeof(h), 1, fp) != 1
+	    || fwrite (plan.sp, sizeof(NPSample), plan.ns, fp) != plan.ns
+	    || fwrite (plan.tp, sizeof(NPTarget), plan.nt, fp) != plan.nt
+	    || fwrite (plan.rp, sizeof(NPRec), (size_t)plan.nt*plan.ns, fp)
+						    != (size_t)plan.nt*plan.ns) {
+	    perror (fn);
+	    fclose (fp);
+	    return (-1);
+	}
+	if (fclose (fp) < 0) {
+	    perror (fn);
+	    return (-1);
+	}
+	return (0);
+}
+
+/* wall clock, secs */
+static double
+secs()
+{
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+	return (tv.tv_sec + tv.tv_usec*1e-6);
+}
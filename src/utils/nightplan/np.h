@@ -0,0 +1,52 @@
+/* include file for nightplan and readers of its output.
+ *
+ * the output file is, in host byte order:
+ *   NPHeader
+ *   NPSample[nsamples]
+ *   NPTarget[ntargets]
+ *   NPRec[ntargets][nsamples]
+ */
+
+#define	NP_MAGIC	"TALONNP"	/* 8 chars including the \0 */
+#define	NP_VERSION	1
+
+typedef struct {
+    char magic[8];		/* NP_MAGIC */
+    int version;		/* NP_VERSION */
+    int ntargets;		/* number of NPTargets */
+    int nsamples;		/* number of NPSamples */
+    int pad;
+    double slat, slng;		/* site, rads +N +E */
+    double minalt;		/* lowest altitude to observe, rads */
+    double sundip;		/* sun below horizon for dark, rads */
+} NPHeader;
+
+/* one per time sample through the dark part of the night */
+typedef struct {
+    double smjd;		/* UTC, as in Now.n_mjd */
+    float lst;			/* local apparent sidereal time, rads */
+    float sunalt;		/* sun altitude, rads */
+    float moonra, moondec;	/* moon apparent topocentric place, rads */
+    float moonalt;		/* moon altitude, rads */
+    float pad;
+} NPSample;
+
+/* one per target */
+typedef struct {
+    char name[MAXNM];		/* as in .edb, or made up */
+    short first, last;		/* first/last NP_OK sample, -1 if none */
+    float ra, dec;		/* apparent place at mid night, rads */
+    float maxalt;		/* highest altitude over the night, rads */
+} NPTarget;
+
+/* one per target per sample */
+typedef struct {
+    short alt;			/* altitude, 1/100 degs */
+    unsigned short airm;	/* airmass * 1000 */
+    unsigned short msep;	/* separation from moon, 1/100 degs */
+    unsigned short flags;	/* NP_* */
+} NPRec;
+
+#define	NP_UP		0x1	/* at least minalt */
+#define	NP_REACH	0x2	/* within mount limits */
+#define	NP_OK		(NP_UP|NP_REACH)
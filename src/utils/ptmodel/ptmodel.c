@@ -0,0 +1,675 @@
+/* build the pointing model from logged pointing errors.
+ *
+ * each log is in the form of the text mesh of telmesh.h: HA and Dec where the
+ * mount put the scope by the axes in home.cfg, with no mesh, then how far
+ * that was from where the image showed it really was. the encoder values of
+ * each are found again from home.cfg, then new HT, DT, XP, YC and NP are
+ * solved for with tel_solve_axes(). what they still leave is the new mesh.
+ *
+ * stars more than a few times the median error from the solution are left
+ * out and it is solved again, until no more change. the same is done leaving
+ * out each of several folds of the stars in turn, to see how well it does on
+ * stars it has not seen, with just the axes and with the mesh of the others
+ * at each of several PTGRADs; the best of those is the PTGRAD to use. each
+ * fold starts from the whole solution, then they are independent so they
+ * are spread over all cpus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "configfile.h"
+#include "misc.h"
+#include "running.h"
+#include "strops.h"
+#include "telenv.h"
+#include "telstatshm.h"
+#include "telmesh.h"
+#include "wspool.h"
+
+#define	DEFFOLDS	5		/* default cross-validation folds */
+#define	DEFCLIP		3.0		/* default clip, times median error */
+#define	MAXCLIP		10		/* most solve and clip rounds */
+#define	MINCHG		1000		/* done if 1 in this many change */
+#define	FTOL		1e-9		/* tel_solve_axes() tolerance */
+#define	MINSTARS	20		/* fewest stars worth solving */
+#define	TDNAME		"telescoped"	/* daemon that reloads the mesh */
+
+/* PTGRADs to try, degs */
+static double radii[] = {0.5, 1, 2, 3, 4, 6, 8, 12, 16, 24};
+#define	NRADII	(sizeof(radii)/sizeof(radii[0]))
+
+typedef struct {
+    double H, D;			/* where it really was, rads */
+    double X, Y;			/* real encoder values, rads */
+    int flip;				/* GERMEQ_FLIP for X and Y */
+    int fold;				/* cross-validation set */
+} Star;
+
+typedef struct {
+    int fold;				/* fold left out, -1 for none */
+    TelAxes tax;			/* solution */
+    char *in;				/* [nstars] set if used in tax */
+    int ok;				/* set if tax settled */
+    int nin;				/* n in[] set */
+    double lim;				/* clip limit, rads */
+    double rms;				/* rms of those in, rads */
+    int nheld;				/* held out stars within lim */
+    double gss;				/* sum of their squared errors, rads */
+    double mss[NRADII];			/* same after each mesh of the rest */
+} Job;
+
+static void usage (void);
+static int readLog (char *fn);
+static void jobWork (void *arg, int lo, int hi);
+static void solveJob (Job *jp, Job *from);
+static void heldOut (Job *jp);
+static void starErr (TelAxes *tap, Star *sp, double *dhap, double *ddecp);
+static double skyErr (double dha, double ddec, double dec);
+static double median (double *v, int n);
+static int cmpDbl (const void *p1, const void *p2);
+static int makeMesh (Job *jp, TMPoint **ptp);
+static int writeText (char *fn, TMPoint *pt, int n);
+static int writeAll (Job *jp, TMPoint *pt, int n, double ptgrad);
+static void warn (char *fmt, ...);
+
+static char hcfn[] = "archive/config/home.cfg";
+static char tscfn[] = "archive/config/telsched.cfg";
+static char meshfn[] = "archive/config/telescoped.mesh";
+static char mbinfn[] = "archive/config/telescoped.mbin";
+
+static char *me;			/* our name, for usage */
+static int verbose;			/* more chatter */
+static int keepaxes;			/* set to just clip and mesh */
+static double clip = DEFCLIP;		/* clip, times median error */
+static int nfolds = DEFFOLDS;		/* cross-validation folds */
+static TelAxes tax0;			/* axes the logs were made with */
+static MotorInfo minfo[TEL_NM];		/* for tel_readmount() */
+static Star *stars;			/* all logged stars */
+static int nstars;			/* n stars[] */
+static Job *jobs;			/* [nfolds+1], [0] for all stars */
+
+int
+main (int ac, char *av[])
+{
+	int nthr = (int) sysconf (_SC_NPROCESSORS_ONLN);
+	double cvss[NRADII], cvgss = 0;
+	int cvn = 0;
+	char *meshout = NULL;
+	int update = 0;
+	TMPoint *pt;
+	Job *jp;
+	double old[5], new[5];
+	static char *names[5] = {"HT", "DT", "XP", "YC", "NP"};
+	double lss = 0;
+	int best, npt;
+	char *str;
+	int i, j;
+
+	me = basenm(av[0]);
+
+	/* crack arguments */
+	for (av++; --ac > 0 && *(str = *av) == '-'; av++) {
+	    char c;
+	    while ((c = *++str) != '\0')
+		switch (c) {
+		case 'c':	/* clip */
+		    if (ac < 2)
+			usage();
+		    clip = atof(*++av);
+		    ac--;
+		    break;
+		case 'g':	/* keep axes */
+		    keepaxes++;
+		    break;
+		case 'j':	/* n threads */
+		    if (ac < 2)
+			usage();
+		    nthr = atoi(*++av);
+		    ac--;
+		    break;
+		case 'k':	/* n folds */
+		    if (ac < 2)
+			usage();
+		    nfolds = atoi(*++av);
+		    ac--;
+		    break;
+		case 'm':	/* text mesh */
+		    if (ac < 2)
+			usage();
+		    meshout = *++av;
+		    ac--;
+		    break;
+		case 'w':	/* write into TELHOME */
+		    update++;
+		    break;
+		case 'v':
+		    verbose++;
+		    break;
+		default:
+		    usage();
+		}
+	}
+
+	/* now there are ac remaining args starting at av[0] */
+	if (ac < 1 || nfolds < 2 || clip <= 0)
+	    usage();
+	if (nthr < 1)
+	    nthr = 1;
+
+	/* telescoped applies a new mesh at once but new axes only at Reset,
+	 * so the mesh made for the new axes would meet the old ones.
+	 */
+	if (update && !keepaxes && testlock_running (TDNAME) == 0) {
+	    fprintf (stderr, "%s: -w changes the axes, stop %s first or use -g\n",
+								me, TDNAME);
+	    exit (1);
+	}
+
+	if (tel_readmount (verbose, &tax0, minfo) < 0) {
+	    fprintf (stderr, "%s: can not read mount model\n", me);
+	    exit (1);
+	}
+
+	for (; ac > 0; ac--, av++)
+	    if (readLog (*av) < 0)
+		exit (1);
+	if (nstars < MINSTARS || nstars < nfolds) {
+	    fprintf (stderr, "%s: need at least %d stars\n", me,
+				    nfolds > MINSTARS ? nfolds : MINSTARS);
+	    exit (1);
+	}
+
+	/* deal the stars into folds at random, but the same each time */
+	srand48 (1);
+	for (i = 0; i < nstars; i++)
+	    stars[i].fold = i % nfolds;
+	for (i = nstars - 1; i > 0; i--) {
+	    int k = (int)(drand48()*(i+1)), t = stars[i].fold;
+	    stars[i].fold = stars[k].fold;
+	    stars[k].fold = t;
+	}
+
+	/* the whole solution and each fold */
+	jobs = (Job *) calloc (nfolds+1, sizeof(Job));
+	if (!jobs) {
+	    fprintf (stderr, "%s: no memory\n", me);
+	    exit (1);
+	}
+	for (i = 0; i <= nfolds; i++) {
+	    jobs[i].fold = i - 1;
+	    jobs[i].in = (char *) malloc (nstars);
+	    if (!jobs[i].in) {
+		fprintf (stderr, "%s: no memory\n", me);
+		exit (1);
+	    }
+	}
+	jp = &jobs[0];
+	solveJob (jp, NULL);
+	(void) ws_run (nthr, nfolds, 1, jobWork, NULL);
+
+	if (!jp->ok)
+	    fprintf (stderr, "%s: axes did not settle, check the logs\n", me);
+
+	/* pick the PTGRAD that did best on stars it had not seen */
+	for (j = 0; j < NRADII; j++)
+	    cvss[j] = 0;
+	for (i = 1; i <= nfolds; i++) {
+	    cvn += jobs[i].nheld;
+	    cvgss += jobs[i].gss;
+	    for (j = 0; j < NRADII; j++)
+		cvss[j] += jobs[i].mss[j];
+	}
+	best = 0;
+	for (j = 1; j < NRADII; j++)
+	    if (cvss[j] < cvss[best])
+		best = j;
+
+	/* what the logs said, on sky */
+	for (i = 0; i < nstars; i++) {
+	    double dha, ddec, e;
+
+	    starErr (&tax0, &stars[i], &dha, &ddec);
+	    e = skyErr (dha, ddec, stars[i].D);
+	    lss += e*e;
+	}
+
+	/* report */
+	old[0] = tax0.HT; old[1] = tax0.DT; old[2] = tax0.XP;
+	old[3] = tax0.YC; old[4] = tax0.NP;
+	new[0] = jp->tax.HT; new[1] = jp->tax.DT; new[2] = jp->tax.XP;
+	new[3] = jp->tax.YC; new[4] = jp->tax.NP;
+	printf ("%d stars, %d left out beyond %.1f arcsec\n", nstars,
+				nstars - jp->nin, raddeg(jp->lim)*3600);
+	printf ("     %12s %12s %10s\n", "was, rads", "now, rads", "arcsec");
+	for (i = 0; i < 5; i++)
+	    printf ("%-4s %12.7f %12.7f %10.1f\n", names[i], old[i], new[i],
+						raddeg(new[i]-old[i])*3600);
+	printf ("rms arcsec: logged %.1f, axes %.1f, axes on unseen stars %.1f\n",
+			raddeg(sqrt(lss/nstars))*3600, raddeg(jp->rms)*3600,
+			cvn ? raddeg(sqrt(cvgss/cvn))*3600 : 0.0);
+	printf ("with mesh on unseen stars:\n");
+	printf ("  PTGRAD, degs   rms arcsec\n");
+	for (j = 0; j < NRADII; j++)
+	    printf ("  %12.1f %12.1f%s\n", radii[j],
+			cvn ? raddeg(sqrt(cvss[j]/cvn))*3600 : 0.0,
+			j == best ? "  <" : "");
+
+	/* the mesh */
+	npt = makeMesh (jp, &pt);
+	if (npt < 0) {
+	    fprintf (stderr, "%s: no memory for mesh\n", me);
+	    exit (1);
+	}
+	if (meshout && writeText (meshout, pt, npt) < 0) {
+	    fprintf (stderr, "%s: %s\n", meshout, strerror(errno));
+	    exit (1);
+	}
+	if (update && writeAll (jp, pt, npt, degrad(radii[best])) < 0)
+	    exit (1);
+
+	free ((void *)pt);
+	return (jp->ok ? 0 : 1);
+}
+
+static void
+usage()
+{
+	fprintf(stderr,"Usage: %s [options] log ...\n", me);
+	fprintf(stderr,"Purpose: solve the mount axes and mesh from pointing logs\n");
+	fprintf(stderr,"Each log line: HA hrs, Dec degs, as placed by home.cfg with no mesh,\n");
+	fprintf(stderr,"  then HA (polar angle) and Dec of that less where it really was,\n");
+	fprintf(stderr,"  arc mins; as %s\n", meshfn);
+	fprintf(stderr,"Options:\n");
+	fprintf(stderr," -c n:    leave out stars n times the median error; default %g\n", DEFCLIP);
+	fprintf(stderr," -g:      keep the axes of home.cfg, just make the mesh\n");
+	fprintf(stderr," -j n:    threads; default one per cpu\n");
+	fprintf(stderr," -k n:    cross-validation folds; default %d\n", DEFFOLDS);
+	fprintf(stderr," -m file: write the text mesh to file\n");
+	fprintf(stderr," -w:      add the axes to home.cfg and PTGRAD to telsched.cfg,\n");
+	fprintf(stderr,"          write telescoped.mesh and telescoped.mbin;\n");
+	fprintf(stderr,"          not while %s runs unless -g\n", TDNAME);
+	fprintf(stderr," -v:      verbose\n");
+	exit (1);
+}
+
+/* add the stars of the log fn to stars[].
+ * return 0 if ok, else -1.
+ */
+static int
+readLog (char *fn)
+{
+	TMPoint *pt;
+	Star *newstars;
+	int n, i;
+
+	n = tmReadText (fn, &pt, (TMPrFp) warn);
+	if (n < 0) {
+	    fprintf (stderr, "%s: %s\n", fn, strerror(errno));
+	    return (-1);
+	}
+	newstars = (Star *) realloc ((void *)stars, (nstars+n)*sizeof(Star));
+	if (!newstars) {
+	    fprintf (stderr, "%s: no memory\n", fn);
+	    free ((void *)pt);
+	    return (-1);
+	}
+	stars = newstars;
+
+	/* put back the encoder values the scope had, as telescoped would */
+	for (i = 0; i < n; i++) {
+	    Star *sp = &stars[nstars+i];
+	    TelAxes tax = tax0;
+	    double x, y;
+
+	    tel_hadec2xy (pt[i].ha, pt[i].dec, &tax, &x, &y);
+	    tel_ideal2realxy (&tax, &x, &y);
+	    sp->X = x;
+	    sp->Y = y;
+	    sp->flip = tax.GERMEQ_FLIP;
+	    sp->H = pt[i].ha - pt[i].dha;
+	    sp->D = pt[i].dec - pt[i].ddec;
+	}
+
+	if (verbose)
+	    fprintf (stderr, "%s: %d stars\n", fn, n);
+	nstars += n;
+	free ((void *)pt);
+	return (0);
+}
+
+/* ws_run() function to do the folds [lo,hi) */
+static void
+jobWork (void *arg, int lo, int hi)
+{
+	for (; lo < hi; lo++) {
+	    solveJob (&jobs[lo+1], &jobs[0]);
+	    heldOut (&jobs[lo+1]);
+	}
+}
+
+/* solve jp->tax from all stars not in jp->fold, leaving out those beyond
+ * clip times the median error and solving again until few change.
+ * start from the stars and axes of *from, if any, else all and tax0.
+ */
+static void
+solveJob (Job *jp, Job *from)
+{
+	double *H, *D, *X, *Y, *fitp, *err;
+	int *F;
+	int i, n, round;
+
+	H = (double *) malloc (6*nstars*sizeof(double));
+	F = (int *) malloc (nstars*sizeof(int));
+	if (!H || !F) {
+	    fprintf (stderr, "%s: no memory\n", me);
+	    exit (1);
+	}
+	D = H + nstars;
+	X = D + nstars;
+	Y = X + nstars;
+	fitp = Y + nstars;
+	err = fitp + nstars;
+
+	jp->tax = from ? from->tax : tax0;
+	jp->ok = 1;
+	for (i = 0; i < nstars; i++)
+	    jp->in[i] = stars[i].fold != jp->fold && (!from || from->in[i]);
+
+	for (round = 0; round < MAXCLIP; round++) {
+	    int nchg = 0;
+
+	    for (n = i = 0; i < nstars; i++) {
+		if (!jp->in[i])
+		    continue;
+		H[n] = stars[i].H;
+		D[n] = stars[i].D;
+		X[n] = stars[i].X;
+		Y[n] = stars[i].Y;
+		F[n] = stars[i].flip;
+		n++;
+	    }
+	    if (!keepaxes)
+		jp->ok = tel_solve_axes (H, D, X, Y, F, n, FTOL, &jp->tax,
+								fitp) == 0;
+
+	    /* errors of all we may use, and the median of those we did */
+	    for (n = i = 0; i < nstars; i++) {
+		double dha, ddec;
+
+		if (stars[i].fold == jp->fold)
+		    continue;
+		starErr (&jp->tax, &stars[i], &dha, &ddec);
+		err[i] = skyErr (dha, ddec, stars[i].D);
+		if (jp->in[i])
+		    fitp[n++] = err[i];
+	    }
+	    jp->lim = clip*median (fitp, n);
+
+	    for (i = 0; i < nstars; i++) {
+		int in;
+
+		if (stars[i].fold == jp->fold)
+		    continue;
+		in = err[i] <= jp->lim;
+		if (in != jp->in[i]) {
+		    jp->in[i] = in;
+		    nchg++;
+		}
+	    }
+	    if (verbose > 1)
+		fprintf (stderr, "fold %d round %d: %d stars, %d changed\n",
+						    jp->fold, round, n, nchg);
+	    /* a few either way hardly move the axes */
+	    if (nchg <= n/MINCHG)
+		break;
+	}
+
+	jp->nin = 0;
+	jp->rms = 0;
+	for (i = 0; i < nstars; i++) {
+	    if (jp->in[i]) {
+		jp->rms += err[i]*err[i];
+		jp->nin++;
+	    }
+	}
+	if (jp->nin)
+	    jp->rms = sqrt(jp->rms/jp->nin);
+
+	free ((void *)H);
+	free ((void *)F);
+}
+
+/* find how well jp->tax, then with each mesh of the stars it used, does on
+ * the stars of jp->fold within jp->lim.
+ */
+static void
+heldOut (Job *jp)
+{
+	double r[NRADII], mdha[NRADII], mddec[NRADII];
+	TMPoint *pt;
+	TMesh mesh;
+	int i, j, n;
+
+	for (j = 0; j < NRADII; j++)
+	    r[j] = degrad(radii[j]);
+	n = makeMesh (jp, &pt);
+	if (n < 0 || tmBuild (pt, n, 0, &mesh) < 0) {
+	    fprintf (stderr, "%s: no memory for mesh\n", me);
+	    exit (1);
+	}
+	free ((void *)pt);
+
+	for (i = 0; i < nstars; i++) {
+	    Star *sp = &stars[i];
+	    double dha, ddec, e;
+
+	    if (sp->fold != jp->fold)
+		continue;
+	    starErr (&jp->tax, sp, &dha, &ddec);
+	    e = skyErr (dha, ddec, sp->D);
+	    if (e > jp->lim)
+		continue;
+	    jp->nheld++;
+	    jp->gss += e*e;
+	    tmInterpN (&mesh, NRADII, r, sp->H, sp->D, mdha, mddec);
+	    for (j = 0; j < NRADII; j++) {
+		e = skyErr (dha - mdha[j], ddec - mddec[j], sp->D);
+		jp->mss[j] += e*e;
+	    }
+	}
+
+	tmClose (&mesh);
+}
+
+/* find the mesh error of *sp with *tap, ie, where tap puts it less where it
+ * really was, rads. dha is a polar angle.
+ */
+static void
+starErr (TelAxes *tap, Star *sp, double *dhap, double *ddecp)
+{
+	TelAxes tax = *tap;
+	double x = sp->X, y = sp->Y;
+	double h, d;
+
+	tax.GERMEQ_FLIP = sp->flip;
+	tel_realxy2ideal (&tax, &x, &y);
+	tel_xy2hadec (x, y, &tax, &h, &d);
+	*dhap = h - sp->H;
+	haRange (dhap);
+	if (*dhap > PI)
+	    *dhap -= 2*PI;
+	*ddecp = d - sp->D;
+}
+
+/* return the size on sky of a small error dha and ddec at dec, rads */
+static double
+skyErr (double dha, double ddec, double dec)
+{
+	dha *= cos(dec);
+	return (sqrt(dha*dha + ddec*ddec));
+}
+
+/* return the median of v[n], which are put in order. */
+static double
+median (double *v, int n)
+{
+	if (n < 1)
+	    return (0.0);
+	qsort ((void *)v, n, sizeof(double), cmpDbl);
+	return (n & 1 ? v[n/2] : (v[n/2-1] + v[n/2])/2);
+}
+
+/* qsort-style function to compare 2 doubles */
+static int
+cmpDbl (const void *p1, const void *p2)
+{
+	double d = *(double *)p1 - *(double *)p2;
+
+	if (d < 0)
+	    return (-1);
+	if (d > 0)
+	    return (1);
+	return (0);
+}
+
+/* fill a new malloced *ptp with a mesh point at each star jp used, with
+ * what jp->tax leaves.
+ * return count, else -1 if no memory.
+ */
+static int
+makeMesh (Job *jp, TMPoint **ptp)
+{
+	TMPoint *pt;
+	int i, n;
+
+	pt = (TMPoint *) malloc ((jp->nin ? jp->nin : 1)*sizeof(TMPoint));
+	if (!pt)
+	    return (-1);
+	for (n = i = 0; i < nstars; i++) {
+	    if (!jp->in[i])
+		continue;
+	    pt[n].ha = stars[i].H;
+	    pt[n].dec = stars[i].D;
+	    starErr (&jp->tax, &stars[i], &pt[n].dha, &pt[n].ddec);
+	    n++;
+	}
+
+	*ptp = pt;
+	return (n);
+}
+
+/* write pt[n] to fn as a text mesh.
+ * return 0 if ok, else -1 with errno set.
+ */
+static int
+writeText (char *fn, TMPoint *pt, int n)
+{
+	FILE *fp;
+	int i;
+
+	fp = fopen (fn, "w");
+	if (!fp)
+	    return (-1);
+	fprintf (fp, "# made by %s from %d stars\n", me, nstars);
+	for (i = 0; i < n; i++) {
+	    double ha = pt[i].ha;
+
+	    range (&ha, 2*PI);
+	    fprintf (fp, "%9.6f %10.6f %10.6f %10.6f\n", radhr(ha),
+			raddeg(pt[i].dec), raddeg(pt[i].dha)*60,
+			raddeg(pt[i].ddec)*60);
+	}
+	if (fclose (fp) < 0)
+	    return (-1);
+	return (0);
+}
+
+/* add the axes of jp to home.cfg, write the mesh pt[n] to telescoped.mesh
+ * and telescoped.mbin, then ptgrad to telsched.cfg. in that order so the
+ * binary is never the older, and PTGRAD never goes with the wrong mesh.
+ * return 0 if ok, else -1.
+ */
+static int
+writeAll (Job *jp, TMPoint *pt, int n, double ptgrad)
+{
+	static char *names[5] = {"HT", "DT", "XP", "YC", "NP"};
+	double v[5];
+	char path[1024], valu[64];
+	unsigned gen = 1;
+	int LARGEXP = 0;
+	TMesh mesh;
+	int i;
+
+	v[0] = jp->tax.HT;
+	v[1] = jp->tax.DT;
+	v[2] = jp->tax.XP;
+	v[3] = jp->tax.YC;
+	v[4] = jp->tax.NP;
+
+	/* undo what tel_readmount() does for LARGEXP */
+	(void) read1CfgEntry (0, hcfn, "LARGEXP", CFG_INT, &LARGEXP, 0);
+	if (LARGEXP) {
+	    v[0] += PI/2;
+	    v[2] -= PI/2;
+	}
+
+	if (!keepaxes) {
+	    for (i = 0; i < 5; i++) {
+		sprintf (valu, "%.7f", v[i]);
+		if (writeCfgFile (hcfn, names[i], valu, NULL) < 0) {
+		    fprintf (stderr, "%s: %s\n", hcfn, strerror(errno));
+		    return (-1);
+		}
+	    }
+	}
+	telfixpath (path, meshfn);
+	if (writeText (path, pt, n) < 0) {
+	    fprintf (stderr, "%s: %s\n", path, strerror(errno));
+	    return (-1);
+	}
+
+	telfixpath (path, mbinfn);
+	if (tmOpen (path, &mesh) == 0) {
+	    gen = mesh.hp->gen + 1;
+	    tmClose (&mesh);
+	}
+	if (tmBuild (pt, n, gen, &mesh) < 0 || tmWrite (path, &mesh) < 0) {
+	    fprintf (stderr, "%s: %s\n", path, strerror(errno));
+	    return (-1);
+	}
+	tmClose (&mesh);
+
+	/* last, so a reload never sees the new PTGRAD with the old mesh */
+	sprintf (valu, "%.4f", ptgrad);
+	if (writeCfgFile (tscfn, "PTGRAD", valu, NULL) < 0) {
+	    fprintf (stderr, "%s: %s\n", tscfn, strerror(errno));
+	    return (-1);
+	}
+
+	if (verbose)
+	    fprintf (stderr, "wrote %s, %s, %s and %s, generation %u\n",
+			basenm(hcfn), basenm(tscfn), basenm(meshfn),
+			basenm(mbinfn), gen);
+	return (0);
+}
+
+/* report a bad line in a log */
+static void
+warn (char *fmt, ...)
+{
+	va_list ap;
+
+	va_start (ap, fmt);
+	vfprintf (stderr, fmt, ap);
+	va_end (ap);
+	fprintf (stderr, "\n");
+}
@@ -0,0 +1,423 @@
+/* order a queue of targets to keep the total time spent slewing short.
+ *
+ * slew times come from tel_slewtime(), using the mount kinematics, flip and
+ * limits from telescoped.cfg and home.cfg. all targets are placed as of one
+ * time, so this is meant for queues that are worked through in much less
+ * time than it takes the sky to turn appreciably.
+ *
+ * the order is found by building a number of candidate tours, each a
+ * nearest-neighbour walk from the start position, all but the first with
+ * some random choices of second-nearest, then each improved with 2-opt.
+ * the candidates are independent so they are spread over all cpus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "P_.h"
+#include "astro.h"
+#include "circum.h"
+#include "configfile.h"
+#include "misc.h"
+#include "strops.h"
+#include "telenv.h"
+#include "telstatshm.h"
+#include "wspool.h"
+
+#define	MAXLINE		1024		/* longest .edb line */
+#define	MAXTARG		10000		/* max targets, for the cost matrix */
+#define	DEFCANDS	32		/* default candidate tours */
+#define	PSECOND		0.2		/* chance of taking 2nd nearest */
+
+typedef struct {
+    char name[MAXNM];			/* target name */
+    double x, y;			/* axis positions, rads */
+} Target;
+
+typedef struct {
+    int *order;				/* [nt] visiting order */
+    double cost;			/* total secs */
+} Tour;
+
+static void usage (void);
+static void readSite (Now *np);
+static int loadTargets (Now *np, char *fn);
+static void costWork (void *arg, int lo, int hi);
+static void tourWork (void *arg, int lo, int hi);
+static void nearest (int *order, unsigned int seed);
+static void twoOpt (int *order);
+static double tourCost (int *order);
+
+static char tscfn[] = "archive/config/telsched.cfg";
+
+static char *me;			/* our name, for usage */
+static int verbose;			/* more chatter */
+static TelAxes tax;			/* mount model */
+static MotorInfo minfo[TEL_NM];		/* axis kinematics and limits */
+static double settle;			/* secs added to each slew */
+
+static Target *targ;			/* targets, then start as [nt] */
+static int nt;				/* n targets, not counting start */
+static float *cost;			/* [nt+1][nt+1] slew secs */
+static Tour *tours;			/* candidates */
+
+#define	C(i,j)	cost[(size_t)(i)*(nt+1) + (j)]
+
+int
+main (int ac, char *av[])
+{
+	int nthr = (int) sysconf (_SC_NPROCESSORS_ONLN);
+	int ncands = DEFCANDS;
+	double x0 = 0, y0 = 0;
+	double t = 0;
+	Now now, *np = &now;
+	Tour *best;
+	double tot;
+	char *str;
+	int i;
+
+	me = basenm(av[0]);
+
+	/* crack arguments */
+	for (av++; --ac > 0 && *(str = *av) == '-'; av++) {
+	    char c;
+	    while ((c = *++str) != '\0')
+		switch (c) {
+		case 'd':	/* MJD of queue start */
+		    if (ac < 2)
+			usage();
+		    t = atof(*++av) + 2400000.5 - MJD0;
+		    ac--;
+		    break;
+		case 'j':	/* n threads */
+		    if (ac < 2)
+			usage();
+		    nthr = atoi(*++av);
+		    ac--;
+		    break;
+		case 'k':	/* n candidate tours */
+		    if (ac < 2)
+			usage();
+		    ncands = atoi(*++av);
+		    ac--;
+		    break;
+		case 's':	/* start axis positions */
+		    if (ac < 2)
+			usage();
+		    if (sscanf (*++av, "%lf,%lf", &x0, &y0) != 2)
+			usage();
+		    x0 = degrad(x0);
+		    y0 = degrad(y0);
+		    ac--;
+		    break;
+		case 'w':	/* settle time */
+		    if (ac < 2)
+			usage();
+		    settle = atof(*++av);
+		    ac--;
+		    break;
+		case 'v':
+		    verbose++;
+		    break;
+		default:
+		    usage();
+		}
+	}
+
+	/* now there are ac remaining args starting at av[0] */
+	if (ac != 1 || ncands < 1)
+	    usage();
+	if (nthr < 1)
+	    nthr = 1;
+
+	readSite (np);
+	mjd = t ? t : mjd_now();
+	if (tel_readmount (verbose, &tax, minfo) < 0) {
+	    fprintf (stderr, "%s: can not read mount model\n", me);
+	    exit (1);
+	}
+	if (minfo[TEL_HM].maxvel <= 0 || minfo[TEL_HM].maxacc <= 0
+		    || minfo[TEL_DM].maxvel <= 0 || minfo[TEL_DM].maxacc <= 0) {
+	    fprintf (stderr, "%s: need [HD]MAXVEL and [HD]MAXACC in telescoped.cfg\n",
+									me);
+	    exit (1);
+	}
+
+	if (loadTargets (np, av[0]) < 0)
+	    exit (1);
+	if (nt == 0) {
+	    fprintf (stderr, "%s: no reachable targets\n", me);
+	    exit (1);
+	}
+	targ[nt].x = x0;
+	targ[nt].y = y0;
+	strcpy (targ[nt].name, "<start>");
+
+	/* all slew times */
+	cost = (float *) malloc ((size_t)(nt+1)*(nt+1)*sizeof(float));
+	if (!cost) {
+	    fprintf (stderr, "%s: no memory for %d targets\n", me, nt);
+	    exit (1);
+	}
+	(void) ws_run (nthr, nt+1, 16, costWork, NULL);
+
+	/* candidate tours */
+	tours = (Tour *) calloc (ncands, sizeof(Tour));
+	if (!tours) {
+	    fprintf (stderr, "%s: no memory for tours\n", me);
+	    exit (1);
+	}
+	for (i = 0; i < ncands; i++) {
+	    tours[i].order = (int *) malloc (nt*sizeof(int));
+	    if (!tours[i].order) {
+		fprintf (stderr, "%s: no memory for tours\n", me);
+		exit (1);
+	    }
+	}
+	(void) ws_run (nthr, ncands, 1, tourWork, NULL);
+
+	best = &tours[0];
+	for (i = 1; i < ncands; i++)
+	    if (tours[i].cost < best->cost)
+		best = &tours[i];
+
+	/* report */
+	tot = 0;
+	for (i = 0; i < nt; i++) {
+	    int from = i ? best->order[i-1] : nt;
+	    int to = best->order[i];
+	    double s = C(from,to) + settle;
+
+	    tot += s;
+	    printf ("%-*s %8.1f %9.1f\n", MAXNM, targ[to].name, s, tot);
+	}
+	if (verbose) {
+	    double given = settle*nt;
+
+	    for (i = 0; i < nt; i++)
+		given += C(i ? i-1 : nt, i);
+	    fprintf (stderr, "%d targets: given order %.1f s, best %.1f s\n",
+							    nt, given, tot);
+	}
+
+	return (0);
+}
+
+static void
+usage()
+{
+	fprintf(stderr,"Usage: %s [options] targets.edb\n", me);
+	fprintf(stderr,"Purpose: order targets to minimise total slew time\n");
+	fprintf(stderr,"Options:\n");
+	fprintf(stderr," -d mjd:  MJD of the queue start; default now\n");
+	fprintf(stderr," -j n:    threads; default one per cpu\n");
+	fprintf(stderr," -k n:    candidate tours; default %d\n", DEFCANDS);
+	fprintf(stderr," -s x,y:  start axis positions from home, degs; default 0,0\n");
+	fprintf(stderr," -w secs: settle time added to each slew; default 0\n");
+	fprintf(stderr," -v:      verbose\n");
+	exit (1);
+}
+
+/* fill in the site from telsched.cfg, just as telescoped does */
+static void
+readSite (Now *np)
+{
+#define NTSCFG  (sizeof(tscfg)/sizeof(tscfg[0]))
+	static double LONGITUDE, LATITUDE, TEMPERATURE, PRESSURE, ELEVATION;
+	static CfgEntry tscfg[] = {
+	    {"LONGITUDE",	CFG_DBL, &LONGITUDE},
+	    {"LATITUDE",	CFG_DBL, &LATITUDE},
+	    {"TEMPERATURE",	CFG_DBL, &TEMPERATURE},
+	    {"PRESSURE",	CFG_DBL, &PRESSURE},
+	    {"ELEVATION",	CFG_DBL, &ELEVATION},
+	};
+	int n;
+
+	n = readCfgFile (verbose, tscfn, tscfg, NTSCFG);
+	if (n != NTSCFG) {
+	    cfgFileError (tscfn, n, NULL, tscfg, NTSCFG);
+	    exit (1);
+	}
+
+	memset ((void *)np, 0, sizeof(*np));
+	lng = -LONGITUDE;		/* we want rads +E */
+	lat = LATITUDE;			/* we want rads +N */
+	temp = TEMPERATURE;		/* we want degrees C */
+	pressure = PRESSURE;		/* we want mB */
+	elev = ELEVATION/ERAD;		/* we want earth radii*/
+	epoch = EOD;
+#undef NTSCFG
+}
+
+/* read the targets in the .edb file fn and find their axis positions.
+ * those out of reach are skipped.
+ * return 0 if ok else -1.
+ */
+static int
+loadTargets (Now *np, char *fn)
+{
+	char line[MAXLINE], whynot[MAXLINE];
+	int maxt = 0;
+	FILE *fp;
+	Obj o;
+
+	fp = fopen (fn, "r");
+	if (!fp) {
+	    perror (fn);
+	    return (-1);
+	}
+
+	while (fgets (line, sizeof(line), fp)) {
+	    double ha, dec, x, y;
+
+	    memset ((void *)&o, 0, sizeof(o));
+	    if (db_crack_line (line, &o, whynot) < 0) {
+		if (whynot[0] && verbose)
+		    fprintf (stderr, "%s: %s\n", fn, whynot);
+		continue;
+	    }
+
+	    /* as telescoped finds where to point */
+	    (void) obj_cir (np, &o);
+	    aa_hadec (lat, o.s_alt, o.s_az, &ha, &dec);
+	    if (tel_slewxy (&tax, minfo, ha, dec, &x, &y) < 0) {
+		fprintf (stderr, "%s: %s is beyond the limits\n", fn, o.o_name);
+		continue;
+	    }
+
+	    if (nt == MAXTARG) {
+		fprintf (stderr, "%s: more than %d targets\n", fn, MAXTARG);
+		break;
+	    }
+	    if (nt+1 >= maxt) {
+		maxt = maxt ? 2*maxt : 256;
+		targ = (Target *) realloc ((char *)targ, maxt*sizeof(Target));
+		if (!targ) {
+		    fprintf (stderr, "%s: no memory for %d targets\n", me, maxt);
+		    exit (1);
+		}
+	    }
+	    strcpy (targ[nt].name, o.o_name);
+	    targ[nt].x = x;
+	    targ[nt].y = y;
+	    nt++;
+	}
+
+	fclose (fp);
+	return (0);
+}
+
+/* ws_run() function to fill rows [lo,hi) of the cost matrix */
+static void
+costWork (void *arg, int lo, int hi)
+{
+	int i, j;
+
+	for (i = lo; i < hi; i++)
+	    for (j = 0; j <= nt; j++)
+		C(i,j) = (float) tel_slewtime (minfo, targ[i].x, targ[i].y,
+							targ[j].x, targ[j].y);
+}
+
+/* ws_run() function to build candidate tours [lo,hi) */
+static void
+tourWork (void *arg, int lo, int hi)
+{
+	int k;
+
+	for (k = lo; k < hi; k++) {
+	    Tour *tp = &tours[k];
+
+	    nearest (tp->order, (unsigned int)k);
+	    twoOpt (tp->order);
+	    tp->cost = tourCost (tp->order);
+	}
+}
+
+/* fill order[] with a nearest-neighbour walk from the start.
+ * seed 0 always takes the nearest, others sometimes the second nearest.
+ */
+static void
+nearest (int *order, unsigned int seed)
+{
+	int i, j, n, at = nt;
+
+	for (i = 0; i < nt; i++)
+	    order[i] = i;
+
+	for (n = 0; n < nt; n++) {
+	    int b1 = -1, b2 = -1;
+
+	    /* unvisited are order[n..nt-1] */
+	    for (i = n; i < nt; i++) {
+		j = order[i];
+		if (b1 < 0 || C(at,j) < C(at,order[b1])) {
+		    b2 = b1;
+		    b1 = i;
+		} else if (b2 < 0 || C(at,j) < C(at,order[b2]))
+		    b2 = i;
+	    }
+	    if (seed && b2 >= 0 && rand_r(&seed) < PSECOND*RAND_MAX)
+		b1 = b2;
+
+	    j = order[b1];
+	    order[b1] = order[n];
+	    order[n] = j;
+	    at = j;
+	}
+}
+
+/* improve order[] in place by reversing stretches while that helps.
+ * the tour is open: it starts from the start position and ends anywhere.
+ */
+static void
+twoOpt (int *order)
+{
+	int better;
+
+	do {
+	    int i, j;
+
+	    better = 0;
+	    for (i = 0; i < nt-1; i++) {
+		int a = i ? order[i-1] : nt;
+		int b = order[i];
+
+		for (j = i+1; j < nt; j++) {
+		    int c = order[j];
+		    double d = C(a,c) - C(a,b);
+
+		    if (j < nt-1) {
+			int e = order[j+1];
+			d += C(b,e) - C(c,e);
+		    }
+		    if (d < -1e-3) {
+			int l, r;
+
+			for (l = i, r = j; l < r; l++, r--) {
+			    int tmp = order[l];
+			    order[l] = order[r];
+			    order[r] = tmp;
+			}
+			b = order[i];
+			better = 1;
+		    }
+		}
+	    }
+	} while (better);
+}
+
+/* total slew secs for order[], not counting settle */
+static double
+tourCost (int *order)
+{
+	double sum = 0;
+	int i;
+
+	for (i = 0; i < nt; i++)
+	    sum += C(i ? order[i-1] : nt, order[i]);
+	return (sum);
+}